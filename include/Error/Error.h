@@ -1,10 +1,16 @@
 #pragma once
+#include "frontend/SourceMap.h"
 #include "frontend/Token.h"
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/raw_ostream.h>
 
-static bool hadError = false;
-static bool hadRuntimeError = false;
+// 错误标记，使用 inline 变量保证所有翻译单元共享同一份；
+// 模块在工作线程上并行扫描和解析，每个线程各有一份，互不干扰
+inline thread_local bool hadError = false;
+inline thread_local bool hadRuntimeError = false;
+// 错误信息的输出流，为空时输出到标准错误；服务模式中每个请求把错误信息收集到自己的缓冲区
+inline thread_local llvm::raw_ostream *diagnostics = nullptr;
+inline llvm::raw_ostream &diagnosticStream() { return diagnostics != nullptr ? *diagnostics : llvm::errs(); }
 /**
  * @brief 报告错误信息到标准输出，并标记程序存在错误。
  * 
@@ -15,8 +21,8 @@ static bool hadRuntimeError = false;
  * @param where 错误发生的具体位置描述，如具体的词法单元。
  * @param message 详细的错误消息，描述错误的具体情况。
  */
-static void report(const long unsigned int line, const std::string_view where, const std::string_view message) {
-    llvm::errs() << "[line " << line << "] Error" << where << ": " << message << "\n";
+inline void report(const long unsigned int line, const std::string_view where, const std::string_view message) {
+    diagnosticStream() << "[line " << line << "] Error" << where << ": " << message << "\n";
     hadError = true;
 }
 
@@ -29,8 +35,8 @@ static void report(const long unsigned int line, const std::string_view where, c
  * @param line 错误发生的行号，用于定位错误在源代码中的位置。
  * @param message 详细的错误消息，描述错误的具体情况。
  */
-static void loxerror(const long unsigned int line, const std::string_view message) { report(line, "", message); }
-static void error(const long unsigned int line, const std::string_view message) { report(line, "", message); }
+inline void loxerror(const long unsigned int line, const std::string_view message) { report(line, "", message); }
+inline void error(const long unsigned int line, const std::string_view message) { report(line, "", message); }
 /**
  * @brief 报告与特定词法单元相关的错误。
  * 
@@ -41,14 +47,14 @@ static void error(const long unsigned int line, const std::string_view message)
  * @param token 与错误相关的词法单元，包含了错误发生位置的信息。
  * @param message 详细的错误消息，描述错误的具体情况。
  */
-static void loxerror(const Token &token, const std::string_view message) {
+inline void loxerror(const Token &token, const std::string_view message) {
     if (token.getType() == LoxEOF) {
         report(token.getLine(), " at end", message);
     } else {
         report(token.getLine(), " at '" + std::string(token.getLexeme()) + "'", message);
     }
 }
-static void error(const Token &token, const std::string_view message) {
+inline void error(const Token &token, const std::string_view message) {
     if (token.getType() == LoxEOF) {
         report(token.getLine(), " at end", message);
     } else {
@@ -56,14 +62,33 @@ static void error(const Token &token, const std::string_view message) {
     }
 }
 
+/**
+ * @brief 报告与 AST 中某个源码位置相关的错误。
+ *
+ * 行号和词素从 SourceMap 侧表中取出，只有在真正报错时才会访问侧表。
+ *
+ * @param loc 错误发生的源码位置下标。
+ * @param message 详细的错误消息，描述错误的具体情况。
+ */
+inline void error(const SourceLoc loc, const std::string_view message) {
+    const auto location = SourceMap::instance().lookup(loc);
+    report(location.line, " at '" + std::string(location.lexeme) + "'", message);
+}
+inline void error(const Identifier &name, const std::string_view message) { error(name.getLoc(), message); }
 
+
+/**
+ * @brief 运行时错误，只携带 32 位的源码位置下标。
+ */
 struct runtime_error final : std::runtime_error {
-    Token token;
-    explicit runtime_error(const Token &token, const std::string &message)
-        : std::runtime_error(message), token{token} {}
+    SourceLoc loc;
+    explicit runtime_error(const SourceLoc loc, const std::string &message) : std::runtime_error(message), loc{loc} {}
+    explicit runtime_error(const Identifier &name, const std::string &message)
+        : std::runtime_error(message), loc{name.getLoc()} {}
 };
 
-static void runtimeError(const runtime_error &error) {
-    llvm::errs() << error.what() << "\n[line " << error.token.getLine() << "]";
+inline void runtimeError(const runtime_error &error) {
+    const auto location = SourceMap::instance().lookup(error.loc);
+    diagnosticStream() << error.what() << "\n[line " << location.line << ", column " << location.column << "]\n";
     hadRuntimeError = true;
 }
\ No newline at end of file
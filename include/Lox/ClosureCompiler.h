@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Lox/Interpreter.h"
+#include "frontend/Ast.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 编译后的表达式：以解释器为参数调用即求值。
+ *
+ * 闭包不捕获解释器，编译结果保存在 AST 上，可以被多个解释器共用。
+ */
+using CompiledExpr = std::function<LoxObject(Interpreter &)>;
+
+/**
+ * @brief 编译后的语句：以解释器为参数调用即执行。
+ */
+using CompiledStmt = std::function<StmtResult(Interpreter &)>;
+
+/**
+ * @brief 编译后的语句块，也用于保存函数体和整个程序。
+ */
+struct CompiledBlock {
+    std::vector<CompiledStmt> statements;
+};
+
+/**
+ * @brief 闭包编译器：把解析后的 AST 一次性转换为闭包树。
+ *
+ * 每个闭包在编译时就绑定了子节点的闭包、Resolver 算出的变量距离和常量操作数，
+ * 执行时不再经过 std::visit 分派，也不再重复检查 AST 节点的变体标签。
+ * 二元和一元运算按运算符分别生成闭包，数字操作数走内联的快路径，其余情况交给 Interpreter 的共用实现。
+ *
+ * 必须在 Resolver 之后使用。闭包持有语句节点的智能指针，表达式闭包只拷贝节点中的名字、距离等常量，
+ * 执行时由调用方传入解释器。
+ */
+class ClosureCompiler {
+public:
+    /**
+     * @brief 编译整个程序或一个语句列表
+     *
+     * @param statements 语句列表
+     * @return std::shared_ptr<CompiledBlock> 编译后的语句块
+     */
+    std::shared_ptr<CompiledBlock> compile(const StmtList &statements);
+
+    /**
+     * @brief 编译一个表达式
+     *
+     * @param expr 表达式
+     * @return CompiledExpr 编译后的表达式
+     */
+    CompiledExpr compile(const Expr &expr);
+
+    /**
+     * @brief 编译一条语句
+     *
+     * @param stmt 语句
+     * @return CompiledStmt 编译后的语句
+     */
+    CompiledStmt compile(const Stmt &stmt);
+
+    CompiledStmt operator()(const ExpressionStmtPtr &expressionStmt);
+    CompiledStmt operator()(const IfStmtPtr &ifStmt);
+    CompiledStmt operator()(const PrintStmtPtr &printStmt);
+    CompiledStmt operator()(const VarStmtPtr &varStmt);
+    CompiledStmt operator()(const FunctionStmtPtr &functionStmt);
+    CompiledStmt operator()(const ReturnStmtPtr &returnStmt);
+    CompiledStmt operator()(const BlockStmtPtr &blockStmt);
+    CompiledStmt operator()(const WhileStmtPtr &whileStmt);
+    CompiledStmt operator()(const ForStmtPtr &forStmt);
+    CompiledStmt operator()(const ClassStmtPtr &classStmt);
+    CompiledStmt operator()(const TryStmtPtr &tryStmt);
+    CompiledStmt operator()(const ImportStmtPtr &importStmt);
+    CompiledExpr operator()(const BinaryExprPtr &binaryExpr);
+    CompiledExpr operator()(const CallExprPtr &callExpr);
+    CompiledExpr operator()(const GetExprPtr &getExpr);
+    CompiledExpr operator()(const SetExprPtr &setExpr);
+    CompiledExpr operator()(const ThisExprPtr &thisExpr);
+    CompiledExpr operator()(const SuperExprPtr &superExpr);
+    CompiledExpr operator()(const GroupingExprPtr &groupingExpr);
+    CompiledExpr operator()(const LiteralExprPtr &literalExpr);
+    CompiledExpr operator()(const LogicalExprPtr &logicalExpr);
+    CompiledExpr operator()(const UnaryExprPtr &unaryExpr);
+    CompiledExpr operator()(const VarExprPtr &varExpr);
+    CompiledExpr operator()(const AssignExprPtr &assignExpr);
+    CompiledExpr operator()(const InterpolationExprPtr &interpolationExpr);
+
+private:
+    /**
+     * @brief 编译函数体并保存到 FunctionStmt 上，LoxFunction 调用时直接执行编译结果
+     *
+     * @param functionStmt 函数声明
+     */
+    void compileFunction(const FunctionStmtPtr &functionStmt);
+
+    /**
+     * @brief 为指定的二元运算符生成闭包
+     *
+     * @tparam Op 二元运算符
+     * @param left 编译后的左操作数
+     * @param right 编译后的右操作数
+     * @param loc 运算符的源码位置
+     * @return CompiledExpr 编译后的二元表达式
+     */
+    template<BinaryOp Op>
+    CompiledExpr binary(CompiledExpr left, CompiledExpr right, SourceLoc loc);
+};
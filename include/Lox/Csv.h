@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Lox/LoxObject.h"
+#include "Lox/LoxString.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief CSV 中的一个字段
+ *
+ * 带引号的字段去掉了两端的引号；其中的 "" 转义只在 escaped 为真时存在，需要 unescape 后才是真正的内容。
+ */
+struct CsvField {
+    std::string_view text;
+    bool escaped = false;
+};
+
+/**
+ * @brief 逐行切分 CSV 文本的游标（RFC 4180，逗号分隔）
+ *
+ * 没有引号的行（绝大多数行）先用 memchr 找到换行，再用 memchr 按逗号切分，两者在 glibc 中都有 SIMD 实现；
+ * 只有出现引号的行才逐个字段处理，带引号的字段可以包含逗号和换行。字段都是输入的视图，不复制字符。
+ */
+class CsvCursor {
+public:
+    explicit CsvCursor(LoxString text) : text{std::move(text)} {}
+
+    /**
+     * @brief 读取下一行，跳过空行
+     *
+     * @param fields 输出的字段，原有内容会被清空
+     * @return bool 是否读到了一行，到达末尾或格式错误时为 false，两者用 error() 区分
+     */
+    bool nextRow(std::vector<CsvField> &fields);
+
+    /**
+     * @brief 格式错误的信息，没有错误时为空
+     */
+    [[nodiscard]] const std::string &error() const { return message; }
+
+    /**
+     * @brief 将字段转换为 Lox 字符串：不含转义的字段与输入共享缓冲区，否则复制一份去掉转义的内容
+     */
+    [[nodiscard]] LoxString toString(const CsvField &field) const;
+
+    /**
+     * @brief 已经读取的行数，用于错误信息
+     */
+    [[nodiscard]] std::size_t rowNumber() const { return rows; }
+
+private:
+    LoxString text;
+    // 下一行在 text 中的起始位置
+    std::size_t offset = 0;
+    std::size_t rows = 0;
+    std::string message;
+
+    // 从 offset 开始按带引号的规则切分一行，格式错误时返回 false
+    bool quotedRow(std::vector<CsvField> &fields);
+};
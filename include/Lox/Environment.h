@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Lox/LoxObject.h"
-#include "frontend/Token.h"
+#include "Utils/SlabAllocator.h"
+#include "frontend/SourceMap.h"
+#include <array>
 #include <unordered_map>
+
+// 每个环境的显示表保存的祖先层数
+static constexpr std::size_t DISPLAY_SIZE = 8;
 /**
  * @brief 前置声明 Environment 类
  * 
@@ -13,17 +18,17 @@ class Environment;
 /**
  * @brief 定义 Environment 类的智能指针类型
  * 
- * 使用 std::shared_ptr 来管理 Environment 对象的生命周期，方便内存管理和对象共享。
+ * 使用侵入式、非原子的引用计数管理 Environment 对象的生命周期，切换环境时不需要原子操作。
  */
-using EnvironmentPtr = std::shared_ptr<Environment>;
+using EnvironmentPtr = Ref<Environment>;
 
 /**
  * @brief 环境类，用于管理变量的定义和查找
  * 
- * 该类继承自 std::enable_shared_from_this，允许在类内部安全地获取指向自身的 std::shared_ptr。
+ * 该类继承自 RefCounted，可以直接从 this 构造指向自身的 EnvironmentPtr；每次调用和进入块都会创建环境，因此从 slab 池分配。
  * 它维护一个变量名到值的映射，并支持嵌套环境，通过 enclosing 指针指向外部环境。
  */
-class Environment : public std::enable_shared_from_this<Environment> {
+class Environment : public RefCounted<Environment>, public SlabAllocated<Environment> {
 private:
     /**
      * @brief 存储变量名到值的映射
@@ -38,6 +43,31 @@ private:
      * 用于实现嵌套环境，允许在当前环境中查找外部环境的变量。
      */
     EnvironmentPtr enclosing;
+
+    /**
+     * @brief 静态链的显示表（display）
+     * 
+     * display[i] 是距离当前环境 i + 1 层的祖先环境，只保存最近的 DISPLAY_SIZE 层。
+     * 创建环境时由外部环境的显示表右移一位得到，之后按 Resolver 算出的距离访问外层环境只需一次下标运算，
+     * 不再沿 enclosing 指针逐层查找；更远的环境每次跳过 DISPLAY_SIZE 层。
+     * 表的大小固定，创建环境时不需要额外分配内存。表中的裸指针由 enclosing 链保持存活，超出最外层的位置为空。
+     */
+    std::array<Environment *, DISPLAY_SIZE> display{};
+
+    /**
+     * @brief 通过显示表获取指定距离的祖先环境
+     * 
+     * @param distance 距离当前环境的层数
+     * @return Environment* 祖先环境
+     */
+    Environment *frameAt(unsigned long distance) {
+        Environment *environment = this;
+        while (distance > DISPLAY_SIZE) [[unlikely]] {
+            environment = environment->display[DISPLAY_SIZE - 1];
+            distance -= DISPLAY_SIZE;
+        }
+        return distance == 0 ? environment : environment->display[distance - 1];
+    }
 public:
     /**
      * @brief 默认构造函数
@@ -54,6 +84,10 @@ public:
      */
     explicit Environment(EnvironmentPtr environment);
 
+    // 显示表保存了自身的地址，环境不能复制
+    Environment(const Environment &) = delete;
+    Environment &operator=(const Environment &) = delete;
+
     /**
      * @brief 获取外部环境
      * 
@@ -71,6 +105,27 @@ public:
      */
     void define(std::string_view name, const LoxObject &value = LoxNil{});
 
+    /**
+     * @brief 清空当前环境中的所有变量
+     * 
+     * 保留哈希表已分配的桶，供没有闭包捕获的循环体在迭代之间复用。
+     */
+    void clear() { values.clear(); }
+
+    /**
+     * @brief 删除当前环境中的一个变量，用于撤销失败的热重载
+     *
+     * @param name 变量名
+     */
+    void remove(const std::string_view name) { values.erase(name); }
+
+    /**
+     * @brief 获取当前环境中定义的所有变量，不包括外部环境
+     * 
+     * @return 变量名到值的映射
+     */
+    [[nodiscard]] const std::unordered_map<std::string_view, LoxObject> &variables() const { return values; }
+
     /**
      * @brief 在指定距离的祖先环境中获取变量
      * 
@@ -94,29 +149,30 @@ public:
      * @brief 获取变量的值
      * 
      * 在当前环境及其外部环境中查找并返回指定名称的变量。
-     * @param name 变量的 Token 对象
-     * @return 变量的引用
+     * @param name 变量名
+     * @return 指向变量的指针，变量未定义时为 nullptr
      */
-    LoxObject &get(const Token &name);
+    LoxObject *get(const Identifier &name);
 
     /**
      * @brief 为变量赋值
      * 
      * 在当前环境及其外部环境中查找指定名称的变量，并为其赋予新值。
-     * @param name 变量的 Token 对象
+     * @param name 变量名
      * @param value 新的值
+     * @return 变量已定义时返回 true，否则返回 false
      */
-    void assign(const Token &name, const LoxObject &value);
+    bool assign(const Identifier &name, const LoxObject &value);
 
     /**
      * @brief 在指定距离的祖先环境中为变量赋值
      * 
      * 在距离当前环境指定距离的祖先环境中查找指定名称的变量，并为其赋予新值。
      * @param distance 距离当前环境的距离
-     * @param name 变量的 Token 对象
+     * @param name 变量名
      * @param value 新的值
      */
-    void assignAt(unsigned long distance, const Token &name, const LoxObject &value);
+    void assignAt(unsigned long distance, const Identifier &name, const LoxObject &value);
 
 
 };
\ No newline at end of file
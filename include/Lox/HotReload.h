@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Lox/Interpreter.h"
+#include "frontend/ModuleLoader.h"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @brief 热重载（--watch）：监视正在运行的脚本和它导入的模块，把修改过的顶层函数和类换入运行中的解释器
+ *
+ * 监视线程用 inotify 监视文件所在的目录（编辑器常用先写临时文件再改名的方式保存），文件保存后重新扫描，
+ * 按花括号把顶层的 fun 和 class 声明切分出来，与上一个版本逐个比较源码文本，只解析和变量解析改动过或新增的声明，
+ * 再交给解释器在下一个安全点执行。其他顶层语句（变量、表达式）不会重新执行，删除的声明保留原来的定义。
+ */
+class HotReloader {
+public:
+    /**
+     * @brief 创建监视线程
+     *
+     * @param interpreter 接收重载的解释器，必须比 HotReloader 活得更久
+     */
+    explicit HotReloader(Interpreter &interpreter);
+
+    /**
+     * @brief 停止并等待监视线程
+     */
+    ~HotReloader();
+
+    HotReloader(const HotReloader &) = delete;
+    HotReloader &operator=(const HotReloader &) = delete;
+
+    /**
+     * @brief 开始监视一个模块（包括它直接和间接导入的模块），以它当前的源码作为比较的基准
+     *
+     * @param module 即将执行的模块
+     */
+    void watch(const Module &module);
+
+private:
+    // 一个被监视的文件
+    struct WatchedFile {
+        // 上一个版本中每个顶层声明的源码文本
+        std::unordered_map<std::string, std::string> declarations;
+    };
+
+    Interpreter &interpreter;
+    int inotifyFd = -1;
+    // 用于唤醒监视线程使其退出
+    int stopFd = -1;
+    std::mutex mutex;
+    // 按绝对路径索引的被监视文件，由 mutex 保护
+    std::unordered_map<std::string, WatchedFile> files;
+    // inotify 监视描述符到目录的映射，由 mutex 保护
+    std::unordered_map<int, std::string> directories;
+    std::thread thread;
+
+    // 监视线程的主循环
+    void run();
+    // 重新加载一个保存过的文件
+    void reload(const std::string &path);
+};
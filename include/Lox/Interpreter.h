@@ -1,23 +1,75 @@
 #pragma once
 
+#include "Error/Error.h"
 #include "Lox/Environment.h"
 #include "Lox/LoxObject.h"
+#include "Utils/PerfCounters.h"
 #include "frontend/Ast.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
+#include <vector>
 
 static int  MAX_CALL_DEPTH=100;
+// 启用时间或内存限制时，每隔多少个安全点检查一次时钟和堆大小
+static constexpr std::int64_t SAFEPOINT_INTERVAL = 4096;
+
+/**
+ * @brief 脚本执行预算，0 表示不限制。
+ *
+ * 指令数以安全点计：每次循环回边和每次函数调用各消耗一条指令。
+ */
+struct ExecutionLimits {
+    // 最多执行的指令数
+    std::uint64_t maxInstructions = 0;
+    // 堆内存上限（字节），按执行脚本的线程统计
+    std::size_t maxHeapBytes = 0;
+    // 墙钟时间上限
+    std::chrono::milliseconds timeout{0};
+};
+
+/**
+ * @brief 当前进程堆中已使用的字节数，运行时指标以它为准；堆预算按线程统计，见 Utils/HeapAccounting.h
+ */
+std::size_t heapInUse();
 struct Return {
-    LoxObject &value;
-    ~Return() = default;
-    // explicit Return(LoxObject &value) : value(value) {};
+    // 按值保存返回值，避免引用指向已销毁的局部变量
+    LoxObject value;
 };
 
 struct Nothing {};
-using StmtResult = std::variant<LoxObject, Return, Nothing>;
+
+/**
+ * @brief 语句因运行时错误而中止。
+ *
+ * 解释器内部不抛出 C++ 异常：出错时记录错误状态，语句返回 Unwind，
+ * 由外层的语句块、循环和函数调用逐层返回，直到程序入口再报告错误。
+ */
+struct Unwind {};
+using StmtResult = std::variant<LoxObject, Return, Nothing, Unwind>;
+
+/**
+ * @brief 执行引擎。
+ *
+ * TREE 直接遍历 AST；CLOSURE 先把解析后的 AST 编译为预先绑定好子节点、变量距离和常量的闭包树再执行。
+ */
+enum class ExecutionEngine { TREE, CLOSURE };
+
+struct CompiledBlock;
+class ClosureCompiler;
+class LoxFunction;
+class MetricsExporter;
 class Interpreter {
 public:
-    Interpreter();
-    ~Interpreter()=default;
+    explicit Interpreter(const ExecutionLimits &limits = {}, ExecutionEngine engine = ExecutionEngine::TREE);
+    /**
+     * @brief 清空全局环境：全局函数和类的闭包引用全局环境本身，不清空的话两者互相引用，永远不会释放
+     */
+    ~Interpreter();
     //void interpret(const std::vector<StmtPtr> &statements);
     StmtResult operator()(const ExpressionStmtPtr &expressionStmt);
     StmtResult operator()(const IfStmtPtr &ifStmtPtr);
@@ -27,19 +79,23 @@ public:
     StmtResult operator()(const ReturnStmtPtr &returnStmt);
     StmtResult operator()(const BlockStmtPtr &blockStmt);
     StmtResult operator()(const WhileStmtPtr &whileStmt);
+    StmtResult operator()(const ForStmtPtr &forStmt);
     StmtResult operator()(const ClassStmtPtr &classStmt);
+    StmtResult operator()(const TryStmtPtr &tryStmt);
+    StmtResult operator()(const ImportStmtPtr &importStmt);
     LoxObject operator()(const BinaryExprPtr &binaryExpr);
     LoxObject operator()(const CallExprPtr &callExpr);
     LoxObject operator()(const GetExprPtr &getExpr);
     LoxObject operator()(const SetExprPtr &setExpr);
-    LoxObject operator()(const ThisExprPtr &thisExpr) const;
-    LoxObject operator()(const SuperExprPtr &superExpr) const;
+    LoxObject operator()(const ThisExprPtr &thisExpr);
+    LoxObject operator()(const SuperExprPtr &superExpr);
     LoxObject operator()(const GroupingExprPtr &groupingExpr);
     LoxObject operator()(const LiteralExprPtr &literalExpr) const;
     LoxObject operator()(const LogicalExprPtr &logicalExpr);
     LoxObject operator()(const UnaryExprPtr &unaryExpr);
-    LoxObject operator()(const VarExprPtr &varExpr) const;
+    LoxObject operator()(const VarExprPtr &varExpr);
     LoxObject operator()(const AssignExprPtr &assignExpr);
+    LoxObject operator()(const InterpolationExprPtr &interpolationExpr);
 
        /**
      * @brief 计算表达式的值
@@ -70,6 +126,103 @@ public:
      */
     void evaluate(const Program &program);
 
+    /**
+     * @brief 执行整个程序，供嵌入方使用
+     *
+     * 与 evaluate(const Program &) 不同，该函数不直接打印错误，
+     * 而是在程序中止时把记录的错误状态转换为异常抛出。
+     *
+     * @param program 要执行的程序对象
+     * @throws runtime_error 如果程序执行过程中发生运行时错误
+     */
+    void execute(const Program &program);
+
+    /**
+     * @brief 以给定的参数调用一个全局函数，供嵌入方使用
+     *
+     * 与 execute 一样，出错时把记录的错误状态转换为异常抛出。
+     *
+     * @param name 全局函数名
+     * @param arguments 参数列表
+     * @return LoxObject 调用结果
+     * @throws runtime_error 如果找不到函数或调用过程中发生运行时错误
+     */
+    LoxObject callGlobal(const Identifier &name, const std::vector<LoxObject> &arguments);
+
+    /**
+     * @brief 重新设置执行预算，从调用时开始计算时间、指令数和堆的增长
+     *
+     * 服务模式中解释器提前创建，收到请求时才开始计算预算。
+     *
+     * @param limits 执行预算
+     */
+    void setLimits(const ExecutionLimits &limits);
+
+    /**
+     * @brief 设置 print 语句的输出流，默认为标准输出
+     *
+     * @param stream 输出流，必须比解释器活得更久
+     */
+    void setOutput(llvm::raw_ostream &stream) { output = &stream; }
+
+    /**
+     * @brief 设置按顶层函数统计硬件计数器的剖析器，为空时不统计
+     *
+     * @param profile 剖析器，必须比解释器活得更久
+     */
+    void setPerfProfile(PerfProfile *profile) { perf = profile; }
+
+    /**
+     * @brief 设置运行时指标导出，为空时不导出；之后每 SAFEPOINT_INTERVAL 个安全点检查一次是否需要采样
+     *
+     * @param exporter 导出器，必须比解释器活得更久，或在析构前重新设为空
+     */
+    void setMetricsExporter(MetricsExporter *exporter) { metrics = exporter; }
+
+    /**
+     * @brief 开启热重载：之后每 SAFEPOINT_INTERVAL 个安全点检查一次是否有提交的重载
+     */
+    void enableHotReload() { hotReload = true; }
+
+    /**
+     * @brief 设置中断标志：之后每 SAFEPOINT_INTERVAL 个安全点检查一次，标志置位后报告运行时错误并停止执行
+     *
+     * 与预算耗尽一样，中断之后的每个安全点都会再次报错，catch 块无法让脚本继续运行。
+     *
+     * @param flag 由其他线程（或信号处理函数）置位的标志，必须比解释器活得更久
+     */
+    void setInterrupt(const std::atomic<bool> *flag) { interrupt = flag; }
+
+    /**
+     * @brief 提交一组重新加载的顶层函数和类声明，可以在其他线程上调用
+     *
+     * 声明在下一个安全点上一次性执行：函数替换全局环境中的同名函数，同名的类原地替换父类和方法，
+     * 已有的实例仍然有效并立即使用新的方法。程序不会看到只替换了一部分的声明。
+     *
+     * @param declarations 已经完成变量解析的声明
+     */
+    void scheduleReload(std::shared_ptr<const Module> declarations);
+
+    /**
+     * @brief 记录一个运行时错误
+     *
+     * 只保留第一个错误，之后解释器沿调用栈逐层返回。
+     *
+     * @param loc 出错位置
+     * @param message 错误信息
+     * @return LoxObject 总是返回 nil，便于表达式求值直接 return raise(...)
+     */
+    LoxObject raise(SourceLoc loc, const std::string &message);
+
+    /**
+     * @brief 是否有尚未处理的运行时错误
+     *
+     * 每次求值子表达式或执行子语句后检查，为真时立即返回。
+     *
+     * @return bool 有错误时返回 true
+     */
+    [[nodiscard]] bool unwinding() const { return pendingError.has_value(); }
+
     /**
      * @brief 在新环境中执行语句块
      * 
@@ -81,62 +234,214 @@ public:
      */
     StmtResult executeBlock(const StmtList &statements, const EnvironmentPtr &newenvironment);
 
+    /**
+     * @brief 在新环境中执行编译后的语句块
+     * 
+     * 与 executeBlock 相同，只是语句已经由 ClosureCompiler 编译为闭包。
+     * 
+     * @param block 编译后的语句块
+     * @param newenvironment 执行语句的新环境
+     * @return StmtResult 语句块执行结果
+     */
+    StmtResult executeCompiled(const CompiledBlock &block, const EnvironmentPtr &newenvironment);
+
+    /**
+     * @brief 调用一个已经求值的被调用对象
+     * 
+     * @param loc 调用表达式的源码位置
+     * @param callee 被调用对象
+     * @param arguments 参数列表
+     * @return LoxObject 调用结果，出错时记录运行时错误并返回 nil
+     */
+    LoxObject call(SourceLoc loc, const LoxObject &callee, const std::vector<LoxObject> &arguments);
+
+    /**
+     * @brief 原生函数回调 Lox 函数的快速路径
+     * 
+     * 与 call 一样检查调用深度并消耗安全点，但跳过被调用对象和参数个数的检查（由 NativeCallback 构造时检查一次），
+     * 并在 frame 中复用上一次调用留下的、没有被捕获的环境。
+     * 
+     * @param loc 原生函数调用点的源码位置
+     * @param function 被调用的函数
+     * @param arguments 参数列表
+     * @param frame 调用方保存的环境
+     * @return LoxObject 调用结果，出错时记录运行时错误并返回 nil
+     */
+    LoxObject callFunction(SourceLoc loc, LoxFunction &function, const std::vector<LoxObject> &arguments, EnvironmentPtr &frame);
+
+    /**
+     * @brief 正在执行的原生函数的调用点，原生函数用它作为回调的位置
+     */
+    [[nodiscard]] SourceLoc currentCallSite() const { return callSite; }
+
+    /**
+     * @brief 在正在执行的原生函数的调用点上记录一个运行时错误
+     *
+     * 原生函数报告错误后直接返回 nil，由调用方检查 unwinding()。
+     *
+     * @param message 错误信息
+     * @return LoxObject 总是返回 nil
+     */
+    LoxObject nativeError(const std::string &message) { return raise(callSite, message); }
+
+    /**
+     * @brief 对两个已经求值的操作数执行二元运算
+     * 
+     * @param op 二元运算符
+     * @param loc 运算符的源码位置
+     * @param left 左操作数
+     * @param right 右操作数
+     * @return LoxObject 运算结果，出错时记录运行时错误并返回 nil
+     */
+    LoxObject binary(BinaryOp op, SourceLoc loc, const LoxObject &left, const LoxObject &right);
+
 private:
+    // 闭包编译器生成的闭包直接访问解释器的环境和错误状态
+    friend class ClosureCompiler;
+    // 指标导出在安全点上读取调用次数和全局环境
+    friend class MetricsExporter;
+
+    // 执行引擎
+    ExecutionEngine engine;
+    // print 语句的输出流
+    llvm::raw_ostream *output = &llvm::outs();
+    // 已经执行的热重载声明。函数引用其中的 AST，字符串字面量借用其中的文本，因此比全局环境晚析构
+    std::vector<std::shared_ptr<const Module>> reloaded;
     // 全局环境指针，初始化为一个新的环境
-    EnvironmentPtr globals = std::make_shared<Environment>();
+    EnvironmentPtr globals = make_ref<Environment>();
     // 当前环境指针，初始指向全局环境
     EnvironmentPtr environment = globals;
     // 函数调用深度计数器
     int function_depth = 0;
+    // 累计的函数调用次数
+    std::uint64_t calls = 0;
+    // 运行时指标导出，未开启时为空
+    MetricsExporter *metrics = nullptr;
+    // --perf-functions 的剖析器，不按函数统计时为空
+    PerfProfile *perf = nullptr;
+    // 正在执行的原生函数的调用点
+    SourceLoc callSite{};
+    // 已经在本解释器中执行过的模块，每个模块的顶层语句只执行一次
+    std::unordered_set<const Module *> importedModules;
+
+    // 尚未处理的运行时错误，为空表示正常执行
+    std::optional<runtime_error> pendingError;
+
+    // 执行预算
+    ExecutionLimits limits;
+    // 墙钟时间截止点，仅在设置了 timeout 时有效
+    std::chrono::steady_clock::time_point deadline;
+    // 设置预算时本线程的净分配字节数，仅在设置了 maxHeapBytes 时有效
+    std::int64_t heapBaseline = 0;
+    // 剩余指令数，不限制时为 UINT64_MAX
+    std::uint64_t instructionsLeft = UINT64_MAX;
+    // 本轮剩余的安全点数，减到 0 时进入 refuel 慢路径
+    std::int64_t fuel = INT64_MAX;
+    // 本轮开始时分配的安全点数
+    std::int64_t fuelSlice = INT64_MAX;
+    // 预算是否已经耗尽；耗尽后每个安全点都会再次报错，catch 块无法让脚本继续运行
+    bool exhausted = false;
+
+    // 中断标志，未设置时为空
+    const std::atomic<bool> *interrupt = nullptr;
+
+    // 是否开启了热重载
+    bool hotReload = false;
+    // 是否有等待执行的重载，监视线程写入，安全点读取
+    std::atomic<bool> reloadPending = false;
+    std::mutex reloadMutex;
+    // 等待执行的重载，由 reloadMutex 保护
+    std::vector<std::shared_ptr<const Module>> pendingReloads;
+
+    /**
+     * @brief 被调用的是顶层函数时通知剖析器进入该函数
+     *
+     * @return bool 是否进入了函数，是则调用结束后需要离开
+     */
+    bool enterProfiled(LoxCallable &callable);
+
+    /**
+     * @brief 在安全点上执行所有已提交的重载
+     */
+    void applyReloads();
+
+    /**
+     * @brief 安全点：在循环回边和函数调用处消耗一条指令
+     *
+     * 快路径只有一次减法和比较，本轮燃料用尽时才检查指令数、时间和堆大小。
+     *
+     * @param loc 安全点的源码位置
+     * @return bool 预算未耗尽时返回 true，否则记录运行时错误并返回 false
+     */
+    bool safepoint(const SourceLoc loc) {
+        if (--fuel > 0) [[likely]] { return true; }
+        return refuel(loc);
+    }
+
+    /**
+     * @brief 安全点慢路径：结算本轮消耗的指令并检查各项预算
+     *
+     * @param loc 安全点的源码位置
+     * @return bool 预算未耗尽时返回 true，否则记录运行时错误并返回 false
+     */
+    bool refuel(SourceLoc loc);
+
+    /**
+     * @brief 捕获当前的运行时错误
+     *
+     * @param name catch 变量名
+     * @return EnvironmentPtr 绑定了错误信息的 catch 块环境
+     */
+    EnvironmentPtr catchError(const Identifier &name);
 
     // std::unordered_map<std::string_view, LoxFunctionPtr> methods;
     /**
      * @brief 检查操作数是否为数字类型
      * 
-     * 该函数检查给定的操作数是否为 LoxNumber 类型，如果是则返回该操作数，否则抛出运行时错误。
+     * 该函数检查给定的操作数是否为 LoxNumber 类型，如果不是则记录运行时错误。
      * 
-     * @param op 操作符的 Token 对象
+     * @param op 操作符的源码位置
      * @param operand 要检查的操作数
-     * @return LoxNumber 如果操作数是 LoxNumber 类型，则返回该操作数
-     * @throws runtime_error 如果操作数不是 LoxNumber 类型
+     * @return bool 操作数是 LoxNumber 类型时返回 true
      */
-    static LoxNumber checkNumberOperand(const Token &op, const LoxObject &operand) {
+    bool checkNumberOperand(const SourceLoc op, const LoxObject &operand) {
         // 检查操作数是否为 LoxNumber 类型
-        if (std::holds_alternative<LoxNumber>(operand)) { return std::get<LoxNumber>(operand);
-}
-        // 若不是 LoxNumber 类型，抛出运行时错误
-        throw runtime_error(op, "Operand must be a number.");
+        if (std::holds_alternative<LoxNumber>(operand)) [[likely]] { return true; }
+        // 若不是 LoxNumber 类型，记录运行时错误
+        raise(op, "Operand must be a number.");
+        return false;
     }
 
     /**
      * @brief 检查操作数对是否都为数字类型
      * 
-     * 该函数检查给定的左右操作数是否都为 LoxNumber 类型，如果是则直接返回，否则抛出运行时错误。
+     * 该函数检查给定的左右操作数是否都为 LoxNumber 类型，如果不是则记录运行时错误。
      * 
-     * @param op 操作符的 Token 对象
+     * @param op 操作符的源码位置
      * @param left 左操作数
      * @param right 右操作数
-     * @throws runtime_error 如果左右操作数不全是 LoxNumber 类型
+     * @return bool 左右操作数都是 LoxNumber 类型时返回 true
      */
-    static void checkNumberOperands(const Token &op, const LoxObject &left, const LoxObject &right) {
+    bool checkNumberOperands(const SourceLoc op, const LoxObject &left, const LoxObject &right) {
         // 检查左右操作数是否都为 LoxNumber 类型
-        if (std::holds_alternative<LoxNumber>(left) && std::holds_alternative<LoxNumber>(right)) { return;
-}
-        // 若不全是 LoxNumber 类型，抛出运行时错误
-        throw runtime_error(op, "Operands must be numbers.");
-
+        if (std::holds_alternative<LoxNumber>(left) && std::holds_alternative<LoxNumber>(right)) [[likely]] {
+            return true;
+        }
+        // 若不全是 LoxNumber 类型，记录运行时错误
+        raise(op, "Operands must be numbers.");
+        return false;
     }
 
         /**
      * @brief 查找变量的值
      * 
-     * 该函数根据给定的 Token 和可赋值表达式，查找并返回变量的值。
+     * 该函数根据给定的变量名和可赋值表达式，查找并返回变量的值。
      * 它会在当前解释器的环境中进行查找，考虑作用域和变量的绑定情况。
      * 
-     * @param name 变量的 Token 对象，包含变量的名称和位置信息
+     * @param name 变量名，包含变量的名称和位置信息
      * @param expr 可赋值表达式，可能包含变量的作用域信息
-     * @return LoxObject& 返回找到的变量的值的引用
+     * @return LoxObject 变量的值，全局变量未定义时记录运行时错误并返回 nil
      */
-    [[nodiscard]] LoxObject &lookUpVariable(const Token &name, const Assignable &expr) const;
+    LoxObject lookUpVariable(const Identifier &name, const Assignable &expr);
 
 };
\ No newline at end of file
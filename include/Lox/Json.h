@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Lox/LoxObject.h"
+#include "Lox/LoxString.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// JSON 的解析与序列化，供 jsonParse、jsonStringify 和 jsonLines 使用。
+//
+// 解析分为两个阶段，做法与 simdjson 相同：第一阶段每次处理 64 字节，用 SIMD 比较得到引号、反斜杠、
+// 结构字符和空白的位掩码，用前缀异或算出哪些字节位于字符串内部，输出结构字符、引号和标量起点的位置；
+// 第二阶段沿着这些位置递归下降构造 Lox 值，不再逐字节扫描空白和字符串内容。
+
+/**
+ * @brief 第一阶段：找出 text 中所有字符串之外的结构字符、未转义的引号和标量起点的位置
+ *
+ * @param text JSON 文本
+ * @param indices 输出的位置，按升序追加
+ * @return bool 字符串是否都已闭合
+ */
+bool scanJsonStructurals(std::string_view text, std::vector<std::uint32_t> &indices);
+
+/**
+ * @brief 解析一个完整的 JSON 文本
+ *
+ * 对象解析为内置类 Object 的实例，字段可以直接用 obj.name 访问；数组解析为列表；
+ * 不含转义的字符串与输入共享缓冲区，不复制字符。
+ *
+ * @param text JSON 文本
+ * @param error 格式错误时写入错误信息
+ * @return std::optional<LoxObject> 解析得到的值，格式错误时为空
+ */
+std::optional<LoxObject> parseJson(const LoxString &text, std::string &error);
+
+/**
+ * @brief 将 Lox 值序列化为 JSON 文本
+ *
+ * 非有限的数字输出为 null；实例按字段序列化为对象，字段的顺序不固定。
+ *
+ * @param value 要序列化的值
+ * @param error 遇到函数、类或嵌套过深（例如循环引用）时写入错误信息
+ * @return std::optional<std::string> JSON 文本，不能序列化时为空
+ */
+std::optional<std::string> stringifyJson(const LoxObject &value, std::string &error);
@@ -1,40 +1,103 @@
 #pragma once
-#include <cstdlib>// for exit()
-#include <llvm/ADT/StringRef.h>
 #include "Error/Error.h"
+#include "Lox/HotReload.h"
+#include "Lox/Interpreter.h"
+#include "Lox/Metrics.h"
+#include "frontend/ModuleLoader.h"
+#include "frontend/Resolver.h"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
 
 /**
  * @class Lox
  * @brief 表示Lox解释器的主类。
- * 
- * 该类提供了运行Lox代码的接口，支持从命令行交互式输入和从文件读取代码。
+ *
+ * 该类把扫描器、解析器、变量解析器和解释器串联起来，支持从命令行交互式输入和从文件读取代码。
+ * 变量解析器和解释器在多次 run 之间保持状态：REPL 中每次输入只扫描、解析和变量解析新输入的代码，
+ * 之前定义的全局变量、函数和类仍然可用。
  */
 class Lox {
 public:
+    /**
+     * @brief 构造函数
+     *
+     * @param limits 每次 run 的执行预算
+     * @param engine 执行引擎
+     * @param autoMemoize 是否对纯的顶层函数自动记忆化
+     */
+    explicit Lox(
+        const ExecutionLimits &limits = {}, ExecutionEngine engine = ExecutionEngine::TREE, bool autoMemoize = false
+    );
+
     /**
      * @brief 启动交互式命令行模式。
-     * 
-     * 该方法允许用户在命令行中逐行输入Lox代码并立即执行。
+     *
+     * 该方法允许用户在命令行中逐行输入Lox代码并立即执行。花括号没有闭合时继续读取下一行，
+     * 因此可以直接粘贴多行的函数和类。出错的输入不影响之后的输入。
      */
-    static void runPrompt();
+    void runPrompt();
+
     /**
      * @brief 从指定文件中读取并运行Lox代码。
-     * 
+     *
      * @param path 包含Lox代码的文件的路径。
+     * @return int 退出状态：0 成功，65 编译错误，66 无法读取，70 运行时错误
      */
-    static void runFile(const std::string &path);
+    int runFile(const std::string &path);
 
     /**
      * @brief 运行给定的Lox源代码。
-     * 
+     *
      * @param source 要执行的Lox源代码。
+     * @param name 用于错误信息的名字。
+     * @param directory 相对导入路径的基准目录。
+     * @param firstLine 源代码第一行的行号。
+     * @return int 退出状态：0 成功，65 编译错误，70 运行时错误
+     */
+    int run(std::string source, const std::string &name, const std::filesystem::path &directory, int firstLine = 1);
+
+    /**
+     * @brief 开启热重载：之后运行的代码和它导入的模块被保存时，改动过的顶层函数和类会换入正在运行的程序
+     */
+    void enableHotReload();
+
+    /**
+     * @brief 开启运行时指标导出，直到 Lox 对象析构时写出最后一份
+     *
+     * @param options 导出配置
      */
-    static void run(const std::string &source);
+    void enableMetrics(const MetricsOptions &options);
 
-   
+    /**
+     * @brief 开启硬件计数器：之后的每次 run 分别统计扫描、解析、变量解析和执行阶段
+     *
+     * @param perFunction 是否同时按顶层函数统计
+     */
+    void enablePerfCounters(bool perFunction);
+
+    /**
+     * @brief 获取硬件计数器的统计，没有开启时为空
+     */
+    [[nodiscard]] const PerfProfile *getPerfProfile() const { return perf.get(); }
+
+    /**
+     * @brief 获取变量解析器，用于输出记忆化统计
+     */
+    [[nodiscard]] const Resolver &getResolver() const { return resolver; }
 
 private:
-    // 标记在代码执行过程中是否发生了错误
-    //这里统一错误处理
-    //bool hadError = false;
+    ExecutionLimits limits;
+    // 执行过的每段代码的 AST。之后的代码仍可能调用其中定义的函数，字符串字面量也借用 AST 中的文本，
+    // 因此保存到解释器销毁之后（成员按声明的逆序析构）
+    std::vector<std::unique_ptr<const Module>> chunks;
+    Resolver resolver;
+    // 硬件计数器，解释器保存它的指针，因此在解释器之后析构
+    std::unique_ptr<PerfProfile> perf;
+    Interpreter interpreter;
+    // 热重载的监视线程，在解释器之前析构
+    std::unique_ptr<HotReloader> reloader;
+    // 运行时指标的导出线程，析构时还要读取解释器的状态，因此最先析构
+    std::unique_ptr<MetricsExporter> metrics;
 };
@@ -8,7 +8,7 @@
  * 
  * 该类定义了可调用对象的基本接口，包括函数调用、获取参数数量和转换为字符串表示的方法。
  */
-class LoxCallable {
+class LoxCallable : public RefCounted<LoxCallable> {
 public:
     // 可调用对象的参数数量
     int _arity = 0;
@@ -1,22 +1,25 @@
 #pragma once
 #include "Lox/LoxCallable.h"
+#include "Lox/LoxFunction.h"
 #include "Lox/LoxInstance.h"
 #include <memory>
 /**
- * @brief 表示 Lox 语言中的类，继承自 LoxCallable 和 std::enable_shared_from_this<LoxClass>
+ * @brief 表示 Lox 语言中的类，继承自 LoxCallable
  * 
  * 这个类封装了 Lox 类的核心功能，包括类名、父类、方法和构造函数。
  */
-class LoxClass final :public LoxCallable,public std::enable_shared_from_this<LoxClass> {
+class LoxClass final :public LoxCallable {
 public:
     // 类的名称
     std::string_view name;
     // 可选的父类，如果没有父类则为 std::nullopt
-    std::optional<std::shared_ptr<LoxClass>> superClass;
+    std::optional<LoxClassPtr> superClass;
     // 存储类的方法，键为方法名，值为方法的智能指针
     std::unordered_map<std::string_view, LoxFunctionPtr> methods;
     // 类的构造函数
     LoxFunctionPtr initializer;
+    // 实例字段名引用的额外存储，随类一起释放；例如 JSON 文档中程序没有用到的键
+    std::shared_ptr<const void> storage;
 
     /**
      * @brief 构造一个新的 LoxClass 对象
@@ -26,7 +29,7 @@ public:
      * @param methods 类的方法列表
      */
     explicit LoxClass(
-        const std::string_view &name, const std::optional<std::shared_ptr<LoxClass>> &superClass,
+        const std::string_view &name, const std::optional<LoxClassPtr> &superClass,
         const std::unordered_map<std::string_view, LoxFunctionPtr> &methods
     )
         : LoxCallable(0), name{name}, superClass{superClass}, methods{methods} {
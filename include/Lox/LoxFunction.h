@@ -1,15 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <utility>
 
 #include "Lox/LoxCallable.h"
+#include "Lox/MemoCache.h"
+#include "Utils/SlabAllocator.h"
 
 /**
  * @brief 表示 Lox 语言中的函数对象。
  * 
  * 该类继承自 LoxCallable，实现了函数调用的相关功能。
+ * 每次通过实例访问方法都会绑定出一个新的 LoxFunction，因此从 slab 池分配。
  */
-class LoxFunction final : public LoxCallable {
+class LoxFunction final : public LoxCallable, public SlabAllocated<LoxFunction> {
 public:
     // 函数声明的智能指针
     std::shared_ptr<FunctionStmt> declaration;
@@ -17,6 +21,10 @@ public:
     EnvironmentPtr closure;
     // 标记函数是否为初始化器
     bool isInitializer;
+    // 纯函数的记忆表，首次调用被记忆化的函数时创建
+    std::unique_ptr<MemoCache> memo;
+    // 调用次数，用于运行时指标中调用最多的顶层函数
+    std::uint64_t calls = 0;
 
     /**
      * @brief 构造函数，初始化 LoxFunction 对象。
@@ -53,10 +61,42 @@ public:
      */
     LoxFunctionPtr bind(const LoxInstancePtr &instance);
 
+    /**
+     * @brief 在调用方提供的环境中执行函数体，不经过记忆表，供原生函数反复回调同一个函数
+     *
+     * 上一次调用结束后 frame 只被调用方持有（没有闭包捕获它）时清空后复用，否则换一个新环境。
+     *
+     * @param interpreter 解释器实例。
+     * @param arguments 传递给函数的参数列表。
+     * @param frame 调用方保存的环境，为空时创建。
+     * @return LoxObject 函数调用的返回值。
+     */
+    LoxObject invokeIn(Interpreter &interpreter, const std::vector<LoxObject> &arguments, EnvironmentPtr &frame);
+
     /**
      * @brief 将函数转换为字符串表示形式。
      * 
      * @return std::string 函数的字符串表示。
      */
     std::string to_string() override;
+
+private:
+    /**
+     * @brief 在新环境中执行函数体，不经过记忆表。
+     *
+     * @param interpreter 解释器实例。
+     * @param arguments 传递给函数的参数列表。
+     * @return LoxObject 函数调用的返回值。
+     */
+    LoxObject invoke(Interpreter &interpreter, const std::vector<LoxObject> &arguments);
+
+    /**
+     * @brief 在给定环境中绑定参数并执行函数体
+     *
+     * @param interpreter 解释器实例。
+     * @param arguments 传递给函数的参数列表。
+     * @param environment 函数体的环境，其外层环境是闭包。
+     * @return LoxObject 函数调用的返回值。
+     */
+    LoxObject run(Interpreter &interpreter, const std::vector<LoxObject> &arguments, const EnvironmentPtr &environment);
 };
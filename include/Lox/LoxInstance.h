@@ -1,17 +1,21 @@
 #pragma once
 #include "Lox/LoxClass.h"
 #include "Lox/LoxObject.h"
+#include "Utils/SlabAllocator.h"
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <utility>
 
 /**
- * @brief 表示 Lox 语言中的类实例，继承自 std::enable_shared_from_this<LoxInstance>
+ * @brief 表示 Lox 语言中的类实例，使用侵入式引用计数，从 slab 池分配
  * 
  * 这个类封装了 Lox 类实例的核心功能，包括所属的类和实例的字段。
  */
-class LoxInstance : public std::enable_shared_from_this<LoxInstance> {
+class LoxInstance : public RefCounted<LoxInstance>, public SlabAllocated<LoxInstance> {
 public:
+    // 实例可以组成任意长的链表，限制析构的递归深度
+    static constexpr bool deferDestruction = true;
     // 该实例所属的 Lox 类
     LoxClassPtr klass;
     // 存储实例的字段，键为字段名，值为字段的值
@@ -28,9 +32,9 @@ public:
      * @brief 获取实例中指定名称的字段的值
      * 
      * @param name 字段的名称
-     * @return LoxObject 字段的值
+     * @return std::optional<LoxObject> 字段的值，未定义时为空
      */
-    LoxObject get(const Token &name);
+    std::optional<LoxObject> get(const Identifier &name);
 
     /**
      * @brief 设置实例中指定名称的字段的值
@@ -38,7 +42,7 @@ public:
      * @param name 字段的名称
      * @param value 要设置的值
      */
-    void set(const Token &name, const LoxObject &value);
+    void set(const Identifier &name, const LoxObject &value);
 
     /**
      * @brief 将实例转换为字符串表示
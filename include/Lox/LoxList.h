@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Lox/LoxObject.h"
+#include "Utils/Ref.h"
+#include "Utils/SlabAllocator.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lox 的内置列表，使用侵入式引用计数，从 slab 池分配
+ *
+ * 列表按引用传递，== 比较的是是否为同一个列表。
+ */
+class LoxList : public RefCounted<LoxList>, public SlabAllocated<LoxList> {
+public:
+    // 列表可以任意深度地嵌套，限制析构的递归深度
+    static constexpr bool deferDestruction = true;
+    // 列表中的元素
+    std::vector<LoxObject> elements;
+
+    LoxList() = default;
+
+    /**
+     * @brief 用已有的元素构造列表
+     *
+     * 定义在 LoxObject.cpp 中：本头文件会被前端包含，那里看不到销毁 LoxObject 所需的运行时类型的完整定义。
+     *
+     * @param elements 列表元素
+     */
+    explicit LoxList(std::vector<LoxObject> elements);
+
+    /**
+     * @brief 将列表转换为字符串表示，格式为 "[a, b, c]"
+     *
+     * @return std::string 列表的字符串表示
+     */
+    std::string to_string() const;
+};
@@ -1,23 +1,34 @@
 #pragma once
 
 #include "Error/Error.h"
+#include "Lox/LoxString.h"
+#include "Utils/Ref.h"
 #include <memory>
+#include <span>
+#include <string_view>
 
 
 // Lox runtime types.
+// LoxString 是共享缓冲区的字符串视图，见 Lox/LoxString.h
 using LoxNil = std::nullptr_t;
-using LoxString = std::string;
 using LoxNumber = double;
 using LoxBoolean = bool;
 class LoxCallable;
 class LoxFunction;
 class LoxClass;
 class LoxInstance;
-using LoxCallablePtr = std::shared_ptr<LoxCallable>;
-using LoxFunctionPtr = std::shared_ptr<LoxFunction>;
-using LoxInstancePtr = std::shared_ptr<LoxInstance>;
-using LoxClassPtr = std::shared_ptr<LoxClass>;
-using LoxObject = std::variant<LoxNil, LoxString, LoxNumber, LoxBoolean, LoxCallablePtr, LoxInstancePtr>;
+class LoxList;
+// 运行时对象使用侵入式、非原子的引用计数，见 Utils/Ref.h
+using LoxCallablePtr = Ref<LoxCallable>;
+using LoxFunctionPtr = Ref<LoxFunction>;
+using LoxInstancePtr = Ref<LoxInstance>;
+using LoxClassPtr = Ref<LoxClass>;
+using LoxListPtr = Ref<LoxList>;
+using LoxObject = std::variant<LoxNil, LoxString, LoxNumber, LoxBoolean, LoxCallablePtr, LoxInstancePtr, LoxListPtr>;
 
 bool isTruthy(const LoxObject &object);
-std::string to_string(const LoxObject &object);
\ No newline at end of file
+std::string to_string(const LoxObject &object);
+LoxString interpolate(std::span<const std::string_view> strings, std::span<const LoxObject> values);
+
+// LoxList 只依赖 LoxObject，放在末尾包含，使所有用到 LoxObject 的地方都能看到它的完整定义
+#include "Lox/LoxList.h"
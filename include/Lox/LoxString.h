@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Utils/Ref.h"
+#include "Utils/SlabAllocator.h"
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Lox 的字符串值：指向引用计数缓冲区中一段字符的视图。
+ *
+ * 复制字符串只增加缓冲区的引用计数，不复制字符；slice、split、trim 得到的子串与原字符串共享同一个缓冲区，
+ * 因此按字段切分一行日志不会为每个字段分配内存。代价是只要还有子串存活，整个缓冲区就不会释放。
+ * 缓冲区创建后不再修改，多个字符串可以安全地共享。
+ */
+class LoxString {
+public:
+    LoxString() = default;
+
+    /**
+     * @brief 接管一个 std::string 作为新的缓冲区
+     *
+     * @param text 字符串内容
+     */
+    LoxString(std::string text) {
+        if (text.empty()) { return; }
+        buffer = make_ref<Buffer>(std::move(text));
+        start = buffer->text.data();
+        length = buffer->text.size();
+    }
+
+    LoxString(const char *text) : LoxString(std::string(text)) {}
+
+    /**
+     * @brief 从字符串视图复制出一个新的缓冲区
+     *
+     * @param text 字符串内容
+     */
+    explicit LoxString(const std::string_view text) : LoxString(std::string(text)) {}
+
+    /**
+     * @brief 以只读方式把整个文件映射到内存，作为新的缓冲区
+     *
+     * 映射在最后一个引用它的字符串（包括子串）销毁时解除，文件内容不会被复制。
+     *
+     * @param path 文件路径
+     * @return std::optional<LoxString> 文件内容，打开或映射失败时为空，原因保存在 errno 中
+     */
+    static std::optional<LoxString> mapFile(const std::string &path);
+
+    /**
+     * @brief 不持有缓冲区的视图，复制和销毁都不改动任何引用计数
+     *
+     * 用于 AST 中的字符串字面量：模块的 AST 被多个线程上的解释器共享，字面量的值不能有非原子的引用计数。
+     * 调用方保证 text 比这个字符串的所有副本（包括子串）活得更久。
+     *
+     * @param text 字符串内容
+     */
+    static LoxString borrow(const std::string_view text) {
+        LoxString result;
+        result.start = text.data();
+        result.length = text.size();
+        return result;
+    }
+
+    [[nodiscard]] std::string_view view() const { return {start, length}; }
+    [[nodiscard]] const char *data() const { return start; }
+    [[nodiscard]] std::size_t size() const { return length; }
+    [[nodiscard]] bool empty() const { return length == 0; }
+    operator std::string_view() const { return view(); }
+
+    /**
+     * @brief 取子串，结果与当前字符串共享缓冲区
+     *
+     * @param offset 子串的起始位置，调用方保证不超过 size()
+     * @param count 子串的长度，调用方保证 offset + count 不超过 size()
+     * @return LoxString 子串
+     */
+    [[nodiscard]] LoxString slice(const std::size_t offset, const std::size_t count) const {
+        LoxString result;
+        if (count == 0) { return result; }
+        result.buffer = buffer;
+        result.start = start + offset;
+        result.length = count;
+        return result;
+    }
+
+    friend bool operator==(const LoxString &left, const LoxString &right) { return left.view() == right.view(); }
+
+    /**
+     * @brief 拼接两个字符串，一次性分配结果的缓冲区
+     */
+    friend LoxString operator+(const LoxString &left, const LoxString &right) {
+        std::string text;
+        text.reserve(left.size() + right.size());
+        text.append(left.view()).append(right.view());
+        return {std::move(text)};
+    }
+
+private:
+    // 字符串的底层存储，从 slab 池分配；内容要么在 text 中，要么是一段文件映射
+    struct Buffer : RefCounted<Buffer>, SlabAllocated<Buffer> {
+        explicit Buffer(std::string text) : text{std::move(text)} {}
+        Buffer(void *mapping, const std::size_t mappingSize) : mapping{mapping}, mappingSize{mappingSize} {}
+        ~Buffer() {
+            if (mapping != nullptr) { unmap(mapping, mappingSize); }
+        }
+        const std::string text;
+        void *const mapping = nullptr;
+        const std::size_t mappingSize = 0;
+    };
+
+    static void unmap(void *mapping, std::size_t size);
+
+    Ref<Buffer> buffer;
+    const char *start = nullptr;
+    std::size_t length = 0;
+};
+
+/**
+ * @brief 按内容计算 LoxString 的哈希值，与 std::string_view 一致
+ */
+template<>
+struct std::hash<LoxString> {
+    std::size_t operator()(const LoxString &string) const noexcept { return std::hash<std::string_view>{}(string.view()); }
+};
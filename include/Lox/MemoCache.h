@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Lox/LoxObject.h"
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// 每个被记忆化函数的记忆表容量上限
+static constexpr std::size_t MEMO_CAPACITY = 4096;
+
+/**
+ * @brief 纯函数的有界 LRU 记忆表。
+ *
+ * 键为调用参数列表（仅允许数字和字符串），值为函数的返回值。
+ * 数字按位模式比较：0 与 -0 是不同的键（1/x 的结果不同），NaN 与自身相等，淘汰时总能在索引中找到它。
+ * 表满时淘汰最久未使用的条目。
+ */
+class MemoCache {
+public:
+    using Key = std::vector<LoxObject>;
+
+    // 当前线程所有记忆表的累计命中与未命中次数，用于 --stats 输出
+    static inline thread_local std::uint64_t totalHits = 0;
+    static inline thread_local std::uint64_t totalMisses = 0;
+
+    explicit MemoCache(const std::size_t capacity = MEMO_CAPACITY) : capacity{capacity} {}
+
+    /**
+     * @brief 判断参数列表能否作为记忆表的键。
+     *
+     * 只有全部参数都是数字或字符串时才允许记忆化，其它类型（实例、函数等）可能携带可变状态。
+     *
+     * @param arguments 调用参数列表。
+     * @return bool 可以作为键时返回 true。
+     */
+    static bool isMemoizable(const std::vector<LoxObject> &arguments) {
+        for (const auto &argument: arguments) {
+            if (!std::holds_alternative<LoxNumber>(argument) && !std::holds_alternative<LoxString>(argument)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 查找记忆表，命中时把条目移动到最近使用的位置。
+     *
+     * @param key 调用参数列表。
+     * @return std::optional<LoxObject> 命中时返回缓存的返回值。
+     */
+    std::optional<LoxObject> lookup(const Key &key) {
+        const auto it = index.find(key);
+        if (it == index.end()) {
+            totalMisses++;
+            return std::nullopt;
+        }
+        totalHits++;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    /**
+     * @brief 插入一条记忆，超过容量时淘汰最久未使用的条目。
+     *
+     * @param key 调用参数列表。
+     * @param value 函数的返回值。
+     */
+    void insert(const Key &key, const LoxObject &value) {
+        if (const auto it = index.find(key); it != index.end()) {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        entries.emplace_front(key, value);
+        index.emplace(entries.front().first, entries.begin());
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+private:
+    // 数字参数的位模式
+    static std::uint64_t bits(const LoxObject &argument) { return std::bit_cast<std::uint64_t>(std::get<LoxNumber>(argument)); }
+
+    /**
+     * @brief 参数列表的哈希函数，组合每个数字的位模式或字符串参数的哈希值。
+     */
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const {
+            std::size_t seed = key.size();
+            for (const auto &argument: key) {
+                const std::size_t h = std::holds_alternative<LoxNumber>(argument)
+                    ? std::hash<std::uint64_t>{}(bits(argument))
+                    : std::hash<LoxString>{}(std::get<LoxString>(argument));
+                seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    /**
+     * @brief 参数列表的相等比较，数字按位模式比较。
+     */
+    struct KeyEqual {
+        bool operator()(const Key &a, const Key &b) const {
+            if (a.size() != b.size()) { return false; }
+            for (std::size_t i = 0; i < a.size(); i++) {
+                if (a[i].index() != b[i].index()) { return false; }
+                if (std::holds_alternative<LoxNumber>(a[i]) ? bits(a[i]) != bits(b[i]) : !(a[i] == b[i])) { return false; }
+            }
+            return true;
+        }
+    };
+
+    std::size_t capacity;
+    // 按使用时间排序的条目，表头为最近使用
+    std::list<std::pair<Key, LoxObject>> entries;
+    std::unordered_map<Key, std::list<std::pair<Key, LoxObject>>::iterator, KeyHash, KeyEqual> index;
+};
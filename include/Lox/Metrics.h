@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Lox/Interpreter.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 运行时指标的输出格式
+ */
+enum class MetricsFormat { PROMETHEUS, JSON };
+
+/**
+ * @brief 运行时指标导出的配置
+ */
+struct MetricsOptions {
+    // 输出位置：文件路径，或 unix:<路径> 表示连接到 Unix 域套接字
+    std::string output;
+    // 导出间隔
+    std::chrono::milliseconds interval{1000};
+    MetricsFormat format = MetricsFormat::PROMETHEUS;
+};
+
+/**
+ * @brief 运行时指标导出（--metrics-out）：定期把解释器的运行状况写到文件或 Unix 域套接字
+ *
+ * 导出线程每隔一个间隔向解释器发出请求，解释器在下一个安全点上采样：堆大小、slab 的分配和释放次数、
+ * 调用次数和调用最多的顶层函数，再由导出线程计算速率、格式化并写出。
+ * 从发出请求到解释器采样之间的延迟作为安全点延迟导出，它反映脚本有多久没有回到解释器（例如阻塞在原生函数中）。
+ * 解释器使用引用计数，没有垃圾回收暂停可以报告。
+ *
+ * 写到文件时每次先写临时文件再改名，读者总是看到完整的一份（可以直接作为 Prometheus textfile collector 的输入）；
+ * 写到套接字时每份指标依次写入同一个连接，断开后在下一个间隔重新连接。脚本结束时再写最后一份。
+ */
+class MetricsExporter {
+public:
+    /**
+     * @brief 创建导出线程
+     *
+     * @param interpreter 被采样的解释器，必须比 MetricsExporter 活得更久
+     * @param options 导出配置
+     */
+    MetricsExporter(Interpreter &interpreter, MetricsOptions options);
+
+    /**
+     * @brief 停止导出线程，并在当前线程上写出最后一份指标
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+    /**
+     * @brief 导出线程是否请求了一次采样，由解释器在安全点上检查
+     */
+    [[nodiscard]] bool due() const { return requested.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 在解释器线程上采样，并把样本交给导出线程
+     */
+    void sample();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 一次采样的结果
+    struct Sample {
+        Clock::time_point time;
+        std::size_t heapBytes = 0;
+        std::uint64_t allocations = 0;
+        std::uint64_t frees = 0;
+        std::uint64_t calls = 0;
+        // 从请求到采样的延迟
+        double lagSeconds = 0;
+        // 调用次数最多的顶层函数
+        std::vector<std::pair<std::string, std::uint64_t>> topFunctions;
+    };
+
+    Interpreter &interpreter;
+    MetricsOptions options;
+    Clock::time_point start = Clock::now();
+
+    std::atomic<bool> requested = false;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    // 以下由 mutex 保护
+    Clock::time_point requestedAt;
+    std::optional<Sample> pending;
+    bool stopping = false;
+
+    // 导出线程使用的状态
+    std::optional<Sample> previous;
+    int socketFd = -1;
+    std::thread thread;
+
+    // 导出线程的主循环
+    void run();
+    // 在当前线程上采样
+    Sample collect(Clock::time_point requestTime);
+    // 格式化并写出一份样本
+    void publish(const Sample &current);
+    [[nodiscard]] std::string format(const Sample &current) const;
+    void write(const std::string &text);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Lox/Interpreter.h"
+#include "Lox/LoxObject.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class LoxFunction;
+
+/**
+ * @brief 原生函数回调 Lox 可调用对象的调用器
+ *
+ * sort、map 这类原生函数在 C++ 中执行循环，每个元素只回调一次用户给出的函数。构造时一次性检查被调用对象和参数个数，
+ * 之后每次调用复用同一个参数数组；被调用的是 Lox 函数时走 Interpreter::callFunction 快速路径，
+ * 函数体没有捕获环境时每次调用复用同一个环境，不再逐次分配。
+ *
+ * 被调用对象不合适或回调中的 Lox 代码出错时，错误记录在解释器中，之后的调用不再执行并直接返回 nil；
+ * 原生函数在循环中检查 Interpreter::unwinding()，为真时返回。
+ */
+class NativeCallback {
+public:
+    /**
+     * @brief 检查 callee 可以用 arity 个参数调用，否则在原生函数的调用点上记录错误
+     *
+     * @param interpreter 解释器实例
+     * @param native 原生函数名，用于错误信息
+     * @param callee 被调用对象
+     * @param arity 每次调用传入的参数个数
+     */
+    NativeCallback(Interpreter &interpreter, std::string_view native, const LoxObject &callee, int arity);
+
+    /**
+     * @brief 以给定的参数调用
+     *
+     * @param args 参数，个数必须等于构造时的 arity
+     * @return LoxObject 调用结果，已经出错时为 nil
+     */
+    template<typename... Args>
+    LoxObject operator()(Args &&...args) {
+        std::size_t i = 0;
+        ((arguments[i++] = std::forward<Args>(args)), ...);
+        return invoke();
+    }
+
+private:
+    Interpreter &interpreter;
+    // 原生函数的调用点，作为回调的安全点和错误位置
+    SourceLoc loc;
+    LoxObject callee;
+    // 被调用对象是 Lox 函数且没有记忆表时非空
+    LoxFunction *function = nullptr;
+    std::vector<LoxObject> arguments;
+    // 上一次调用使用的环境
+    EnvironmentPtr frame;
+
+    LoxObject invoke();
+};
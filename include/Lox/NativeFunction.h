@@ -9,8 +9,9 @@
  */
 class NativeFunction final : public LoxCallable {
 public:
-    // 定义原生函数的类型，使用 std::function 封装，接受一个 std::vector<LoxObject> 类型的参数列表，并返回一个 LoxObject。
-    using NativeFnType = std::function<LoxObject(const std::vector<LoxObject> &)>;
+    // 定义原生函数的类型，使用 std::function 封装，接受解释器和参数列表，并返回一个 LoxObject。
+    // 需要回调 Lox 函数的原生函数通过解释器构造 NativeCallback。
+    using NativeFnType = std::function<LoxObject(Interpreter &, const std::vector<LoxObject> &)>;
     // 存储原生函数的实例。
     NativeFnType function;
 
@@ -31,12 +32,12 @@ public:
     /**
      * @brief 重载函数调用运算符，执行原生函数。
      * 
-     * @param interpreter 解释器实例，此处未使用。
+     * @param interpreter 解释器实例，原生函数用它回调 Lox 函数。
      * @param arguments 传递给原生函数的参数列表。
      * @return LoxObject 原生函数的返回值。
      */
-    LoxObject operator()(Interpreter & /*interpreter*/, const std::vector<LoxObject> &arguments) override {
-        return function(arguments);
+    LoxObject operator()(Interpreter &interpreter, const std::vector<LoxObject> &arguments) override {
+        return function(interpreter, arguments);
     }
 
     /**
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Lox/Environment.h"
+
+/**
+ * @brief 在全局环境中定义字符串和列表相关的原生函数。
+ *
+ * len、slice、indexOf、split、startsWith、trim 和 at。
+ * slice、split、trim 返回的子串与原字符串共享缓冲区；indexOf 和 split 使用 glibc 的 memchr/memmem，
+ * 它们有 SIMD 实现，长模式串使用 two-way 算法，不会退化为逐字符比较。
+ *
+ * @param globals 全局环境
+ */
+void defineStringNatives(Environment &globals);
+
+/**
+ * @brief 在全局环境中定义读取数据的原生函数。
+ *
+ * readFile 读取整个文件；jsonParse、jsonStringify 在 JSON 文本与 Lox 值之间转换，
+ * jsonLines 返回逐条解析 NDJSON 记录的读取函数。JSON 的解析方式见 Lox/Json.h。
+ * csvReader 把 CSV 文件映射到内存后逐行返回字段列表，csvColumn 把一列直接解析为数字列表，见 Lox/Csv.h。
+ *
+ * @param globals 全局环境
+ */
+void defineDataNatives(Environment &globals);
+
+/**
+ * @brief 在全局环境中定义以函数为参数的列表原生函数。
+ *
+ * map、filter、reduce 和 sort 的循环在 C++ 中执行，只有用户给出的函数通过 NativeCallback 回调，
+ * 每次回调复用同一个参数数组和（没有被捕获时）同一个环境。
+ *
+ * @param globals 全局环境
+ */
+void defineListNatives(Environment &globals);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Lox/Interpreter.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief 服务模式的配置
+ */
+struct ServerOptions {
+    // Unix 域套接字路径
+    std::string socketPath;
+    // 隔离区（各自拥有一个线程和一个解释器）的个数
+    unsigned isolates = 1;
+    // 每个解释器在接受请求之前导入的模块
+    std::vector<std::string> preloads;
+    // 每个请求的执行预算
+    ExecutionLimits limits;
+    ExecutionEngine engine = ExecutionEngine::TREE;
+};
+
+/**
+ * @brief 在 Unix 域套接字上提供脚本执行服务，直到收到 SIGINT 或 SIGTERM
+ *
+ * 每个隔离区是一个线程和一个已经导入了预加载模块的解释器。主线程用 poll 等待所有空闲连接，
+ * 以非阻塞方式收齐一个完整的请求后才交给空闲的隔离区，发送很慢或中途停住的客户端不会占住隔离区；
+ * 隔离区执行完请求、写回响应后把连接交还主线程，然后丢弃用过的解释器并准备一个新的，
+ * 因此请求之间不共享任何全局状态，准备工作也不在请求的延迟路径上。
+ * 请求期间登记的源码位置和驻留的字符串放在 SourceMap 的段中，随请求释放。
+ * 请求格式见 Lox/ServerProtocol.h。
+ *
+ * @param options 服务配置
+ * @return int 进程退出状态：正常退出为 0，预加载模块出错为 65 或 70，套接字出错为 71
+ */
+int serve(const ServerOptions &options);
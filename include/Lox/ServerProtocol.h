@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * 服务模式（lox --serve）的请求与响应格式，服务端和 lox-client 共用。
+ *
+ * 一个连接上可以依次发送任意多个请求，每个请求得到一个响应：
+ *
+ *   请求  RUN <长度>\n<脚本源码>                  执行一段脚本
+ *         CALL <函数名> <长度>\n<JSON 参数数组>    调用预加载模块中的全局函数
+ *   响应  <状态> <输出长度> <错误长度> <结果长度>\n<print 输出><错误信息><JSON 结果>
+ *
+ * 状态与命令行一致：0 成功，64 请求格式错误（包括内容超过 MAX_BODY_BYTES），65 编译错误，70 运行时错误。
+ * 只有 CALL 成功时才有结果。
+ */
+
+// 请求和响应头（不含内容）的最大长度
+static constexpr std::size_t MAX_HEADER_BYTES = 512;
+// 请求内容的最大长度，服务端在收齐请求之前按这个上限缓冲
+static constexpr std::size_t MAX_BODY_BYTES = std::size_t{16} << 20;
+// 非阻塞连接上等待对端读走响应的最长时间（毫秒），超时后放弃这个连接
+static constexpr int WRITE_TIMEOUT_MS = 10000;
+
+/**
+ * @brief 读满 size 个字节
+ *
+ * @return bool 是否读满；对端关闭或出错时为 false
+ */
+inline bool readExactly(const int fd, char *data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR) { continue; }
+        if (count <= 0) { return false; }
+        data += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+/**
+ * @brief 写出全部字节；对端已关闭时返回 false 而不是触发 SIGPIPE
+ *
+ * 非阻塞连接的发送缓冲区满时最多等待 WRITE_TIMEOUT_MS，不读响应的对端不会一直占住写出的线程。
+ */
+inline bool writeAll(const int fd, const char *data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t count = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) { continue; }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd writable{fd, POLLOUT, 0};
+            if (::poll(&writable, 1, WRITE_TIMEOUT_MS) > 0) { continue; }
+            return false;
+        }
+        if (count <= 0) { return false; }
+        data += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+/**
+ * @brief 读取一行头部（不含换行符）
+ *
+ * 头部很短，逐字节读取，不会读走后面的内容。
+ *
+ * @return bool 是否读到完整的一行；对端关闭、出错或超过 MAX_HEADER_BYTES 时为 false
+ */
+inline bool readHeader(const int fd, std::string &header) {
+    header.clear();
+    for (char c; header.size() < MAX_HEADER_BYTES;) {
+        if (!readExactly(fd, &c, 1)) { return false; }
+        if (c == '\n') { return true; }
+        header.push_back(c);
+    }
+    return false;
+}
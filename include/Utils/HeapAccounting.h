@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// 按线程统计的堆使用量，供堆预算（--max-heap-mb）使用。
+//
+// 全局的 operator new/delete 被替换：开启统计后，每个线程记录自己分配的字节数减去自己释放的字节数
+// （都按 malloc_usable_size 计），以 mmap 映射的大页 slab 也计入映射它的线程。
+// 服务模式中多个隔离区同时执行请求，每个请求只和自己线程的增长比较，不受其他隔离区的分配影响。
+// 在一个线程上分配、在另一个线程上释放的内存会让前者偏高、后者偏低，所有线程的总和仍然正确。
+
+// 是否统计，由 --max-heap-mb 开启；必须在创建其他线程之前设置，之后不再改变
+inline bool threadHeapAccounting = false;
+
+/**
+ * @brief 当前线程分配的字节数减去释放的字节数，未开启统计时为 0
+ */
+std::int64_t threadHeapBytes();
+
+/**
+ * @brief 把不经过 operator new 的内存（例如大页 slab 的映射）计入当前线程
+ *
+ * @param bytes 增加的字节数，释放时为负
+ */
+void countThreadHeap(std::int64_t bytes);
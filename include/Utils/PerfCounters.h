@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+// 统计的硬件事件，顺序与 PerfCounts::values 的下标一致
+enum class PerfEvent { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES };
+static constexpr std::size_t PERF_EVENT_COUNT = 5;
+
+/**
+ * @brief 一组硬件计数器的读数或差值
+ */
+struct PerfCounts {
+    std::array<std::uint64_t, PERF_EVENT_COUNT> values{};
+    // 组启用的时间和实际在 PMU 上计数的时间（纳秒），两者不等说明组被多路复用
+    std::uint64_t enabled = 0;
+    std::uint64_t running = 0;
+
+    std::uint64_t operator[](const PerfEvent event) const { return values[static_cast<std::size_t>(event)]; }
+
+    PerfCounts &operator+=(const PerfCounts &other) {
+        for (std::size_t i = 0; i < PERF_EVENT_COUNT; i++) { values[i] += other.values[i]; }
+        enabled += other.enabled;
+        running += other.running;
+        return *this;
+    }
+
+    PerfCounts operator-(const PerfCounts &other) const {
+        PerfCounts result;
+        for (std::size_t i = 0; i < PERF_EVENT_COUNT; i++) { result.values[i] = values[i] - other.values[i]; }
+        result.enabled = enabled - other.enabled;
+        result.running = running - other.running;
+        return result;
+    }
+};
+
+// 分别统计的执行阶段
+enum class PerfPhase { SCAN, PARSE, RESOLVE, EXECUTE };
+static constexpr std::size_t PERF_PHASE_COUNT = 4;
+
+/**
+ * @brief 按执行阶段和顶层函数统计硬件计数器（--perf-counters）
+ *
+ * 用 perf_event_open 打开一组只统计当前线程用户态的计数器，一次 read 读出整组的值。
+ * 计数器不可用（内核不允许、虚拟机没有 PMU）的事件在报告中显示为 "-"。
+ * 内核无法同时调度整组计数器时会轮流计数：被多路复用的行按启用时间与计数时间之比放大并标上 "*"，
+ * 完全没有被调度的行显示为 "(not counted)"。
+ * 只统计创建它的线程：在工作线程上加载的导入模块的扫描和解析不计入。
+ *
+ * 按函数统计时，每次进入和离开顶层函数各读一次计数器，把两次读数之间的差值记到调用栈顶的函数上，
+ * 因此每个函数的数值不包含它调用的其他顶层函数，嵌套的局部函数和方法计入外层的顶层函数。
+ * 读计数器是一次系统调用，会明显拖慢调用密集的脚本，但内核态的开销不计入用户态的计数。
+ */
+class PerfProfile {
+public:
+    /**
+     * @brief 打开计数器
+     *
+     * @param perFunction 是否按顶层函数统计
+     */
+    explicit PerfProfile(bool perFunction);
+
+    ~PerfProfile();
+
+    PerfProfile(const PerfProfile &) = delete;
+    PerfProfile &operator=(const PerfProfile &) = delete;
+
+    /**
+     * @brief 是否至少有一个计数器可用
+     */
+    [[nodiscard]] bool available() const { return groupFd >= 0; }
+
+    /**
+     * @brief 是否按顶层函数统计
+     */
+    [[nodiscard]] bool perFunction() const { return functions; }
+
+    /**
+     * @brief 在作用域内把计数器的增量记到一个执行阶段上
+     */
+    class Phase {
+    public:
+        Phase(PerfProfile *profile, const PerfPhase phase) : profile{profile}, phase{phase} {
+            if (profile != nullptr) { start = profile->read(); }
+        }
+
+        ~Phase() {
+            if (profile != nullptr) { profile->phases[static_cast<std::size_t>(phase)] += profile->read() - start; }
+        }
+
+        Phase(const Phase &) = delete;
+        Phase &operator=(const Phase &) = delete;
+
+    private:
+        PerfProfile *profile;
+        PerfPhase phase;
+        PerfCounts start;
+    };
+
+    /**
+     * @brief 进入一个顶层函数
+     *
+     * @param key 区分函数的键（函数声明的地址）
+     * @param name 函数名，第一次进入时记录
+     */
+    void enterFunction(const void *key, std::string_view name);
+
+    /**
+     * @brief 离开最近进入的顶层函数
+     */
+    void leaveFunction();
+
+    /**
+     * @brief 输出各阶段和各函数的计数
+     *
+     * @param os 输出流
+     */
+    void print(llvm::raw_ostream &os) const;
+
+private:
+    // 一个顶层函数的累计计数
+    struct FunctionCounts {
+        std::string name;
+        std::uint64_t calls = 0;
+        PerfCounts counts;
+    };
+
+    // 组长的文件描述符，没有可用的计数器时为 -1
+    int groupFd = -1;
+    // 每个事件的文件描述符，不可用的为 -1
+    std::array<int, PERF_EVENT_COUNT> fds{};
+    // 每个可用事件在组读数中的位置
+    std::array<std::size_t, PERF_EVENT_COUNT> slots{};
+    std::size_t opened = 0;
+
+    std::array<PerfCounts, PERF_PHASE_COUNT> phases{};
+
+    bool functions;
+    std::unordered_map<const void *, FunctionCounts> functionCounts;
+    // 正在执行的顶层函数
+    std::vector<FunctionCounts *> stack;
+    // 上一次进入或离开函数时的读数
+    PerfCounts last;
+
+    /**
+     * @brief 读出所有计数器的当前值，不可用的事件为 0
+     */
+    [[nodiscard]] PerfCounts read() const;
+};
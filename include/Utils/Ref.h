@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 限制级联析构的递归深度。
+ *
+ * 对象析构时释放它引用的对象，很长的链表（例如一百万个依次引用的实例）会在析构中递归同样多层而耗尽栈。
+ * 声明了 static constexpr bool deferDestruction 的类型（可以互相嵌套的实例和列表）嵌套超过 MAX_DEPTH 层时先挂起，
+ * 由最外层的析构逐个删除。环境每次函数调用都会销毁，不参与计数，以免在热路径上增加开销。
+ */
+struct DeferredDestruction {
+    static constexpr unsigned MAX_DEPTH = 1024;
+    // 挂起的对象及删除它的函数
+    using Entry = std::pair<const void *, void (*)(const void *)>;
+    // 当前线程正在进行的嵌套析构层数
+    static inline thread_local unsigned depth = 0;
+    // 挂起的对象，第一次挂起时才创建，使快路径只访问平凡的线程局部变量
+    static inline thread_local std::vector<Entry> *pending = nullptr;
+};
+
+/**
+ * @brief 侵入式引用计数基类。
+ *
+ * 引用计数直接存放在对象中，不需要单独的控制块；计数是普通整数而不是原子变量，
+ * 因为一个解释器只在一个线程上运行。计数归零时通过 T 的析构函数删除对象，
+ * 因此多态层次的根类（例如 LoxCallable）必须声明虚析构函数。
+ *
+ * @tparam T 派生类类型（CRTP）。
+ */
+template<typename T>
+class RefCounted {
+public:
+    RefCounted() = default;
+    // 拷贝对象时不拷贝引用计数
+    RefCounted(const RefCounted &) {}
+    RefCounted &operator=(const RefCounted &) { return *this; }
+
+    /**
+     * @brief 增加一次引用
+     */
+    void retain() const noexcept { ++refCount; }
+
+    /**
+     * @brief 减少一次引用，计数归零时删除对象
+     */
+    void release() const noexcept {
+        if (--refCount == 0) [[unlikely]] { destroy(this); }
+    }
+
+    /**
+     * @brief 当前的引用计数，用于调试和统计
+     */
+    [[nodiscard]] std::uint32_t useCount() const noexcept { return refCount; }
+
+protected:
+    ~RefCounted() = default;
+
+private:
+    /**
+     * @brief 删除对象。单独放在不内联的冷路径上，使 release 和持有句柄的 LoxObject 的析构保持足够小而能被内联
+     */
+    [[gnu::noinline, gnu::cold]] static void destroy(const RefCounted *self) noexcept {
+        using Deferred = DeferredDestruction;
+        if constexpr (!requires { T::deferDestruction; }) {
+            delete static_cast<const T *>(self);
+        } else if (Deferred::depth >= Deferred::MAX_DEPTH) [[unlikely]] {
+            if (Deferred::pending == nullptr) { Deferred::pending = new std::vector<Deferred::Entry>(); }
+            Deferred::pending->emplace_back(self, [](const void *object) {
+                delete static_cast<const T *>(static_cast<const RefCounted *>(object));
+            });
+        } else {
+            Deferred::depth++;
+            delete static_cast<const T *>(self);
+            // 最外层负责删除挂起的对象，它们的析构又从第二层开始计数
+            if (Deferred::depth == 1 && Deferred::pending != nullptr) [[unlikely]] {
+                while (!Deferred::pending->empty()) {
+                    const auto [object, deleter] = Deferred::pending->back();
+                    Deferred::pending->pop_back();
+                    deleter(object);
+                }
+            }
+            Deferred::depth--;
+        }
+    }
+
+    mutable std::uint32_t refCount = 0;
+};
+
+/**
+ * @brief 侵入式引用计数对象的句柄，用法与 std::shared_ptr 相同。
+ *
+ * 可以从裸指针（包括 this）构造，构造时增加一次引用，因此不再需要 enable_shared_from_this。
+ * 与 std::shared_ptr 不同，销毁句柄的翻译单元必须能看到 T 的完整定义。
+ *
+ * @tparam T 继承自 RefCounted 的对象类型。
+ */
+template<typename T>
+class Ref {
+public:
+    Ref() = default;
+    Ref(std::nullptr_t) {}
+
+    /**
+     * @brief 从裸指针构造，增加一次引用
+     *
+     * @param pointer 对象指针，可以为空
+     */
+    explicit Ref(T *pointer) : pointer{pointer} {
+        if (pointer != nullptr) { pointer->retain(); }
+    }
+
+    Ref(const Ref &other) : pointer{other.pointer} {
+        if (pointer != nullptr) { pointer->retain(); }
+    }
+
+    Ref(Ref &&other) noexcept : pointer{std::exchange(other.pointer, nullptr)} {}
+
+    /**
+     * @brief 从派生类句柄隐式转换为基类句柄
+     */
+    template<typename U>
+        requires std::is_convertible_v<U *, T *>
+    Ref(const Ref<U> &other) : Ref(static_cast<T *>(other.get())) {}
+
+    template<typename U>
+        requires std::is_convertible_v<U *, T *>
+    Ref(Ref<U> &&other) noexcept : pointer{static_cast<T *>(other.detach())} {}
+
+    ~Ref() {
+        if (pointer != nullptr) { pointer->release(); }
+    }
+
+    Ref &operator=(const Ref &other) noexcept {
+        // 先增加新对象的引用再释放旧对象，自赋值时也安全
+        if (other.pointer != nullptr) { other.pointer->retain(); }
+        if (pointer != nullptr) { pointer->release(); }
+        pointer = other.pointer;
+        return *this;
+    }
+
+    Ref &operator=(Ref &&other) noexcept {
+        T *old = std::exchange(pointer, std::exchange(other.pointer, nullptr));
+        if (old != nullptr) { old->release(); }
+        return *this;
+    }
+
+    [[nodiscard]] T *get() const noexcept { return pointer; }
+    T *operator->() const noexcept { return pointer; }
+    T &operator*() const noexcept { return *pointer; }
+    explicit operator bool() const noexcept { return pointer != nullptr; }
+
+    /**
+     * @brief 放弃所有权并返回裸指针，不减少引用计数
+     */
+    [[nodiscard]] T *detach() noexcept { return std::exchange(pointer, nullptr); }
+
+    friend bool operator==(const Ref &left, const Ref &right) noexcept { return left.pointer == right.pointer; }
+    friend bool operator==(const Ref &left, std::nullptr_t) noexcept { return left.pointer == nullptr; }
+
+private:
+    T *pointer = nullptr;
+};
+
+/**
+ * @brief 创建一个引用计数对象，对应 std::make_shared
+ */
+template<typename T, typename... Args>
+Ref<T> make_ref(Args &&...args) {
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+/**
+ * @brief 在已知实际类型时把基类句柄转换为派生类句柄，对应 std::static_pointer_cast
+ */
+template<typename T, typename U>
+Ref<T> static_ref_cast(const Ref<U> &other) {
+    return Ref<T>(static_cast<T *>(other.get()));
+}
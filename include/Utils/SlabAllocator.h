@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+// 尺寸类的粒度，对象大小向上取整到它的倍数
+static constexpr std::size_t SLAB_GRANULE = 16;
+// 普通 slab 的大小：一个内存页
+static constexpr std::size_t SLAB_PAGE_BYTES = 4096;
+// 启用大页时 slab 的大小：一个 2 MiB 透明大页
+static constexpr std::size_t SLAB_HUGE_PAGE_BYTES = std::size_t{2} << 20;
+
+/**
+ * @brief 计算对象大小对应的尺寸类
+ *
+ * @param bytes 对象大小
+ * @return std::size_t 向上取整到 SLAB_GRANULE 后的块大小
+ */
+constexpr std::size_t slabSizeClass(const std::size_t bytes) {
+    return (bytes + SLAB_GRANULE - 1) / SLAB_GRANULE * SLAB_GRANULE;
+}
+
+/**
+ * @brief 一个尺寸类的 slab 池。
+ *
+ * 每个线程、每个尺寸类各有一个池：从整页（或大页）的 slab 中切出等长的块，
+ * 释放的块挂回线程局部的空闲链表，分配和释放都只是一次链表操作，不加锁。
+ * slab 在池销毁前不会归还给系统，反复创建和销毁的同尺寸对象总是复用同一批内存，不会产生碎片。
+ *
+ * 在一个线程上分配、在另一个线程上释放的块会进入释放线程的空闲链表，之后由那个线程复用，不再回到原来的池。
+ * 池（随线程退出）析构时，只有自己切出的块全部回到了自己的空闲链表才归还 slab；
+ * 只要有块还被使用或挂在其他线程的空闲链表上，slab 就保留到进程退出，以少量泄漏换取不会访问已归还的内存。
+ */
+class SlabPool {
+public:
+    // 是否用透明大页作为 slab，由 --slab-huge-pages 设置，必须在第一次分配之前设置
+    static inline bool useHugePages = false;
+    // 所有线程中以 mmap 映射的大页 slab 的总字节数，它们不在 malloc 的统计中，堆预算检查需要单独加上
+    static inline std::atomic<std::size_t> mappedBytes = 0;
+
+    /**
+     * @brief 构造一个尺寸类的池，并登记到当前线程的池列表中
+     *
+     * @param sizeClass 块大小
+     */
+    explicit SlabPool(std::size_t sizeClass);
+
+    /**
+     * @brief 析构时如果本池切出的块都在本池的空闲链表上，就把 slab 归还给系统；否则保留 slab
+     */
+    ~SlabPool();
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    /**
+     * @brief 分配一个块
+     *
+     * @return void* 块的地址
+     */
+    void *allocate() {
+        allocations++;
+        if (freeList != nullptr) [[likely]] {
+            FreeBlock *block = freeList;
+            freeList = block->next;
+            return block;
+        }
+        return refill();
+    }
+
+    /**
+     * @brief 把块放回空闲链表
+     *
+     * @param pointer 块的地址
+     */
+    void deallocate(void *pointer) noexcept {
+        frees++;
+        auto *block = static_cast<FreeBlock *>(pointer);
+        block->next = freeList;
+        freeList = block;
+    }
+
+    /**
+     * @brief 输出当前线程所有池的统计信息，用于 --stats
+     *
+     * @param os 输出流
+     */
+    static void printStats(llvm::raw_ostream &os);
+
+    /**
+     * @brief 当前线程所有池累计的分配和释放次数，用于运行时指标
+     *
+     * @return std::pair<std::uint64_t, std::uint64_t> 分配次数和释放次数
+     */
+    static std::pair<std::uint64_t, std::uint64_t> threadTotals();
+
+private:
+    // 空闲块复用对象本身的内存保存链表指针
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    /**
+     * @brief 空闲链表为空时申请一个新的 slab，切分后挂到空闲链表上
+     *
+     * @return void* 新 slab 中的第一个块
+     */
+    void *refill();
+
+    /**
+     * @brief 本池切出的块是否都在本池的空闲链表上，只在析构时调用
+     */
+    [[nodiscard]] bool allBlocksHome() const;
+
+    FreeBlock *freeList = nullptr;
+    std::size_t sizeClass;
+    // 已申请的 slab 及其大小
+    std::vector<std::pair<void *, std::size_t>> slabs;
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    // 当前线程的下一个池，用于输出统计信息
+    SlabPool *next;
+};
+
+/**
+ * @brief 获取当前线程中指定尺寸类的池
+ *
+ * @tparam SizeClass 块大小
+ * @return SlabPool& 线程局部的池
+ */
+template<std::size_t SizeClass>
+SlabPool &slabPool() {
+    static_assert(SizeClass % SLAB_GRANULE == 0 && SizeClass <= SLAB_PAGE_BYTES / 4, "object too large for a slab");
+    thread_local SlabPool pool(SizeClass);
+    return pool;
+}
+
+/**
+ * @brief 让类型 T 从 slab 池中分配的混入基类。
+ *
+ * 派生类继承 SlabAllocated<T> 后，new/delete（包括 make_ref 和 std::make_unique）都经过 sizeof(T) 所在尺寸类的池。
+ * 大小与 T 不同的派生类退回全局分配器。多态对象通过基类指针删除时，
+ * 虚析构函数会调用实际类型的 operator delete，因此只有实际类型继承本类的对象才进入池。
+ *
+ * @tparam T 派生类类型（CRTP）。
+ */
+template<typename T>
+class SlabAllocated {
+public:
+    static void *operator new(const std::size_t size) {
+        static_assert(alignof(T) <= SLAB_GRANULE, "slab blocks are only aligned to SLAB_GRANULE");
+        if (size != sizeof(T)) [[unlikely]] { return ::operator new(size); }
+        return slabPool<slabSizeClass(sizeof(T))>().allocate();
+    }
+
+    static void operator delete(void *pointer, const std::size_t size) noexcept {
+        if (size != sizeof(T)) [[unlikely]] { return ::operator delete(pointer); }
+        slabPool<slabSizeClass(sizeof(T))>().deallocate(pointer);
+    }
+};
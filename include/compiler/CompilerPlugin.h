@@ -0,0 +1,41 @@
+#pragma once
+
+// 解释器和代码生成插件之间的接口。这个头文件不能包含任何 LLVM 头文件：
+// 解释器只链接 LLVMSupport，LLVM 的代码生成库只链接进插件（liblox-compiler.so），
+// 在需要 JIT 或 AOT 编译时才用 dlopen 加载。
+
+// 接口有不兼容的修改时递增，加载时拒绝版本不同的插件
+constexpr unsigned COMPILER_PLUGIN_ABI_VERSION = 1;
+
+// 插件导出的入口函数名
+#define LOX_COMPILER_PLUGIN_ENTRY "loxCompilerPlugin"
+
+/**
+ * @brief 代码生成插件导出的函数表，由插件静态持有
+ */
+struct CompilerPlugin {
+    unsigned abiVersion;
+    // 插件链接的 LLVM 版本
+    const char *llvmVersion;
+    // 生成代码的目标三元组，例如 x86_64-pc-linux-gnu
+    const char *(*targetTriple)();
+    // 目标 CPU 名称
+    const char *(*hostCPU)();
+};
+
+/**
+ * @brief 插件入口函数的类型，C 链接避免名字修饰
+ */
+extern "C" {
+using CompilerPluginEntry = const CompilerPlugin *();
+}
+
+/**
+ * @brief 加载代码生成插件，只在第一次调用时 dlopen，之后返回同一个函数表
+ *
+ * 插件路径取环境变量 LOX_COMPILER_PLUGIN，未设置时取 lox 可执行文件所在目录下的 liblox-compiler.so。
+ * 加载失败时向诊断流输出原因。
+ *
+ * @return const CompilerPlugin* 插件的函数表；无法加载或版本不兼容时为 nullptr
+ */
+const CompilerPlugin *loadCompilerPlugin();
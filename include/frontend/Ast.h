@@ -1,10 +1,15 @@
 #pragma once
 // 引入工具类的头文件，提供一些通用的工具函数和类型定义
+#include "Lox/LoxObject.h"
+#include "Utils/SlabAllocator.h"
 #include "Utils/Utils.h"
 // 引入前端词法单元的头文件，定义了词法单元的类型和结构
 #include "frontend/Token.h"
+// 引入源码位置侧表，AST 节点只保存位置下标
+#include "frontend/SourceMap.h"
 // 引入智能指针相关的头文件，用于管理动态分配的内存
 #include <llvm/ADT/SmallVector.h>
+#include <future>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -90,6 +95,7 @@ class LogicalExpr;
 class UnaryExpr;
 class VarExpr;
 class AssignExpr;
+class InterpolationExpr;
 
 // 定义各种表达式结构体的智能指针类型，使用 std::unique_ptr 管理内存
 using BinaryExprPtr = std::unique_ptr<BinaryExpr>;
@@ -104,6 +110,7 @@ using LogicalExprPtr = std::unique_ptr<LogicalExpr>;
 using UnaryExprPtr = std::unique_ptr<UnaryExpr>;
 using VarExprPtr = std::unique_ptr<VarExpr>;
 using AssignExprPtr = std::unique_ptr<AssignExpr>;
+using InterpolationExprPtr = std::unique_ptr<InterpolationExpr>;
 
 /**
  * @brief 定义表达式的变体类型。
@@ -112,7 +119,7 @@ using AssignExprPtr = std::unique_ptr<AssignExpr>;
  */
 using Expr = std::variant<
     BinaryExprPtr, CallExprPtr, GetExprPtr, SetExprPtr, ThisExprPtr, SuperExprPtr, GroupingExprPtr, LiteralExprPtr,
-    LogicalExprPtr, UnaryExprPtr, VarExprPtr, AssignExprPtr>;
+    LogicalExprPtr, UnaryExprPtr, VarExprPtr, AssignExprPtr, InterpolationExprPtr>;
 
 /**
  * @brief 二元表达式类。
@@ -120,19 +127,20 @@ using Expr = std::variant<
  * 该类表示一个二元表达式，由左操作数、操作符和右操作数组成。
  * 继承自 Uncopyable 类，确保对象不可复制。
  */
-class BinaryExpr : Uncopyable {
+class BinaryExpr : Uncopyable, public SlabAllocated<BinaryExpr> {
 public:
     /**
      * @brief 构造函数，初始化二元表达式。
      * 
      * @param left 左操作数表达式。
-     * @param op 操作符词法单元。
+     * @param loc 操作符的源码位置。
+     * @param op 操作符。
      * @param right 右操作数表达式。
      */
-    explicit BinaryExpr(Expr left, const Token &token, const BinaryOp op, Expr right)
-        : left(std::move(left)), token{token}, op{op}, right{std::move(right)} {}
+    explicit BinaryExpr(Expr left, const SourceLoc loc, const BinaryOp op, Expr right)
+        : left(std::move(left)), loc{loc}, op{op}, right{std::move(right)} {}
     Expr left;
-    Token token;
+    SourceLoc loc;
     BinaryOp op;
     Expr right;
 };
@@ -142,12 +150,12 @@ public:
  * 
  * 该类继承自 Uncopyable，确保对象不可复制。它包含被调用的表达式、调用的关键字和参数列表。
  */
-class CallExpr : Uncopyable {
+class CallExpr : Uncopyable, public SlabAllocated<CallExpr> {
 public:
     // 被调用的表达式，通常是一个函数或方法
     Expr callee;
-    // 调用的关键字，例如函数名对应的词法单元
-    Token keyword;
+    // 调用的右括号所在的源码位置
+    SourceLoc loc;
     // 调用时传递的参数列表
     std::vector<Expr> arguments;
 
@@ -155,11 +163,11 @@ public:
      * @brief 构造函数，初始化调用表达式。
      * 
      * @param callee 被调用的表达式。
-     * @param keyword 调用的关键字。
+     * @param loc 调用的源码位置。
      * @param arguments 调用时传递的参数列表。
      */
-    explicit CallExpr(Expr callee, Token keyword, std::vector<Expr> arguments)
-        : callee{std::move(callee)}, keyword{keyword}, arguments{std::move(arguments)} {}
+    explicit CallExpr(Expr callee, const SourceLoc loc, std::vector<Expr> arguments)
+        : callee{std::move(callee)}, loc{loc}, arguments{std::move(arguments)} {}
 };
 
 
@@ -169,17 +177,18 @@ public:
  * 该类表示一个一元表达式，由操作符和右操作数组成。
  * 继承自 Uncopyable 类，确保对象不可复制。
  */
-class UnaryExpr : Uncopyable {
+class UnaryExpr : Uncopyable, public SlabAllocated<UnaryExpr> {
 public:
     /**
      * @brief 构造函数，初始化一元表达式。
      * 
-     * @param op 操作符词法单元。
-     * @param right 右操作数表达式。
+     * @param loc 操作符的源码位置。
+     * @param op 操作符。
+     * @param expression 操作数表达式。
      */
-   explicit UnaryExpr(const Token &token, const UnaryOp op, Expr expression)
-            : token{token}, op{op}, expression{std::move(expression)} {}
-    Token token;
+   explicit UnaryExpr(const SourceLoc loc, const UnaryOp op, Expr expression)
+            : loc{loc}, op{op}, expression{std::move(expression)} {}
+    SourceLoc loc;
     UnaryOp op;
     Expr expression;
 };
@@ -187,21 +196,52 @@ public:
 /**
  * @brief 字面量表达式类。
  * 
- * 该类表示一个字面量表达式，包含一个字面量值。
+ * 该类表示一个字面量表达式，包含一个预先转换好的运行时值。
  * 继承自 Uncopyable 类，确保对象不可复制。
  */
-class LiteralExpr : Uncopyable {
+class LiteralExpr : Uncopyable, public SlabAllocated<LiteralExpr> {
 public:
-    // 字面量值
-    Literal value;
+    // 字符串字面量的内容，value 借用它而不持有引用计数
+    std::string text;
+    // 构造时就转换好的运行时值，求值时直接复制，不再逐次转换字面量
+    LoxObject value;
 
 
     /**
      * @brief 构造函数，初始化字面量表达式。
      * 
+     * 构造和析构定义在 LoxObject.cpp 中，那里能看到运行时对象的完整定义。
+     * 
      * @param value 字面量值。
      */
-    explicit LiteralExpr(const Literal &value) : value(value) {}
+    explicit LiteralExpr(const Literal &value);
+    ~LiteralExpr();
+};
+
+/**
+ * @brief 插值字符串表达式类，例如 "id=${id} name=${name}"。
+ * 
+ * 字符串的各段与内嵌表达式交替出现：strings[0] expressions[0] strings[1] ... strings[n]，
+ * strings 比 expressions 多一个元素。整个插值字符串是一个节点，求值时一次性算出结果长度并只分配一次。
+ */
+class InterpolationExpr : Uncopyable, public SlabAllocated<InterpolationExpr> {
+public:
+    // 插值字符串开头的源码位置
+    SourceLoc loc;
+    // 字符串的各段，是源代码的视图
+    std::vector<std::string_view> strings;
+    // 内嵌的表达式
+    std::vector<Expr> expressions;
+
+    /**
+     * @brief 构造函数，初始化插值字符串表达式。
+     * 
+     * @param loc 插值字符串开头的源码位置。
+     * @param strings 字符串的各段。
+     * @param expressions 内嵌的表达式。
+     */
+    explicit InterpolationExpr(const SourceLoc loc, std::vector<std::string_view> strings, std::vector<Expr> expressions)
+        : loc{loc}, strings{std::move(strings)}, expressions{std::move(expressions)} {}
 };
 
 /**
@@ -210,7 +250,7 @@ public:
  * 该类表示一个分组表达式，通常由括号括起来的表达式。
  * 继承自 Uncopyable 类，确保对象不可复制。
  */
-class GroupingExpr : Uncopyable {
+class GroupingExpr : Uncopyable, public SlabAllocated<GroupingExpr> {
 public:
     // 分组内的表达式
     Expr expression;
@@ -232,8 +272,8 @@ public:
  */
 class Assignable : Uncopyable {
 public:
-    // 可赋值对象的名称词法单元
-    Token name;
+    // 可赋值对象的名称
+    Identifier name;
     // 作用域距离，用于作用域分析
     mutable signed long distance = -1;
     // 是否被捕获的标志，用于闭包分析
@@ -243,21 +283,21 @@ public:
     /**
      * @brief 构造函数，初始化可赋值对象。
      * 
-     * @param name 可赋值对象的名称词法单元。
+     * @param name 可赋值对象的名称。
      */
-    explicit Assignable(const Token &name) : name(name) {}
+    explicit Assignable(const Identifier &name) : name(name) {}
 };
 /**
  * @brief 获取表达式类，表示对对象属性的获取操作。
  * 
  * 该类继承自 Uncopyable，确保对象不可复制。它包含一个对象表达式和一个属性名的词法单元。
  */
-class GetExpr : private Uncopyable {
+class GetExpr : private Uncopyable, public SlabAllocated<GetExpr> {
 public:
     // 要获取属性的对象表达式
     Expr object;
-    // 属性名的词法单元
-    Token name;
+    // 属性名
+    Identifier name;
 
 
     /**
@@ -266,7 +306,7 @@ public:
      * @param object 要获取属性的对象表达式。
      * @param name 属性名的词法单元。
      */
-    explicit GetExpr(Expr object, const Token &name) : object{std::move(object)}, name{name} {}
+    explicit GetExpr(Expr object, const Identifier &name) : object{std::move(object)}, name{name} {}
 };
 
 /**
@@ -274,12 +314,12 @@ public:
  * 
  * 该类继承自 Uncopyable，确保对象不可复制。它包含一个对象表达式、一个属性名的词法单元和一个赋值的值表达式。
  */
-class SetExpr : Uncopyable {
+class SetExpr : Uncopyable, public SlabAllocated<SetExpr> {
 public:
     // 要设置属性的对象表达式
     Expr object;
-    // 属性名的词法单元
-    Token name;
+    // 属性名
+    Identifier name;
     // 要赋值的值表达式
     Expr value;
 
@@ -291,7 +331,7 @@ public:
      * @param name 属性名的词法单元。
      * @param value 要赋值的值表达式。
      */
-    explicit SetExpr(Expr object, const Token &name, Expr value)
+    explicit SetExpr(Expr object, const Identifier &name, Expr value)
         : object{std::move(object)}, name{name}, value{std::move(value)} {}
 };
 
@@ -300,14 +340,14 @@ public:
  * 
  * 该类继承自 Assignable，包含一个名称词法单元，用于表示当前对象。
  */
-class ThisExpr : public Assignable {
+class ThisExpr : public Assignable, public SlabAllocated<ThisExpr> {
 public:
     /**
      * @brief 构造函数，初始化 This 表达式。
      * 
      * @param name 表示当前对象的名称词法单元。
      */
-    explicit ThisExpr(const Token &name) : Assignable(name) {}
+    explicit ThisExpr(const Identifier &name) : Assignable(name) {}
 };
 
 /**
@@ -315,10 +355,10 @@ public:
  * 
  * 该类继承自 Assignable，包含一个名称词法单元和一个方法名的词法单元。
  */
-class SuperExpr : public Assignable {
+class SuperExpr : public Assignable, public SlabAllocated<SuperExpr> {
 public:
-    // 要调用的父类方法名的词法单元
-    Token method;
+    // 要调用的父类方法名
+    Identifier method;
 
 
     /**
@@ -327,7 +367,7 @@ public:
      * @param name 表示父类的名称词法单元。
      * @param method 要调用的父类方法名的词法单元。
      */
-    explicit SuperExpr(const Token &name, const Token &method) : Assignable(name), method{method} {}
+    explicit SuperExpr(const Identifier &name, const Identifier &method) : Assignable(name), method{method} {}
 };
 
 /**
@@ -335,7 +375,7 @@ public:
  * 
  * 该类继承自 Uncopyable，确保对象不可复制。它包含左操作数表达式、逻辑操作符和右操作数表达式。
  */
-class LogicalExpr : Uncopyable {
+class LogicalExpr : Uncopyable, public SlabAllocated<LogicalExpr> {
 public:
     // 左操作数表达式
     Expr left;
@@ -361,14 +401,14 @@ public:
  * 
  * 该类继承自 Assignable，包含一个名称词法单元，用于表示变量。
  */
-class VarExpr : public Assignable {
+class VarExpr : public Assignable, public SlabAllocated<VarExpr> {
 public:
     /**
      * @brief 构造函数，初始化变量表达式。
      * 
      * @param name 表示变量的名称词法单元。
      */
-    explicit VarExpr(const Token &name) : Assignable(name) {}
+    explicit VarExpr(const Identifier &name) : Assignable(name) {}
 };
 
 /**
@@ -376,7 +416,7 @@ public:
  * 
  * 该类继承自 Assignable，包含一个名称词法单元和一个赋值的值表达式。
  */
-class AssignExpr : public Assignable {
+class AssignExpr : public Assignable, public SlabAllocated<AssignExpr> {
 public:
     // 要赋值的值表达式
     Expr value;
@@ -388,7 +428,7 @@ public:
      * @param name 表示变量的名称词法单元。
      * @param value 要赋值的值表达式。
      */
-    AssignExpr(const Token &name, Expr value) : Assignable(name), value{std::move(value)} {}
+    AssignExpr(const Identifier &name, Expr value) : Assignable(name), value{std::move(value)} {}
 };
 
 // 前向声明各种语句类，以便在后续代码中使用指针类型
@@ -400,7 +440,12 @@ class PrintStmt;
 class VarStmt;
 class BlockStmt;
 class WhileStmt;
+class ForStmt;
 class ClassStmt;
+class TryStmt;
+class ImportStmt;
+// 闭包编译器生成的语句块，定义在 Lox/ClosureCompiler.h 中
+struct CompiledBlock;
 
 // 定义各种语句类的智能指针类型，使用 std::shared_ptr 管理内存
 using ExpressionStmtPtr = std::shared_ptr<ExpressionStmt>;
@@ -411,7 +456,10 @@ using PrintStmtPtr = std::shared_ptr<PrintStmt>;
 using VarStmtPtr = std::shared_ptr<VarStmt>;
 using BlockStmtPtr = std::shared_ptr<BlockStmt>;
 using WhileStmtPtr = std::shared_ptr<WhileStmt>;
+using ForStmtPtr = std::shared_ptr<ForStmt>;
 using ClassStmtPtr = std::shared_ptr<ClassStmt>;
+using TryStmtPtr = std::shared_ptr<TryStmt>;
+using ImportStmtPtr = std::shared_ptr<ImportStmt>;
 
 /**
  * @brief 定义语句的变体类型。
@@ -420,7 +468,7 @@ using ClassStmtPtr = std::shared_ptr<ClassStmt>;
  */
 using Stmt = std::variant<
     ExpressionStmtPtr, FunctionStmtPtr, ReturnStmtPtr, IfStmtPtr, PrintStmtPtr, VarStmtPtr, BlockStmtPtr, WhileStmtPtr,
-    ClassStmtPtr>;
+    ClassStmtPtr, TryStmtPtr, ForStmtPtr, ImportStmtPtr>;
 
 /**
  * @brief 定义语句列表类型。
@@ -480,14 +528,18 @@ public:
  */
 class FunctionStmt :public Uncopyable {
 public:
-    // 函数名的词法单元
-    Token name;
+    // 函数名
+    Identifier name;
     // 函数类型
     LoxFunctionType type;
     // 参数列表
-    std::vector<Token> parameters;
+    std::vector<Identifier> parameters;
     // 函数体语句列表
     StmtList body;
+    // 是否被纯度分析判定为可记忆化，由 Resolver 在 --auto-memoize 下设置
+    mutable bool memoize = false;
+    // 闭包编译执行方式下编译好的函数体，由 ClosureCompiler 设置
+    mutable std::shared_ptr<CompiledBlock> compiled;
 
 
     /**
@@ -498,7 +550,9 @@ public:
      * @param parameters 参数列表。
      * @param body 函数体语句列表。
      */
-    explicit FunctionStmt(Token name, const LoxFunctionType type, std::vector<Token> parameters, StmtList body)
+    explicit FunctionStmt(
+        const Identifier &name, const LoxFunctionType type, std::vector<Identifier> parameters, StmtList body
+    )
         : name{name}, type{type}, parameters{std::move(parameters)}, body{std::move(body)} {}
 };
 
@@ -509,19 +563,19 @@ public:
  */
 class ReturnStmt :public Uncopyable {
 public:
-    // 返回关键字的词法单元
-    Token keyword;
+    // 返回关键字的源码位置
+    SourceLoc loc;
     // 可选的返回表达式
     std::optional<Expr> expression;
     /**
      * @brief 构造函数，初始化返回语句。
      * 
-     * @param keyword 返回关键字的词法单元。
+     * @param loc 返回关键字的源码位置。
      * @param expression 可选的返回表达式。
      */
 
-    explicit ReturnStmt(const Token &keyword, std::optional<Expr> expression)
-        : keyword{keyword}, expression{std::move(expression)} {}
+    explicit ReturnStmt(const SourceLoc loc, std::optional<Expr> expression)
+        : loc{loc}, expression{std::move(expression)} {}
 };
 
 /**
@@ -549,8 +603,8 @@ public:
  */
 class VarStmt : public Uncopyable {
 public:
-    // 变量名的词法单元
-    Token name;
+    // 变量名
+    Identifier name;
     // 初始化表达式
     Expr initializer;
 
@@ -561,7 +615,7 @@ public:
      * @param name 变量名的词法单元。
      * @param initializer 初始化表达式。
      */
-    explicit VarStmt(const Token& name, Expr initializer) : name{name}, initializer{std::move(initializer)} {}
+    explicit VarStmt(const Identifier &name, Expr initializer) : name{name}, initializer{std::move(initializer)} {}
 };
 
 /**
@@ -590,6 +644,8 @@ public:
  */
 class WhileStmt : public Uncopyable {
 public:
+    // while 关键字的源码位置，用于报告执行预算耗尽
+    SourceLoc loc;
     // 循环条件表达式
     Expr condition;
     // 循环体语句
@@ -599,10 +655,51 @@ public:
     /**
      * @brief 构造函数，初始化 while 循环语句。
      * 
+     * @param loc while 关键字的源码位置。
      * @param condition 循环条件表达式。
      * @param body 循环体语句。
      */
-    WhileStmt(Expr condition, Stmt body) : condition{std::move(condition)}, body{std::move(body)} {}
+    WhileStmt(const SourceLoc loc, Expr condition, Stmt body)
+        : loc{loc}, condition{std::move(condition)}, body{std::move(body)} {}
+};
+
+/**
+ * @brief 循环语句类，表示 for 循环语句。
+ * 
+ * 该类继承自 Uncopyable，确保对象不可复制。与 while 不同，初始化语句中声明的循环变量
+ * 只存放在一个循环环境中，条件和增量表达式直接在该环境中求值，不再为每次迭代包一层代码块。
+ */
+class ForStmt : public Uncopyable {
+public:
+    // for 关键字的源码位置，用于报告执行预算耗尽
+    SourceLoc loc;
+    // 可选的初始化语句
+    std::optional<Stmt> initializer;
+    // 可选的循环条件表达式，缺省时视为 true
+    std::optional<Expr> condition;
+    // 可选的增量表达式
+    std::optional<Expr> increment;
+    // 循环体语句
+    Stmt body;
+    // 由 Resolver 设置：循环体中是否创建了闭包。未创建闭包时，解释器可以在迭代之间复用循环体的环境
+    mutable bool captured = false;
+
+
+    /**
+     * @brief 构造函数，初始化 for 循环语句。
+     * 
+     * @param loc for 关键字的源码位置。
+     * @param initializer 可选的初始化语句。
+     * @param condition 可选的循环条件表达式。
+     * @param increment 可选的增量表达式。
+     * @param body 循环体语句。
+     */
+    ForStmt(
+        const SourceLoc loc, std::optional<Stmt> initializer, std::optional<Expr> condition,
+        std::optional<Expr> increment, Stmt body
+    )
+        : loc{loc}, initializer{std::move(initializer)}, condition{std::move(condition)},
+          increment{std::move(increment)}, body{std::move(body)} {}
 };
 
 /**
@@ -612,8 +709,8 @@ public:
  */
 class ClassStmt {
 public:
-    // 类名的词法单元
-    Token name;
+    // 类名
+    Identifier name;
     // 可选的父类变量表达式
     std::optional<VarExprPtr> super_class;
     // 类方法列表
@@ -627,10 +724,67 @@ public:
      * @param super_class 可选的父类变量表达式。
      * @param methods 类方法列表。
      */
-    ClassStmt(const Token &name, std::optional<VarExprPtr> super_class, std::vector<FunctionStmtPtr> methods)
+    ClassStmt(const Identifier &name, std::optional<VarExprPtr> super_class, std::vector<FunctionStmtPtr> methods)
         : name{name}, super_class{std::move(super_class)}, methods{std::move(methods)} {}
 };
 
+/**
+ * @brief 异常捕获语句类，表示 try { ... } catch (e) { ... }。
+ * 
+ * 该类继承自 Uncopyable，确保对象不可复制。进入 try 块不需要登记任何处理器，
+ * 只有 try 块因运行时错误中止时，解释器才把错误信息绑定到 catch 变量并执行处理块。
+ */
+class TryStmt : public Uncopyable {
+public:
+    // try 块内的语句列表
+    StmtList body;
+    // catch 变量名
+    Identifier name;
+    // catch 块内的语句列表
+    StmtList handler;
+
+
+    /**
+     * @brief 构造函数，初始化异常捕获语句。
+     * 
+     * @param body try 块内的语句列表。
+     * @param name catch 变量名。
+     * @param handler catch 块内的语句列表。
+     */
+    TryStmt(StmtList body, const Identifier &name, StmtList handler)
+        : body{std::move(body)}, name{name}, handler{std::move(handler)} {}
+};
+
+// 解析完成的模块，定义在 frontend/ModuleLoader.h 中
+struct Module;
+// 模块加载结果，多个导入语句共享同一个工作线程的解析结果
+using ModuleFuture = std::shared_future<std::shared_ptr<const Module>>;
+
+/**
+ * @brief 模块导入语句类，表示 import "path";。
+ * 
+ * 该类继承自 Uncopyable，确保对象不可复制。解析结束后由 ModuleLoader 为每条导入语句启动加载，
+ * 解释器执行到这条语句时才等待加载结果，因此互不依赖的模块可以在工作线程上并行扫描、解析和变量解析。
+ */
+class ImportStmt : public Uncopyable {
+public:
+    // import 关键字的源码位置，用于报告加载失败
+    SourceLoc loc;
+    // 模块路径，相对于导入它的文件所在目录
+    std::string_view path;
+    // 由 ModuleLoader 设置的加载结果
+    ModuleFuture module;
+
+
+    /**
+     * @brief 构造函数，初始化模块导入语句。
+     * 
+     * @param loc import 关键字的源码位置。
+     * @param path 模块路径。
+     */
+    ImportStmt(const SourceLoc loc, const std::string_view path) : loc{loc}, path{path} {}
+};
+
 /**
  * @brief 程序类型定义，表示一个程序由一组语句组成。
  * 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "frontend/Ast.h"
+#include "frontend/Scanner.h"
+#include <filesystem>
+#include <llvm/Support/ThreadPool.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 一个解析完成的模块
+ *
+ * 模块的 AST 引用扫描器中的源码（字符串字面量是源码的视图），因此扫描器和语句列表一起保存。
+ * 扫描、解析或变量解析失败时 error 非空，statements 不可执行。
+ */
+struct Module {
+    // 规范化后的绝对路径，也是缓存的键
+    std::string path;
+    std::unique_ptr<Scanner> scanner;
+    StmtList statements;
+    // 在加载线程上预先编译的闭包，未启用 precompile 时为空
+    std::shared_ptr<CompiledBlock> compiled;
+    // 模块自己的导入语句
+    std::vector<ImportStmtPtr> imports;
+    // 加载失败的原因，成功时为空
+    std::string error;
+};
+
+/**
+ * @brief 模块加载器（进程内单例）
+ *
+ * 每个模块按规范化路径在进程内只扫描、解析和变量解析一次，结果缓存在 shared_future 中；
+ * 同一个模块被多次导入（菱形依赖、循环依赖）时共享同一份结果。
+ * 加载在工作线程池中进行：模块解析完成后立即为它的导入语句启动加载，互不依赖的模块并行处理，
+ * 工作线程之间从不互相等待，只有解释器执行到 import 语句时才等待结果。
+ */
+class ModuleLoader {
+public:
+    // 是否对模块中的纯递归函数自动记忆化，与主程序的 --auto-memoize 一致
+    bool autoMemoize = false;
+    // 是否在加载线程上把模块编译为闭包（--engine=closure）。多个线程上的解释器共享模块时必须开启，
+    // 否则它们会在第一次执行时同时写入函数声明的编译结果
+    bool precompile = false;
+
+    /**
+     * @brief 获取单例。有意不析构：进程退出时由 atexit 等待仍在运行的加载任务
+     */
+    static ModuleLoader &instance();
+
+    /**
+     * @brief 启动加载一个模块；已经加载过（或正在加载）的模块直接返回缓存的结果
+     *
+     * @param path 模块路径
+     * @return ModuleFuture 加载结果
+     */
+    ModuleFuture load(const std::filesystem::path &path);
+
+    /**
+     * @brief 为一组导入语句启动加载，结果写入每条语句的 module 字段
+     *
+     * @param imports 导入语句
+     * @param directory 导入这些模块的文件所在目录，相对路径以它为基准
+     */
+    void loadImports(const std::vector<ImportStmtPtr> &imports, const std::filesystem::path &directory);
+
+    /**
+     * @brief 等待一组导入语句直接和间接导入的所有模块加载完成，并输出其中加载失败的模块
+     *
+     * 只检查这组导入能到达的模块，批处理模式中其他脚本导入失败的模块不影响当前脚本。
+     *
+     * @param imports 导入语句，必须已经由 loadImports 启动加载
+     * @return bool 这些模块是否都加载成功
+     */
+    bool waitFor(const std::vector<ImportStmtPtr> &imports);
+
+    /**
+     * @brief 在当前线程上编译一段不进入缓存的源码，并等待它导入的模块加载完成
+     *
+     * @param source 源码
+     * @param name 用于错误信息的名字
+     * @param directory 相对导入路径的基准目录
+     * @return std::shared_ptr<const Module> 编译结果，失败时 error 非空
+     */
+    std::shared_ptr<const Module> compile(std::string source, const std::string &name, const std::filesystem::path &directory);
+
+private:
+    std::mutex mutex;
+    // 按规范化路径缓存的加载结果
+    std::unordered_map<std::string, ModuleFuture> modules;
+    llvm::ThreadPool pool;
+
+    ModuleLoader() = default;
+
+    // 在工作线程上读取并编译一个模块
+    std::shared_ptr<const Module> parse(const std::string &path);
+
+    // 扫描、解析和变量解析，并启动模块自己的导入
+    void build(Module &module, std::string source, const std::filesystem::path &directory);
+};
@@ -30,6 +30,8 @@ private:
     std::vector<Token> tokens;
     // 当前处理的词法单元的索引
     int current = 0;
+    // 解析过程中遇到的所有导入语句，供 ModuleLoader 在解析结束后立即启动加载
+    std::vector<ImportStmtPtr> imports;
 
     using parserFn = Expr (Parser::*)();
     /**
@@ -130,6 +132,13 @@ private:
      */
     Expr primary();
 
+    /**
+     * @brief 解析插值字符串，第一个 INTERPOLATION 词法单元已经被消耗。
+     * 
+     * @return Expr 解析得到的插值字符串表达式。
+     */
+    Expr interpolation();
+
     /**
      * @brief 消耗一个指定类型的词法单元，如果当前词法单元类型匹配则前进到下一个词法单元，否则报错。
      * 
@@ -202,6 +211,24 @@ private:
      */
     WhileStmtPtr whileStatement();
 
+    /**
+     * @brief 解析 try/catch 语句。
+     * 
+     * 该函数负责解析 try 块、catch 变量和 catch 块，并返回一个指向 TryStmt 的智能指针。
+     * 
+     * @return TryStmtPtr 解析得到的 try/catch 语句的智能指针。
+     */
+    TryStmtPtr tryStatement();
+
+    /**
+     * @brief 解析 import 语句。
+     * 
+     * 该函数负责解析 import 关键字之后的模块路径字符串和分号，并返回一个指向 ImportStmt 的智能指针。
+     * 
+     * @return ImportStmtPtr 解析得到的 import 语句的智能指针。
+     */
+    ImportStmtPtr importStatement();
+
     /**
      * @brief 解析语句，可能是各种类型的语句。
      * 
@@ -347,6 +374,13 @@ public:
 
     Program parse();
 
+    /**
+     * @brief 获取已解析程序中的所有导入语句，包括嵌套在代码块和函数体中的。
+     * 
+     * @return const std::vector<ImportStmtPtr>& 导入语句列表。
+     */
+    [[nodiscard]] const std::vector<ImportStmtPtr> &importStatements() const { return imports; }
+
     static ParseError error(const Token &token, const std::string &message) {
         loxerror(token, message);
         return ParseError{message};
@@ -1,6 +1,9 @@
+#pragma once
 #include "frontend/Ast.h"
 #include "Error/Error.h"
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 /**
  * @brief 解析器类，用于解析代码中的作用域和变量声明
@@ -35,6 +38,35 @@ class Resolver {
     // 当前类的类型，初始为不在类中
     ClassType currentClass = ClassType::NONE;
 
+    /**
+     * @brief 纯度分析中的候选函数
+     *
+     * 记录一个顶层函数在解析过程中读取的全局名字。只有当这些名字全部指向同样纯的函数时，
+     * 该函数才会被记忆化。
+     */
+    struct PurityCandidate {
+        FunctionStmtPtr function;
+        // 函数体是否仍然满足纯度要求
+        bool pure = true;
+        // 函数体中读取的全局名字
+        std::vector<std::string_view> globals;
+    };
+
+    // 是否开启 --auto-memoize 纯度分析
+    bool autoMemoize = false;
+    // 当前正在分析的顶层函数
+    std::optional<PurityCandidate> analyzing;
+    // 已完成分析、等待在程序解析结束后确认的候选函数
+    std::vector<PurityCandidate> candidates;
+    // 顶层名字被定义的次数，被重复定义的函数不能记忆化
+    std::unordered_map<std::string_view, int> globalDefinitions;
+    // 程序中任何位置被赋值过的全局名字
+    std::unordered_set<std::string_view> globalAssignments;
+    // 最终被记忆化的函数名
+    std::vector<std::string_view> memoized;
+    // 已解析的函数（包括方法）数量，用于判断 for 循环体中是否创建了闭包
+    unsigned int closureCount = 0;
+
     /**
      * @brief 开始一个新的作用域
      * 
@@ -54,18 +86,18 @@ class Resolver {
      * 
      * 该函数在当前作用域中声明一个变量，并将其标记为未定义。
      * 
-     * @param name 变量的 Token 对象
+     * @param name 变量名
      */
-    void declare(const Token &name);
+    void declare(const Identifier &name);
 
     /**
      * @brief 定义一个变量
      * 
      * 该函数在当前作用域中定义一个变量，即将其标记为已定义。
      * 
-     * @param name 变量的 Token 对象
+     * @param name 变量名
      */
-    void define(const Token &name);
+    void define(const Identifier &name);
 
     /**
      * @brief 解析局部变量的作用域
@@ -73,9 +105,9 @@ class Resolver {
      * 该函数确定局部变量在作用域栈中的位置。
      * 
      * @param expr 可赋值表达式，包含变量的作用域信息
-     * @param name 变量的 Token 对象
+     * @param name 变量名
      */
-    void resolveLocal(const Assignable &expr, const Token &name) const;
+    void resolveLocal(const Assignable &expr, const Identifier &name) const;
 
     /**
      * @brief 解析函数声明
@@ -87,8 +119,44 @@ class Resolver {
      */
     void resolveFunction(const FunctionStmtPtr &function, const LoxFunctionType functionType);
 
+    /**
+     * @brief 记录一个顶层名字的定义
+     *
+     * @param name 顶层名字
+     */
+    void defineGlobal(const Identifier &name);
+
+    /**
+     * @brief 将当前正在分析的函数标记为不纯
+     *
+     * 函数体中出现 I/O、实例读写、闭包或全局写入时调用。
+     */
+    void markImpure();
+
+    /**
+     * @brief 完成纯度分析
+     *
+     * 在整个程序解析结束后，剔除被重新赋值或依赖不纯全局名字的候选函数，
+     * 并为剩余的函数打上记忆化标记。
+     */
+    void finishMemoization();
+
 
     public:
+        /**
+         * @brief 构造函数
+         *
+         * @param autoMemoize 是否对纯的顶层函数进行纯度分析并自动记忆化
+         */
+        explicit Resolver(const bool autoMemoize = false) : autoMemoize{autoMemoize} {}
+
+        /**
+         * @brief 获取被自动记忆化的函数名列表
+         *
+         * @return const std::vector<std::string_view>& 函数名列表
+         */
+        [[nodiscard]] const std::vector<std::string_view> &memoizedFunctions() const { return memoized; }
+
         void operator()(const BlockStmtPtr &blockStmt);
 
         void operator()(const FunctionStmtPtr &functionStmt);
@@ -103,8 +171,12 @@ class Resolver {
 
         void operator()(const WhileStmtPtr &whileStmt);
 
+        void operator()(const ForStmtPtr &forStmt);
+
         void operator()(const IfStmtPtr &ifStmt);
         void operator()(const ClassStmtPtr &classStmt);
+        void operator()(const TryStmtPtr &tryStmt);
+        void operator()(const ImportStmtPtr &importStmt);
 
         void operator()(const AssignExprPtr &assignExpr) ;
 
@@ -115,14 +187,16 @@ class Resolver {
         void operator()(const GetExprPtr &getExpr) ;
         void operator()(const SetExprPtr &setExpr);
 
-        void operator()(const ThisExprPtr &thisExpr) const;
-        void operator()(const SuperExprPtr &superExpr) const ;
+        void operator()(const ThisExprPtr &thisExpr);
+        void operator()(const SuperExprPtr &superExpr);
         void operator()(const VarExprPtr &varExpr) ;
 
         void operator()(const GroupingExprPtr &groupingExpr) ;
 
         void operator()(const LiteralExprPtr &) const;
 
+        void operator()(const InterpolationExprPtr &interpolationExpr);
+
         void operator()(const LogicalExprPtr &logicalExpr) ;
 
         void operator()(const UnaryExprPtr &unaryExpr);
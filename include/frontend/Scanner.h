@@ -1,3 +1,4 @@
+#pragma once
 // 引入LLVM的SmallVector容器，用于高效存储少量元素
 #include <llvm/ADT/SmallVector.h>
 // 引入LLVM的StringRef类，用于高效处理字符串引用
@@ -27,6 +28,10 @@ private:
     int current = 0;
     // 当前扫描到的行号
     int line = 1;
+    // 当前行第一个字符的位置，用于计算列号
+    int lineStart = 0;
+    // 正在扫描的插值表达式的栈，每项是该表达式内尚未闭合的左花括号个数
+    llvm::SmallVector<int, 4> interpolationBraces;
     // 标记扫描过程中是否发生错误
     //bool hadError = false;
 
@@ -48,6 +53,7 @@ private:
     char peek();
     char peekNext();
     void loxstring();
+    void stringPart(int contentStart);
     void loxnumber();
     void identifier();
 
@@ -64,5 +70,14 @@ public:
      */
     std::vector<Token> scanTokens();
 
-    explicit Scanner(std::string Source) : source{std::move(Source)} {}
+    /**
+     * @brief 获取源代码，词法单元的词素都是它的视图
+     */
+    [[nodiscard]] const std::string &getSource() const { return source; }
+
+    /**
+     * @param Source 源代码
+     * @param firstLine 第一行的行号，REPL 中每次输入从上一次的下一行开始编号
+     */
+    explicit Scanner(std::string Source, const int firstLine = 1) : source{std::move(Source)}, line{firstLine} {}
 };
\ No newline at end of file
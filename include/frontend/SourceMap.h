@@ -0,0 +1,220 @@
+#pragma once
+#include "frontend/Token.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief 源码位置在 SourceMap 侧表中的下标。
+ *
+ * AST 节点只保存这个 32 位下标，行号、列号和词素只在报告错误时从侧表中取出。
+ * 最高位为 1 时表示位置属于一个可释放的段（见 SourceMap::Segment），其后 7 位是段的编号，低 24 位是段内下标。
+ * 使用强类型枚举，避免与行号等普通整数混用。
+ */
+enum class SourceLoc : std::uint32_t {};
+
+/**
+ * @brief 侧表中保存的一条源码位置信息。
+ */
+struct SourceLocation {
+    // 所在行号
+    unsigned int line;
+    // 所在列号，从 1 开始
+    unsigned int column;
+    // 该位置的词素，指向驻留字符串
+    std::string_view lexeme;
+};
+
+/**
+ * @brief 源码位置侧表与标识符驻留池。
+ *
+ * 解析器为每个需要报告错误的词法单元登记一条位置信息，并把标识符驻留为全进程共享的字符串，
+ * 使 AST 节点只需保存一个 SourceLoc 和一个 std::string_view，而不必拷贝整个 Token。
+ *
+ * 模块在多个工作线程上并行解析，所有操作都由一把互斥锁保护；查询只在报告错误时发生，按值返回，
+ * 不会因为其他线程登记新位置导致 vector 扩容而失效。
+ *
+ * 默认登记的内容在进程生命周期内有效。长期运行的服务为每个请求开启一个段，请求期间本线程登记的位置和
+ * 驻留的字符串都放进段里，请求结束后随段一起释放，侧表不会随请求数增长。
+ */
+class SourceMap {
+public:
+    /**
+     * @brief 可释放的段，在作用域内收集当前线程登记的位置和驻留的字符串
+     *
+     * 析构时释放段中的所有内容，因此段内登记的 SourceLoc 和字符串视图（包括引用它们的 AST、解释器和运行时对象）
+     * 都不能活得比段更久。段可以嵌套，析构时恢复外层的段。段用完或单个段登记满时退回到永久的侧表，只是不再释放。
+     */
+    class Segment {
+    public:
+        Segment() : outer{current} { current = SourceMap::instance().acquire(); }
+        ~Segment() {
+            SourceMap::instance().release(current);
+            current = outer;
+        }
+
+        Segment(const Segment &) = delete;
+        Segment &operator=(const Segment &) = delete;
+
+    private:
+        // 外层段的编号加一，0 表示没有段
+        std::uint32_t outer;
+    };
+
+    /**
+     * @brief 获取全局唯一的侧表实例。
+     *
+     * @return SourceMap& 侧表实例
+     */
+    static SourceMap &instance() {
+        // 有意不析构：进程退出时工作线程可能仍在解析模块
+        static auto *sourceMap = new SourceMap();
+        return *sourceMap;
+    }
+
+    /**
+     * @brief 驻留一个字符串，返回在进程生命周期（或当前段）内有效的视图。
+     *
+     * @param text 要驻留的字符串
+     * @return std::string_view 驻留后的字符串视图
+     */
+    std::string_view intern(const std::string_view text) {
+        std::lock_guard lock(mutex);
+        return internLocked(text);
+    }
+
+    /**
+     * @brief 查找已经驻留的字符串，不驻留新的字符串。
+     *
+     * @param text 要查找的字符串
+     * @return std::optional<std::string_view> 永久池或当前段中的视图，没有驻留过时为 std::nullopt
+     */
+    std::optional<std::string_view> find(const std::string_view text) const {
+        std::lock_guard lock(mutex);
+        if (const auto it = symbols.find(text); it != symbols.end()) { return *it; }
+        if (current == 0) { return std::nullopt; }
+        const auto &segment = segments[current - 1].symbols;
+        if (const auto it = segment.find(text); it != segment.end()) { return *it; }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief 为词法单元登记一条位置信息。
+     *
+     * @param token 词法单元
+     * @return SourceLoc 位置信息在侧表中的下标
+     */
+    SourceLoc add(const Token &token) {
+        std::lock_guard lock(mutex);
+        const SourceLocation location{token.getLine(), token.getColumn(), internLocked(token.getLexeme())};
+        if (current != 0 && segments[current - 1].locations.size() < SEGMENT_CAPACITY) {
+            auto &segment = segments[current - 1].locations;
+            segment.push_back(location);
+            return static_cast<SourceLoc>(SEGMENT_FLAG | (current - 1) << SEGMENT_SHIFT | (segment.size() - 1));
+        }
+        locations.push_back(location);
+        return static_cast<SourceLoc>(locations.size() - 1);
+    }
+
+    /**
+     * @brief 根据下标取出位置信息。
+     *
+     * @param loc 位置信息的下标
+     * @return SourceLocation 位置信息
+     */
+    [[nodiscard]] SourceLocation lookup(const SourceLoc loc) const {
+        std::lock_guard lock(mutex);
+        const auto index = static_cast<std::uint32_t>(loc);
+        if ((index & SEGMENT_FLAG) == 0) { return locations[index]; }
+        return segments[(index & ~SEGMENT_FLAG) >> SEGMENT_SHIFT].locations[index & (SEGMENT_CAPACITY - 1)];
+    }
+
+private:
+    SourceMap() = default;
+
+    static constexpr std::uint32_t SEGMENT_FLAG = 1U << 31;
+    static constexpr unsigned SEGMENT_SHIFT = 24;
+    static constexpr std::uint32_t SEGMENT_CAPACITY = 1U << SEGMENT_SHIFT;
+    static constexpr std::size_t MAX_SEGMENTS = 128;
+
+    // 驻留池的哈希，支持直接用 std::string_view 查找
+    struct SymbolHash {
+        using is_transparent = void;
+        std::size_t operator()(const std::string_view text) const noexcept { return std::hash<std::string_view>{}(text); }
+    };
+    using SymbolSet = std::unordered_set<std::string, SymbolHash, std::equal_to<>>;
+
+    // 一个段登记的内容
+    struct SegmentData {
+        std::vector<SourceLocation> locations;
+        SymbolSet symbols;
+        bool used = false;
+    };
+
+    // 按登记顺序保存的位置信息
+    std::vector<SourceLocation> locations;
+    // 驻留字符串池，unordered_set 的节点地址稳定，视图不会失效
+    SymbolSet symbols;
+    // 可释放的段
+    std::array<SegmentData, MAX_SEGMENTS> segments;
+    // 保护以上容器
+    mutable std::mutex mutex;
+    // 当前线程正在使用的段的编号加一，0 表示没有段
+    static inline thread_local std::uint32_t current = 0;
+
+    // 在持有锁时驻留字符串：永久池中已有的直接复用，否则放进当前段
+    std::string_view internLocked(const std::string_view text) {
+        if (current == 0) { return *symbols.emplace(text).first; }
+        if (const auto it = symbols.find(text); it != symbols.end()) { return *it; }
+        return *segments[current - 1].symbols.emplace(text).first;
+    }
+
+    // 分配一个空闲的段，返回编号加一；没有空闲的段时返回 0
+    std::uint32_t acquire() {
+        std::lock_guard lock(mutex);
+        for (std::uint32_t i = 0; i < MAX_SEGMENTS; i++) {
+            if (!segments[i].used) {
+                segments[i].used = true;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    // 释放一个段的全部内容
+    void release(const std::uint32_t segment) {
+        if (segment == 0) { return; }
+        std::lock_guard lock(mutex);
+        segments[segment - 1] = SegmentData{};
+    }
+};
+
+/**
+ * @brief AST 中的标识符：驻留后的名字加上源码位置下标。
+ *
+ * 用于变量、字段、函数、类等需要在运行时按名字查找的节点。
+ */
+class Identifier {
+private:
+    // 名字在源码中的位置
+    SourceLoc loc;
+    // 驻留后的名字
+    std::string_view lexeme;
+
+public:
+    /**
+     * @brief 从词法单元构造标识符，并在侧表中登记其位置。
+     *
+     * @param token 标识符对应的词法单元
+     */
+    explicit Identifier(const Token &token)
+        : loc{SourceMap::instance().add(token)}, lexeme{SourceMap::instance().lookup(loc).lexeme} {}
+
+    [[nodiscard]] std::string_view getLexeme() const { return lexeme; }
+    [[nodiscard]] SourceLoc getLoc() const { return loc; }
+};
@@ -41,6 +41,7 @@ enum TokenType {
     IDENTIFIER,// 标识符，如变量名、函数名等
     STRING,    // 字符串字面量
     NUMBER,    // 数字字面量
+    INTERPOLATION, // 插值字符串中 "${" 之前的一段，字面量为这一段的内容
 
     // Keywords.
     AND,   // 逻辑与 'and'
@@ -59,6 +60,9 @@ enum TokenType {
     TRUE,  // 布尔值 'true'
     VAR,   // 变量声明关键字 'var'
     WHILE, // 循环语句 'while'
+    TRY,   // 异常捕获语句 'try'
+    CATCH, // 异常处理分支 'catch'
+    IMPORT,// 模块导入语句 'import'
 
     LoxEOF// 文件结束符
 };
@@ -76,6 +80,7 @@ private:
     std::string lexeme;            // 词法单元的词素，即源代码中的实际字符序列
     Literal literal;// 在C++中，通常需要具体指定类型，这里假设literal为std::string
     unsigned int line;             // 词法单元所在的行号
+    unsigned int column;           // 词法单元在行内的列号，从 1 开始
 
 public:
     /**
@@ -85,9 +90,13 @@ public:
      * @param lexeme 词法单元的词素。
      * @param literal 词法单元的字面量值。
      * @param line 词法单元所在的行号。
+     * @param column 词法单元在行内的列号。
      */
-    explicit Token(const TokenType type, const std::string_view lexeme, const Literal &literal, const unsigned int line)
-        : type{type}, lexeme{lexeme}, literal{literal}, line{line} {}
+    explicit Token(
+        const TokenType type, const std::string_view lexeme, const Literal &literal, const unsigned int line,
+        const unsigned int column = 0
+    )
+        : type{type}, lexeme{lexeme}, literal{literal}, line{line}, column{column} {}
     [[nodiscard]] TokenType getType() const { return type; }
     // 转换 literal 为字符串
     static std::string literal_to_string(const Literal &literal);
@@ -121,6 +130,13 @@ public:
      */
     [[nodiscard]] unsigned int getLine() const { return line; }
 
+    /**
+     * @brief 获取词法单元在行内的列号。
+     *
+     * @return unsigned int 词法单元的列号，从 1 开始。
+     */
+    [[nodiscard]] unsigned int getColumn() const { return column; }
+
     /**
      * @brief 获取词法单元的词素。
      * 
@@ -0,0 +1,509 @@
+#include "Lox/ClosureCompiler.h"
+#include "Lox/Environment.h"
+#include "Lox/LoxClass.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxObject.h"
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/raw_ostream.h>
+#include <string>
+#include <utility>
+
+/**
+ * @brief 编译一个语句列表。
+ *
+ * @param statements 语句列表。
+ * @return std::shared_ptr<CompiledBlock> 编译后的语句块。
+ */
+std::shared_ptr<CompiledBlock> ClosureCompiler::compile(const StmtList &statements) {
+    auto block = std::make_shared<CompiledBlock>();
+    block->statements.reserve(statements.size());
+    for (const auto &statement: statements) { block->statements.push_back(compile(statement)); }
+    return block;
+}
+
+/**
+ * @brief 编译一个表达式，按节点类型分派到对应的 operator()。
+ *
+ * @param expr 表达式。
+ * @return CompiledExpr 编译后的表达式。
+ */
+CompiledExpr ClosureCompiler::compile(const Expr &expr) { return std::visit(*this, expr); }
+
+/**
+ * @brief 编译一条语句，按节点类型分派到对应的 operator()。
+ *
+ * @param stmt 语句。
+ * @return CompiledStmt 编译后的语句。
+ */
+CompiledStmt ClosureCompiler::compile(const Stmt &stmt) { return std::visit(*this, stmt); }
+
+/**
+ * @brief 编译函数体，结果保存在 FunctionStmt 上。
+ *
+ * 同一个函数声明只编译一次；LoxFunction 调用时发现 compiled 不为空就执行编译结果。
+ *
+ * @param functionStmt 函数声明。
+ */
+void ClosureCompiler::compileFunction(const FunctionStmtPtr &functionStmt) {
+    if (functionStmt->compiled == nullptr) { functionStmt->compiled = compile(functionStmt->body); }
+}
+
+/**
+ * @brief 编译表达式语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const ExpressionStmtPtr &expressionStmt) {
+    return [expression = compile(expressionStmt->expression)](Interpreter &in) -> StmtResult {
+        expression(in);
+        if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+        return Nothing{};
+    };
+}
+
+/**
+ * @brief 编译 if 语句，没有 else 分支时生成更短的闭包。
+ */
+CompiledStmt ClosureCompiler::operator()(const IfStmtPtr &ifStmt) {
+    auto condition = compile(ifStmt->condition);
+    auto thenBranch = compile(ifStmt->thenBranch);
+    if (!ifStmt->elseBranch.has_value()) {
+        return [condition = std::move(condition), thenBranch = std::move(thenBranch)](Interpreter &in) -> StmtResult {
+            const auto value = condition(in);
+            if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+            if (isTruthy(value)) { return thenBranch(in); }
+            return Nothing{};
+        };
+    }
+    return [condition = std::move(condition), thenBranch = std::move(thenBranch),
+            elseBranch = compile(ifStmt->elseBranch.value())](Interpreter &in) -> StmtResult {
+        const auto value = condition(in);
+        if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+        return isTruthy(value) ? thenBranch(in) : elseBranch(in);
+    };
+}
+
+/**
+ * @brief 编译打印语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const PrintStmtPtr &printStmt) {
+    return [expression = compile(printStmt->expression)](Interpreter &in) -> StmtResult {
+        const auto object = expression(in);
+        if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+        *in.output << to_string(object) << "\n";
+        return Nothing{};
+    };
+}
+
+/**
+ * @brief 编译变量声明语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const VarStmtPtr &varStmt) {
+    return [name = varStmt->name.getLexeme(), initializer = compile(varStmt->initializer)](Interpreter &in) -> StmtResult {
+        auto value = initializer(in);
+        if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+        in.environment->define(name, value);
+        return Nothing{};
+    };
+}
+
+/**
+ * @brief 编译函数声明：编译函数体，运行时只需创建 LoxFunction。
+ */
+CompiledStmt ClosureCompiler::operator()(const FunctionStmtPtr &functionStmt) {
+    compileFunction(functionStmt);
+    return [functionStmt](Interpreter &in) -> StmtResult {
+        in.environment->define(functionStmt->name.getLexeme(), make_ref<LoxFunction>(functionStmt, in.environment));
+        return Nothing{};
+    };
+}
+
+/**
+ * @brief 编译返回语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const ReturnStmtPtr &returnStmt) {
+    if (!returnStmt->expression.has_value()) {
+        return [](Interpreter &) -> StmtResult { return Return{LoxNil()}; };
+    }
+    return [expression = compile(returnStmt->expression.value())](Interpreter &in) -> StmtResult {
+        auto value = expression(in);
+        if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+        return Return{std::move(value)};
+    };
+}
+
+/**
+ * @brief 编译代码块语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const BlockStmtPtr &blockStmt) {
+    return [block = compile(blockStmt->statements)](Interpreter &in) -> StmtResult {
+        return in.executeCompiled(*block, make_ref<Environment>(in.environment));
+    };
+}
+
+/**
+ * @brief 编译 while 循环语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const WhileStmtPtr &whileStmt) {
+    return [loc = whileStmt->loc, condition = compile(whileStmt->condition),
+            body = compile(whileStmt->body)](Interpreter &in) -> StmtResult {
+        while (true) {
+            const auto value = condition(in);
+            if (in.unwinding()) [[unlikely]] { return Unwind{}; }
+            if (!isTruthy(value)) { break; }
+            if (auto result = body(in);
+                std::holds_alternative<Return>(result) || std::holds_alternative<Unwind>(result)) {
+                return result;
+            }
+            // 循环回边是安全点
+            if (!in.safepoint(loc)) [[unlikely]] { return Unwind{}; }
+        }
+        return Nothing{};
+    };
+}
+
+/**
+ * @brief 编译 for 循环语句。
+ *
+ * 语义与 Interpreter 中的 ForStmt 相同：循环变量只有一个环境；循环体是代码块且没有闭包时复用循环体环境。
+ */
+CompiledStmt ClosureCompiler::operator()(const ForStmtPtr &forStmt) {
+    CompiledStmt initializer = forStmt->initializer.has_value() ? compile(forStmt->initializer.value()) : nullptr;
+    CompiledExpr condition = forStmt->condition.has_value() ? compile(forStmt->condition.value()) : nullptr;
+    CompiledExpr increment = forStmt->increment.has_value() ? compile(forStmt->increment.value()) : nullptr;
+    // 可以复用环境的循环体单独编译为语句块，由循环直接执行
+    const BlockStmtPtr *blockStmt = forStmt->captured ? nullptr : std::get_if<BlockStmtPtr>(&forStmt->body);
+    std::shared_ptr<CompiledBlock> block = blockStmt != nullptr ? compile((*blockStmt)->statements) : nullptr;
+    CompiledStmt body = block == nullptr ? compile(forStmt->body) : nullptr;
+
+    return [loc = forStmt->loc, initializer = std::move(initializer), condition = std::move(condition),
+            increment = std::move(increment), block = std::move(block), body = std::move(body)](Interpreter &in) -> StmtResult {
+        // 保存原来的环境，并创建循环环境
+        const auto previous = in.environment;
+        in.environment = make_ref<Environment>(previous);
+        const EnvironmentPtr bodyEnvironment = block != nullptr ? make_ref<Environment>(in.environment) : nullptr;
+
+        StmtResult result = Nothing{};
+        if (initializer && std::holds_alternative<Unwind>(initializer(in))) [[unlikely]] { result = Unwind{}; }
+
+        while (!std::holds_alternative<Unwind>(result)) {
+            if (condition) {
+                const auto value = condition(in);
+                if (in.unwinding()) [[unlikely]] {
+                    result = Unwind{};
+                    break;
+                }
+                if (!isTruthy(value)) { break; }
+            }
+
+            StmtResult bodyResult = Nothing{};
+            if (block != nullptr) {
+                bodyEnvironment->clear();
+                bodyResult = in.executeCompiled(*block, bodyEnvironment);
+            } else {
+                bodyResult = body(in);
+            }
+            if (std::holds_alternative<Return>(bodyResult) || std::holds_alternative<Unwind>(bodyResult)) {
+                result = std::move(bodyResult);
+                break;
+            }
+
+            if (increment) {
+                increment(in);
+                if (in.unwinding()) [[unlikely]] {
+                    result = Unwind{};
+                    break;
+                }
+            }
+
+            // 循环回边是安全点
+            if (!in.safepoint(loc)) [[unlikely]] { result = Unwind{}; }
+        }
+
+        // 恢复原来的环境
+        in.environment = previous;
+        return result;
+    };
+}
+
+/**
+ * @brief 编译类声明：编译每个方法的函数体，类对象的创建交给 Interpreter。
+ *
+ * 类声明只在定义时执行一次，不在热路径上。
+ */
+CompiledStmt ClosureCompiler::operator()(const ClassStmtPtr &classStmt) {
+    for (const auto &method: classStmt->methods) { compileFunction(method); }
+    return [classStmt](Interpreter &in) -> StmtResult { return in(classStmt); };
+}
+
+/**
+ * @brief 编译 try/catch 语句。
+ */
+CompiledStmt ClosureCompiler::operator()(const TryStmtPtr &tryStmt) {
+    return [tryStmt, body = compile(tryStmt->body), handler = compile(tryStmt->handler)](Interpreter &in) -> StmtResult {
+        auto result = in.executeCompiled(*body, make_ref<Environment>(in.environment));
+        if (!std::holds_alternative<Unwind>(result)) [[likely]] { return result; }
+        return in.executeCompiled(*handler, in.catchError(tryStmt->name));
+    };
+}
+
+/**
+ * @brief 编译 import 语句。
+ *
+ * 模块的语句在第一次执行导入时才编译，不在热路径上。
+ */
+CompiledStmt ClosureCompiler::operator()(const ImportStmtPtr &importStmt) {
+    return [importStmt](Interpreter &in) -> StmtResult { return in(importStmt); };
+}
+
+/**
+ * @brief 为指定的二元运算符生成闭包。
+ *
+ * 算术和比较运算在两个操作数都是数字时直接计算；其余情况（字符串拼接、类型错误）交给 Interpreter::binary。
+ */
+template<BinaryOp Op>
+CompiledExpr ClosureCompiler::binary(CompiledExpr left, CompiledExpr right, const SourceLoc loc) {
+    return [left = std::move(left), right = std::move(right), loc](Interpreter &in) -> LoxObject {
+        const auto a = left(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        const auto b = right(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+
+        if constexpr (Op == BinaryOp::BANG_EQUAL) {
+            return a != b;
+        } else if constexpr (Op == BinaryOp::EQUAL_EQUAL) {
+            return a == b;
+        } else {
+            if (std::holds_alternative<LoxNumber>(a) && std::holds_alternative<LoxNumber>(b)) [[likely]] {
+                const auto x = std::get<LoxNumber>(a);
+                const auto y = std::get<LoxNumber>(b);
+                if constexpr (Op == BinaryOp::PLUS) { return x + y; }
+                if constexpr (Op == BinaryOp::MINUS) { return x - y; }
+                if constexpr (Op == BinaryOp::STAR) { return x * y; }
+                if constexpr (Op == BinaryOp::SLASH) { return x / y; }
+                if constexpr (Op == BinaryOp::GREATER) { return x > y; }
+                if constexpr (Op == BinaryOp::GREATER_EQUAL) { return x >= y; }
+                if constexpr (Op == BinaryOp::LESS) { return x < y; }
+                if constexpr (Op == BinaryOp::LESS_EQUAL) { return x <= y; }
+            }
+            return in.binary(Op, loc, a, b);
+        }
+    };
+}
+
+/**
+ * @brief 编译二元表达式，按运算符选择特化的闭包。
+ */
+CompiledExpr ClosureCompiler::operator()(const BinaryExprPtr &binaryExpr) {
+    auto left = compile(binaryExpr->left);
+    auto right = compile(binaryExpr->right);
+    const auto loc = binaryExpr->loc;
+    switch (binaryExpr->op) {
+        case BinaryOp::PLUS: return binary<BinaryOp::PLUS>(std::move(left), std::move(right), loc);
+        case BinaryOp::MINUS: return binary<BinaryOp::MINUS>(std::move(left), std::move(right), loc);
+        case BinaryOp::STAR: return binary<BinaryOp::STAR>(std::move(left), std::move(right), loc);
+        case BinaryOp::SLASH: return binary<BinaryOp::SLASH>(std::move(left), std::move(right), loc);
+        case BinaryOp::GREATER: return binary<BinaryOp::GREATER>(std::move(left), std::move(right), loc);
+        case BinaryOp::GREATER_EQUAL: return binary<BinaryOp::GREATER_EQUAL>(std::move(left), std::move(right), loc);
+        case BinaryOp::LESS: return binary<BinaryOp::LESS>(std::move(left), std::move(right), loc);
+        case BinaryOp::LESS_EQUAL: return binary<BinaryOp::LESS_EQUAL>(std::move(left), std::move(right), loc);
+        case BinaryOp::BANG_EQUAL: return binary<BinaryOp::BANG_EQUAL>(std::move(left), std::move(right), loc);
+        case BinaryOp::EQUAL_EQUAL: return binary<BinaryOp::EQUAL_EQUAL>(std::move(left), std::move(right), loc);
+    }
+    __builtin_unreachable();
+}
+
+/**
+ * @brief 编译函数调用表达式。
+ */
+CompiledExpr ClosureCompiler::operator()(const CallExprPtr &callExpr) {
+    std::vector<CompiledExpr> arguments;
+    arguments.reserve(callExpr->arguments.size());
+    for (const auto &argument: callExpr->arguments) { arguments.push_back(compile(argument)); }
+
+    return [callee = compile(callExpr->callee), arguments = std::move(arguments),
+            loc = callExpr->loc](Interpreter &in) -> LoxObject {
+        const auto function = callee(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        std::vector<LoxObject> values;
+        values.reserve(arguments.size());
+        for (const auto &argument: arguments) {
+            values.push_back(argument(in));
+            if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        }
+        return in.call(loc, function, values);
+    };
+}
+
+/**
+ * @brief 编译属性访问表达式。
+ */
+CompiledExpr ClosureCompiler::operator()(const GetExprPtr &getExpr) {
+    return [object = compile(getExpr->object), name = getExpr->name](Interpreter &in) -> LoxObject {
+        const auto value = object(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        if (!std::holds_alternative<LoxInstancePtr>(value)) [[unlikely]] {
+            return in.raise(name.getLoc(), "Only instances have properties.");
+        }
+        if (auto property = std::get<LoxInstancePtr>(value)->get(name); property.has_value()) [[likely]] {
+            return std::move(property.value());
+        }
+        return in.raise(name.getLoc(), "Undefined property '" + std::string(name.getLexeme()) + "'.");
+    };
+}
+
+/**
+ * @brief 编译属性赋值表达式。
+ */
+CompiledExpr ClosureCompiler::operator()(const SetExprPtr &setExpr) {
+    return [object = compile(setExpr->object), name = setExpr->name,
+            value = compile(setExpr->value)](Interpreter &in) -> LoxObject {
+        const auto instance = object(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        if (!std::holds_alternative<LoxInstancePtr>(instance)) [[unlikely]] {
+            return in.raise(name.getLoc(), "Only instances have fields.");
+        }
+        auto result = value(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        std::get<LoxInstancePtr>(instance)->set(name, result);
+        return result;
+    };
+}
+
+/**
+ * @brief 编译 this 表达式，距离在编译时确定。
+ */
+CompiledExpr ClosureCompiler::operator()(const ThisExprPtr &thisExpr) {
+    return [distance = static_cast<unsigned long>(thisExpr->distance)](Interpreter &in) -> LoxObject {
+        return in.environment->getAt(distance, "this");
+    };
+}
+
+/**
+ * @brief 编译 super 表达式，距离在编译时确定。
+ */
+CompiledExpr ClosureCompiler::operator()(const SuperExprPtr &superExpr) {
+    return [distance = static_cast<unsigned long>(superExpr->distance), method = superExpr->method](Interpreter &in) -> LoxObject {
+        const auto &callable = std::get<LoxCallablePtr>(in.environment->getAt(distance, "super"));
+        const auto &superClass = static_ref_cast<LoxClass>(callable);
+        const auto &instance = std::get<LoxInstancePtr>(in.environment->getAt(distance - 1, "this"));
+        const auto &function = superClass->findMethod(method.getLexeme());
+        if (function == nullptr) {
+            return in.raise(method.getLoc(), "Undefined property" + std::string(method.getLexeme()));
+        }
+        return function->bind(instance);
+    };
+}
+
+/**
+ * @brief 括号表达式不生成新的闭包，直接返回内部表达式的编译结果。
+ */
+CompiledExpr ClosureCompiler::operator()(const GroupingExprPtr &groupingExpr) {
+    return compile(groupingExpr->expression);
+}
+
+/**
+ * @brief 编译字面量表达式：闭包捕获字面量节点中已转换好的 LoxObject 常量。
+ */
+CompiledExpr ClosureCompiler::operator()(const LiteralExprPtr &literalExpr) {
+    return [constant = literalExpr->value](Interpreter &) -> LoxObject { return constant; };
+}
+
+/**
+ * @brief 编译逻辑表达式，and 和 or 分别生成闭包。
+ */
+CompiledExpr ClosureCompiler::operator()(const LogicalExprPtr &logicalExpr) {
+    auto left = compile(logicalExpr->left);
+    auto right = compile(logicalExpr->right);
+    if (logicalExpr->op == LogicalOp::OR) {
+        return [left = std::move(left), right = std::move(right)](Interpreter &in) -> LoxObject {
+            auto value = left(in);
+            if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+            if (isTruthy(value)) { return value; }
+            return right(in);
+        };
+    }
+    return [left = std::move(left), right = std::move(right)](Interpreter &in) -> LoxObject {
+        auto value = left(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        if (!isTruthy(value)) { return value; }
+        return right(in);
+    };
+}
+
+/**
+ * @brief 编译一元表达式，负号和逻辑非分别生成闭包。
+ */
+CompiledExpr ClosureCompiler::operator()(const UnaryExprPtr &unaryExpr) {
+    auto operand = compile(unaryExpr->expression);
+    if (unaryExpr->op == UnaryOp::BANG) {
+        return [operand = std::move(operand)](Interpreter &in) -> LoxObject {
+            const auto value = operand(in);
+            if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+            return !isTruthy(value);
+        };
+    }
+    return [operand = std::move(operand), loc = unaryExpr->loc](Interpreter &in) -> LoxObject {
+        const auto value = operand(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        if (!in.checkNumberOperand(loc, value)) [[unlikely]] { return LoxNil(); }
+        return -std::get<LoxNumber>(value);
+    };
+}
+
+/**
+ * @brief 编译变量表达式：全局变量和局部变量分别生成闭包，局部变量的距离在编译时确定。
+ */
+CompiledExpr ClosureCompiler::operator()(const VarExprPtr &varExpr) {
+    if (varExpr->distance == -1) {
+        return [name = varExpr->name](Interpreter &in) -> LoxObject {
+            if (const LoxObject *value = in.globals->get(name); value != nullptr) [[likely]] { return *value; }
+            return in.raise(name.getLoc(), "Undefined variable '" + std::string(name.getLexeme()) + "'.");
+        };
+    }
+    return [distance = static_cast<unsigned long>(varExpr->distance),
+            name = varExpr->name.getLexeme()](Interpreter &in) -> LoxObject {
+        return in.environment->getAt(distance, name);
+    };
+}
+
+/**
+ * @brief 编译赋值表达式：全局变量和局部变量分别生成闭包。
+ */
+CompiledExpr ClosureCompiler::operator()(const AssignExprPtr &assignExpr) {
+    auto value = compile(assignExpr->value);
+    if (assignExpr->distance == -1) {
+        return [value = std::move(value), name = assignExpr->name](Interpreter &in) -> LoxObject {
+            auto result = value(in);
+            if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+            if (!in.globals->assign(name, result)) [[unlikely]] {
+                return in.raise(name.getLoc(), "Undefined variable '" + std::string(name.getLexeme()) + "'.");
+            }
+            return result;
+        };
+    }
+    return [value = std::move(value), distance = static_cast<unsigned long>(assignExpr->distance),
+            name = assignExpr->name](Interpreter &in) -> LoxObject {
+        auto result = value(in);
+        if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        in.environment->assignAt(distance, name, result);
+        return result;
+    };
+}
+
+/**
+ * @brief 编译插值字符串：依次求出内嵌表达式的值，再一次性拼接。
+ */
+CompiledExpr ClosureCompiler::operator()(const InterpolationExprPtr &interpolationExpr) {
+    std::vector<CompiledExpr> expressions;
+    expressions.reserve(interpolationExpr->expressions.size());
+    for (const auto &expression: interpolationExpr->expressions) { expressions.push_back(compile(expression)); }
+    return [strings = interpolationExpr->strings, expressions = std::move(expressions)](Interpreter &in) -> LoxObject {
+        llvm::SmallVector<LoxObject, 8> values;
+        values.reserve(expressions.size());
+        for (const auto &expression: expressions) {
+            values.push_back(expression(in));
+            if (in.unwinding()) [[unlikely]] { return LoxNil(); }
+        }
+        return interpolate(strings, values);
+    };
+}
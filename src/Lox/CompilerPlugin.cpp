@@ -0,0 +1,60 @@
+#include "Error/Error.h"
+#include "compiler/CompilerPlugin.h"
+#include <cstdlib>
+#include <dlfcn.h>
+#include <filesystem>
+#include <string>
+
+namespace {
+
+/**
+ * @brief 插件的路径：环境变量 LOX_COMPILER_PLUGIN，否则为可执行文件旁边的 liblox-compiler.so
+ */
+std::string pluginPath() {
+    if (const char *path = std::getenv("LOX_COMPILER_PLUGIN"); path != nullptr && *path != '\0') { return path; }
+    std::error_code ec;
+    const auto executable = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (ec) { return "liblox-compiler.so"; }
+    return (executable.parent_path() / "liblox-compiler.so").string();
+}
+
+/**
+ * @brief dlopen 插件并取出函数表
+ */
+const CompilerPlugin *openPlugin() {
+    const auto path = pluginPath();
+    // RTLD_LOCAL：插件带来的 LLVM 符号不参与解释器的符号解析
+    void *handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        diagnosticStream() << "lox: cannot load code generation plugin: " << ::dlerror() << "\n";
+        return nullptr;
+    }
+    auto *entry = reinterpret_cast<CompilerPluginEntry *>(::dlsym(handle, LOX_COMPILER_PLUGIN_ENTRY));
+    if (entry == nullptr) {
+        diagnosticStream() << "lox: '" << path << "' is not a code generation plugin\n";
+        ::dlclose(handle);
+        return nullptr;
+    }
+    const CompilerPlugin *plugin = entry();
+    if (plugin == nullptr || plugin->abiVersion != COMPILER_PLUGIN_ABI_VERSION) {
+        diagnosticStream() << "lox: code generation plugin '" << path << "' has ABI version "
+                           << (plugin == nullptr ? 0 : plugin->abiVersion) << ", expected "
+                           << COMPILER_PLUGIN_ABI_VERSION << "\n";
+        ::dlclose(handle);
+        return nullptr;
+    }
+    // 插件一旦加载就不再卸载，函数表在进程退出前一直有效
+    return plugin;
+}
+
+}// namespace
+
+/**
+ * @brief 加载代码生成插件。
+ *
+ * 函数内的静态变量保证只加载一次，并且多个线程同时调用时是安全的。
+ */
+const CompilerPlugin *loadCompilerPlugin() {
+    static const CompilerPlugin *const plugin = openPlugin();
+    return plugin;
+}
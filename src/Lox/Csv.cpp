@@ -0,0 +1,104 @@
+#include "Lox/Csv.h"
+#include <cstring>
+#include <string>
+
+// 去掉行尾 \r\n 中的 \r
+static std::string_view withoutCarriageReturn(const std::string_view field) {
+    return !field.empty() && field.back() == '\r' ? field.substr(0, field.size() - 1) : field;
+}
+
+bool CsvCursor::nextRow(std::vector<CsvField> &fields) {
+    fields.clear();
+    const std::string_view input = text.view();
+    while (offset < input.size()) {
+        const char *begin = input.data() + offset;
+        const char *end = input.data() + input.size();
+        const auto *newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        const char *lineEnd = newline == nullptr ? end : newline;
+        const std::string_view line = withoutCarriageReturn({begin, static_cast<std::size_t>(lineEnd - begin)});
+        // 空行直接跳过
+        if (line.empty()) {
+            offset = lineEnd - input.data() + 1;
+            continue;
+        }
+        rows++;
+        if (std::memchr(line.data(), '"', line.size()) != nullptr) { return quotedRow(fields); }
+
+        // 快速路径：没有引号，逐个逗号切分
+        for (std::size_t start = 0;;) {
+            const auto *comma = static_cast<const char *>(std::memchr(line.data() + start, ',', line.size() - start));
+            if (comma == nullptr) {
+                fields.push_back({line.substr(start)});
+                break;
+            }
+            const std::size_t position = comma - line.data();
+            fields.push_back({line.substr(start, position - start)});
+            start = position + 1;
+        }
+        offset = lineEnd - input.data() + 1;
+        return true;
+    }
+    return false;
+}
+
+bool CsvCursor::quotedRow(std::vector<CsvField> &fields) {
+    const std::string_view input = text.view();
+    const char *p = input.data() + offset;
+    const char *end = input.data() + input.size();
+    // 出错后停在输入末尾，之后的 nextRow 都返回 false
+    const auto fail = [this, &input](const std::string_view reason) {
+        message = "csv: " + std::string(reason) + " in row " + std::to_string(rows) + ".";
+        offset = input.size();
+        return false;
+    };
+
+    while (true) {
+        if (p < end && *p == '"') {
+            // 带引号的字段：找到不是 "" 的那个引号为止
+            CsvField field;
+            const char *content = p + 1;
+            const char *search = content;
+            while (true) {
+                const auto *quote = static_cast<const char *>(std::memchr(search, '"', end - search));
+                if (quote == nullptr) { return fail("unterminated quoted field"); }
+                if (quote + 1 < end && quote[1] == '"') {
+                    field.escaped = true;
+                    search = quote + 2;
+                    continue;
+                }
+                field.text = {content, static_cast<std::size_t>(quote - content)};
+                p = quote + 1;
+                break;
+            }
+            fields.push_back(field);
+        } else {
+            // 没有引号的字段：到下一个逗号或换行为止
+            const char *start = p;
+            while (p < end && *p != ',' && *p != '\n') { p++; }
+            fields.push_back({withoutCarriageReturn({start, static_cast<std::size_t>(p - start)})});
+        }
+
+        if (p < end && *p == ',') {
+            p++;
+            continue;
+        }
+        if (p < end && *p == '\r' && p + 1 < end && p[1] == '\n') { p++; }
+        if (p == end || *p == '\n') {
+            offset = p == end ? input.size() : p - input.data() + 1;
+            return true;
+        }
+        return fail("unexpected character after quoted field");
+    }
+}
+
+LoxString CsvCursor::toString(const CsvField &field) const {
+    if (!field.escaped) { return text.slice(field.text.data() - text.data(), field.text.size()); }
+    std::string unescaped;
+    unescaped.reserve(field.text.size());
+    for (std::size_t i = 0; i < field.text.size(); i++) {
+        unescaped.push_back(field.text[i]);
+        // "" 只保留一个引号
+        if (field.text[i] == '"') { i++; }
+    }
+    return {std::move(unescaped)};
+}
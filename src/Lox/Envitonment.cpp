@@ -1,5 +1,8 @@
 #include "Lox/Environment.h"
+#include "Lox/LoxCallable.h"
+#include "Lox/LoxInstance.h"
 #include "Lox/LoxObject.h"
+#include <algorithm>
 #include <llvm/Support/raw_ostream.h>
 
 
@@ -18,35 +21,34 @@ Environment::Environment() : enclosing{nullptr} {}
  * 
  * @param environment 指向封闭环境的指针。
  */
-Environment::Environment(EnvironmentPtr environment) : enclosing{std::move(environment)}  {}
+Environment::Environment(EnvironmentPtr environment) : enclosing{std::move(environment)} {
+    // 外部环境成为距离 1 的祖先，其余祖先沿用外部环境的显示表并右移一位
+    if (enclosing != nullptr) {
+        display[0] = enclosing.get();
+        std::copy_n(enclosing->display.begin(), DISPLAY_SIZE - 1, display.begin() + 1);
+    }
+}
 
 /**
  * @brief 获取指定名称的变量值
  * 
- * 该函数尝试从当前环境中查找指定名称的变量。如果找到，则返回该变量的值；
- * 如果未找到且存在封闭环境，则递归调用封闭环境的get方法继续查找；
- * 如果最终仍未找到，则抛出运行时错误。
+ * 该函数尝试从当前环境中查找指定名称的变量。如果找到，则返回指向该变量的指针；
+ * 如果未找到且存在封闭环境，则继续在封闭环境中查找；
+ * 如果最终仍未找到，则返回 nullptr，由解释器报告运行时错误。
  * 
- * @param name 要查找的变量的Token对象
- * @return LoxObject& 找到的变量的值的引用
- * @throws runtime_error 如果变量未定义
+ * @param name 要查找的变量名
+ * @return LoxObject* 指向变量值的指针，变量未定义时为 nullptr
  */
-LoxObject &Environment::get(const Token &name) {
-    // 检查当前环境中是否存在该变量
-    if (values.contains(name.getLexeme())) {
-        // 如果存在，返回该变量的值
-        return values[name.getLexeme()];
+LoxObject *Environment::get(const Identifier &name) {
+    // 沿封闭环境链逐层查找，只做一次哈希查找
+    for (Environment *env = this; env != nullptr; env = env->enclosing.get()) {
+        if (const auto it = env->values.find(name.getLexeme()); it != env->values.end()) {
+            // 如果存在，返回该变量的值
+            return &it->second;
+        }
     }
-
-    // 检查是否存在封闭环境
-    if (enclosing != nullptr) {
-        // 如果存在，递归调用封闭环境的get方法继续查找
-        return enclosing->get(name);
-    }
-    // 如果未找到变量，输出错误信息
-    llvm::errs() << name.toString() << "Undefined variable '" << std::string(name.getLexeme()) << "'.";
-    // 抛出运行时错误
-    throw runtime_error(name, "Undefined variable '" + std::string(name.getLexeme()) + "'.");
+    // 变量未定义
+    return nullptr;
 }
 
 /**
@@ -66,76 +68,62 @@ void Environment::define(std::string_view name, const LoxObject &value) {
  * @brief 在当前环境或其封闭环境中为变量赋值
  * 
  * 该函数尝试在当前环境中查找指定名称的变量。如果找到，则更新该变量的值；
- * 如果未找到且存在封闭环境，则递归调用封闭环境的assign方法继续查找并赋值；
- * 如果最终仍未找到，则抛出运行时错误。
+ * 如果未找到且存在封闭环境，则继续在封闭环境中查找并赋值；
+ * 如果最终仍未找到，则返回 false，由解释器报告运行时错误。
  * 
- * @param name 要赋值的变量的Token对象
+ * @param name 要赋值的变量名
  * @param value 要赋给变量的值
- * @throws runtime_error 如果变量未定义
+ * @return bool 变量已定义并赋值成功时返回 true
  */
-void Environment::assign(const Token &name, const LoxObject &value) {
-    // 检查当前环境中是否存在该变量
-    if (values.contains(name.getLexeme())) {
+bool Environment::assign(const Identifier &name, const LoxObject &value) {
+    // 复用 get 的查找逻辑
+    if (LoxObject *slot = get(name); slot != nullptr) {
         // 如果存在，更新该变量的值
-        values[name.getLexeme()] = value;
-        return;
-    }
-    // 检查是否存在封闭环境
-    if (enclosing != nullptr) {
-        // 如果存在，递归调用封闭环境的assign方法继续查找并赋值
-        enclosing->assign(name, value);
-        return;
+        *slot = value;
+        return true;
     }
-    // 如果未找到变量，输出错误信息
-    llvm::errs() << name.toString() << "Undefined variable '" << std::string(name.getLexeme()) << "'.";
-    // 抛出运行时错误
-    throw runtime_error(name, "Undefined variable '" + std::string(name.getLexeme()) + "'.");
+    // 变量未定义
+    return false;
 }
 
 
 /**
  * @brief 根据指定的距离获取特定环境中变量的值
  * 
- * 该函数通过调用 `ancestor` 方法找到指定距离处的环境，然后从该环境中获取指定名称的变量的值。
+ * 该函数通过显示表直接找到指定距离处的环境，然后从该环境中获取指定名称的变量的值。
  * 
  * @param distance 距离当前环境的层数，用于定位目标环境
  * @param name 要查找的变量的名称
  * @return LoxObject& 返回找到的变量的值的引用
  */
 LoxObject &Environment::getAt(const unsigned long distance, const std::string_view &name) {
-    // 调用 ancestor 方法找到指定距离处的环境，并获取该环境中指定名称的变量的值
-    return ancestor(distance)->values[name];
+    // 通过显示表一次定位目标环境，与嵌套深度无关
+    return frameAt(distance)->values[name];
 }
 
 /**
  * @brief 根据指定的距离找到祖先环境
  * 
- * 该函数从当前环境开始，通过 `enclosing` 指针逐层向上查找，直到达到指定的距离，返回找到的祖先环境的指针。
+ * 该函数通过显示表直接找到指定距离处的环境，返回指向它的句柄。
  * 
  * @param distance 距离当前环境的层数，用于定位目标环境
  * @return EnvironmentPtr 返回找到的祖先环境的指针
  */
 EnvironmentPtr Environment::ancestor(const unsigned long distance) {
-    // 获取当前环境的共享指针
-    auto environment = shared_from_this();
-    // 循环指定的次数，通过 enclosing 指针逐层向上查找
-    for (unsigned long i = 0; i < distance; i++) { 
-        environment = environment->enclosing; 
-    }
-    // 返回找到的祖先环境的指针
-    return environment;
+    // 通过显示表定位祖先环境，只在返回时增加一次引用
+    return EnvironmentPtr(frameAt(distance));
 }
 
 /**
  * @brief 根据指定的距离在特定环境中为变量赋值
  * 
- * 该函数通过调用 `ancestor` 方法找到指定距离处的环境，然后在该环境中为指定名称的变量赋新值。
+ * 该函数通过显示表直接找到指定距离处的环境，然后在该环境中为指定名称的变量赋新值。
  * 
  * @param distance 距离当前环境的层数，用于定位目标环境
- * @param name 要赋值的变量的 Token 对象
+ * @param name 要赋值的变量名
  * @param value 要赋给变量的新值
  */
-void Environment::assignAt(const unsigned long distance, const Token &name, const LoxObject &value) {
-    // 调用 ancestor 方法找到指定距离处的环境，并在该环境中为指定名称的变量赋新值
-    ancestor(distance)->values[name.getLexeme()] = value;
+void Environment::assignAt(const unsigned long distance, const Identifier &name, const LoxObject &value) {
+    // 通过显示表定位目标环境，并在该环境中为指定名称的变量赋新值
+    frameAt(distance)->values[name.getLexeme()] = value;
 }
@@ -0,0 +1,219 @@
+#include "Lox/HotReload.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "frontend/Parser.h"
+#include "frontend/Resolver.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace {
+
+/**
+ * @brief 一个顶层的 fun 或 class 声明在词法单元序列中的范围
+ */
+struct Declaration {
+    std::string name;
+    // 第一个和最后一个词法单元的下标
+    std::size_t first = 0;
+    std::size_t last = 0;
+    // 声明的源码文本
+    std::string text;
+};
+
+/**
+ * @brief 按花括号切分出顶层的 fun 和 class 声明
+ *
+ * 词法单元只记录行号和列号，先算出每行的起始位置，再用声明的第一个和最后一个词法单元定位源码文本。
+ *
+ * @param tokens 扫描得到的词法单元
+ * @param source 源码
+ * @return std::vector<Declaration> 完整的顶层声明，末尾不完整的声明被忽略
+ */
+std::vector<Declaration> topLevelDeclarations(const std::vector<Token> &tokens, const std::string &source) {
+    std::vector<std::size_t> lineStarts{0};
+    for (std::size_t i = 0; i < source.size(); i++) {
+        if (source[i] == '\n') { lineStarts.push_back(i + 1); }
+    }
+    const auto offsetOf = [&](const Token &token) {
+        return lineStarts[std::min<std::size_t>(token.getLine() - 1, lineStarts.size() - 1)] + token.getColumn() - 1;
+    };
+
+    std::vector<Declaration> declarations;
+    int depth = 0;
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        const auto type = tokens[i].getType();
+        if (depth == 0 && (type == FUN || type == CLASS) && i + 1 < tokens.size() &&
+            tokens[i + 1].getType() == IDENTIFIER) {
+            // 声明一直延续到与它的第一个左花括号匹配的右花括号
+            std::size_t j = i + 2;
+            int nested = 0;
+            for (; j < tokens.size() && tokens[j].getType() != LoxEOF; j++) {
+                if (tokens[j].getType() == LEFT_BRACE) {
+                    nested++;
+                } else if (tokens[j].getType() == RIGHT_BRACE && --nested == 0) {
+                    break;
+                }
+            }
+            if (j == tokens.size() || tokens[j].getType() != RIGHT_BRACE) { break; }
+            const auto begin = offsetOf(tokens[i]);
+            const auto end = offsetOf(tokens[j]) + 1;
+            declarations.push_back({std::string(tokens[i + 1].getLexeme()), i, j, source.substr(begin, end - begin)});
+            i = j;
+            continue;
+        }
+        if (type == LEFT_BRACE) { depth++; }
+        if (type == RIGHT_BRACE) { depth--; }
+    }
+    return declarations;
+}
+
+}// namespace
+
+HotReloader::HotReloader(Interpreter &interpreter) : interpreter{interpreter} {
+    inotifyFd = ::inotify_init1(IN_CLOEXEC);
+    stopFd = ::eventfd(0, EFD_CLOEXEC);
+    if (inotifyFd < 0 || stopFd < 0) {
+        llvm::errs() << "lox: cannot watch source files, hot reload is disabled\n";
+        return;
+    }
+    thread = std::thread([this] { run(); });
+}
+
+HotReloader::~HotReloader() {
+    if (thread.joinable()) {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const auto ignored = ::write(stopFd, &one, sizeof(one));
+        thread.join();
+    }
+    if (inotifyFd >= 0) { ::close(inotifyFd); }
+    if (stopFd >= 0) { ::close(stopFd); }
+}
+
+void HotReloader::watch(const Module &module) {
+    std::error_code ec;
+    const auto canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(module.path), ec);
+    const std::string path = ec ? module.path : canonical.string();
+
+    // 模块已经扫描过，这里只为了切分声明重新扫描一次
+    Scanner scanner(module.scanner->getSource());
+    const auto tokens = scanner.scanTokens();
+    WatchedFile file;
+    for (auto &declaration: topLevelDeclarations(tokens, scanner.getSource())) {
+        file.declarations[declaration.name] = std::move(declaration.text);
+    }
+    {
+        std::lock_guard lock(mutex);
+        if (!files.emplace(path, std::move(file)).second) { return; }
+        const auto directory = std::filesystem::path(path).parent_path().string();
+        bool watched = false;
+        for (const auto &[wd, name]: directories) { watched = watched || name == directory; }
+        if (!watched && inotifyFd >= 0) {
+            if (const int wd = ::inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                wd >= 0) {
+                directories[wd] = directory;
+            }
+        }
+    }
+
+    for (const auto &stmt: module.imports) {
+        if (stmt->module.valid()) { watch(*stmt->module.get()); }
+    }
+}
+
+void HotReloader::run() {
+    // 监视线程的错误信息不经过 llvm::errs()，避免与解释器线程共享同一个流对象
+    llvm::raw_fd_ostream errors(STDERR_FILENO, false, true);
+    diagnostics = &errors;
+
+    alignas(inotify_event) char buffer[4096];
+    pollfd watched[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    while (true) {
+        if (::poll(watched, 2, -1) < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        if (watched[1].revents != 0) { break; }
+        const ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) { continue; }
+
+        // 一次保存可能产生多个事件，每个文件只重新加载一次
+        std::unordered_set<std::string> changed;
+        {
+            std::lock_guard lock(mutex);
+            for (ssize_t offset = 0; offset < length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                const auto directory = directories.find(event->wd);
+                if (event->len == 0 || directory == directories.end()) { continue; }
+                auto path = (std::filesystem::path(directory->second) / event->name).string();
+                if (files.contains(path)) { changed.insert(std::move(path)); }
+            }
+        }
+        for (const auto &path: changed) { reload(path); }
+    }
+    diagnostics = nullptr;
+}
+
+void HotReloader::reload(const std::string &path) {
+    const std::ifstream input(path, std::ios_base::binary);
+    if (input.fail()) { return; }
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    auto module = std::make_shared<Module>();
+    module->path = path;
+    module->scanner = std::make_unique<Scanner>(buffer.str());
+    hadError = false;
+    const auto tokens = module->scanner->scanTokens();
+    if (hadError) {
+        diagnosticStream() << "lox: not reloading '" << path << "'\n";
+        return;
+    }
+
+    // 只把改动过或新增的声明拼接起来解析
+    std::unordered_map<std::string, std::string> current;
+    std::vector<Token> changed;
+    std::string names;
+    {
+        std::lock_guard lock(mutex);
+        const auto &previous = files.at(path).declarations;
+        for (auto &declaration: topLevelDeclarations(tokens, module->scanner->getSource())) {
+            if (const auto it = previous.find(declaration.name); it == previous.end() || it->second != declaration.text) {
+                changed.insert(changed.end(), tokens.begin() + declaration.first, tokens.begin() + declaration.last + 1);
+                names += (names.empty() ? "" : ", ") + declaration.name;
+            }
+            current[declaration.name] = std::move(declaration.text);
+        }
+    }
+    if (changed.empty()) { return; }
+    changed.push_back(tokens.back());
+
+    Parser parser(std::move(changed));
+    try {
+        module->statements = parser.parse();
+    } catch (const ParseError &) { hadError = true; }
+    if (!hadError) {
+        Resolver resolver;
+        resolver.resolve(module->statements);
+    }
+    if (hadError) {
+        // 基准保持不变，修正之后再次保存会重新比较
+        diagnosticStream() << "lox: not reloading '" << path << "'\n";
+        return;
+    }
+
+    interpreter.scheduleReload(std::move(module));
+    {
+        std::lock_guard lock(mutex);
+        files.at(path).declarations = std::move(current);
+    }
+    diagnosticStream() << "lox: reloading " << names << " from '" << path << "'\n";
+}
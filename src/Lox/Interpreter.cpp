@@ -1,27 +1,64 @@
 #include "Lox/Interpreter.h"
+#include "Lox/ClosureCompiler.h"
 #include "Lox/Environment.h"
 #include "Lox/LoxCallable.h"
 #include "Lox/LoxClass.h"
 #include "Lox/LoxFunction.h"
 #include "Lox/LoxInstance.h"
 #include "Lox/LoxObject.h"
+#include "Lox/Metrics.h"
 #include "Lox/NativeFunction.h"
+#include "Lox/Natives.h"
+#include "Utils/HeapAccounting.h"
+#include "Utils/SlabAllocator.h"
 #include "frontend/Ast.h"
+#include "frontend/ModuleLoader.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <malloc.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/raw_ostream.h>
 #include <memory>
 #include <ostream>
+#include <utility>
 #include <variant>
 
-Interpreter::Interpreter() {
-    globals->define("clock", std::make_shared<NativeFunction>([](const std::vector<LoxObject> &) -> LoxObject {
+// 当前进程堆中已使用的字节数：包括 brk 堆中已分配的块、mmap 分配的大块和 slab 池直接映射的大页
+std::size_t heapInUse() {
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd + SlabPool::mappedBytes.load(std::memory_order_relaxed);
+}
+
+Interpreter::Interpreter(const ExecutionLimits &limits, const ExecutionEngine engine) : engine{engine} {
+    setLimits(limits);
+
+    globals->define("clock", make_ref<NativeFunction>([](Interpreter &, const std::vector<LoxObject> &) -> LoxObject {
                         const auto now = std::chrono::system_clock::now().time_since_epoch();
                         return LoxNumber(std::chrono::duration_cast<std::chrono::seconds>(now).count());
                     }));
+    defineStringNatives(*globals);
+    defineDataNatives(*globals);
+    defineListNatives(*globals);
 }
 
+Interpreter::~Interpreter() { globals->clear(); }
+
+/**
+ * @brief 重新设置执行预算。
+ *
+ * @param limits 执行预算。
+ */
+void Interpreter::setLimits(const ExecutionLimits &limits) {
+    this->limits = limits;
+    exhausted = false;
+    // 计算时间截止点；第一轮燃料为 1，第一个安全点即进入 refuel 分配正式的燃料
+    if (limits.timeout.count() > 0) { deadline = std::chrono::steady_clock::now() + limits.timeout; }
+    instructionsLeft = limits.maxInstructions > 0 ? limits.maxInstructions : UINT64_MAX;
+    // 堆预算只计算本线程在设置之后的增长，批处理模式中前面的脚本、模块缓存和服务模式中其他隔离区占用的内存不计入
+    if (limits.maxHeapBytes > 0) { heapBaseline = threadHeapBytes(); }
+    fuel = fuelSlice = 1;
+}
 
 // LoxObject Interpreter::operator()(const Expr& expr) {
 //     // TODO: Implement expression evaluation
@@ -45,7 +82,7 @@ StmtResult Interpreter::operator()(const FunctionStmtPtr &functionStmt) {
     // 获取函数名
     const auto name = functionStmt->name.getLexeme();
     // 创建一个 LoxFunction 对象，该对象封装了函数声明和当前环境
-    auto function = std::make_shared<LoxFunction>(functionStmt, environment);
+    auto function = make_ref<LoxFunction>(functionStmt, environment);
     // 在当前环境中定义函数，将函数名和函数对象关联起来
     environment->define(name, std::move(function));
     // 返回 Nothing，表示函数声明语句执行完毕
@@ -61,8 +98,11 @@ StmtResult Interpreter::operator()(const FunctionStmtPtr &functionStmt) {
  * @return StmtResult 执行结果。
  */
 StmtResult Interpreter::operator()(const IfStmtPtr &ifStmtPtr) {
+    // 计算条件表达式，出错时中止
+    const auto condition = evaluate(ifStmtPtr->condition);
+    if (unwinding()) [[unlikely]] { return Unwind{}; }
     // 检查条件表达式是否为真
-    if (isTruthy(evaluate(ifStmtPtr->condition))) {
+    if (isTruthy(condition)) {
         // 如果条件为真，执行 then 分支
         return std::move(evaluate(ifStmtPtr->thenBranch));
     }
@@ -100,9 +140,10 @@ StmtResult Interpreter::operator()(const ReturnStmtPtr &returnStmt) {
     if (returnStmt->expression.has_value()) {
         // 如果包含表达式，计算表达式的值并赋值给返回值
         value = evaluate(returnStmt->expression.value());
+        if (unwinding()) [[unlikely]] { return Unwind{}; }
     }
     // 返回包含返回值的 Return 对象
-    return Return(value);
+    return Return{std::move(value)};
 }
 
 /**
@@ -116,6 +157,7 @@ StmtResult Interpreter::operator()(const ReturnStmtPtr &returnStmt) {
 StmtResult Interpreter::operator()(const ExpressionStmtPtr &expressionStmt) {
     // 执行表达式
     evaluate(expressionStmt->expression);
+    if (unwinding()) [[unlikely]] { return Unwind{}; }
     // 返回 Nothing
     return Nothing();
 }
@@ -131,11 +173,12 @@ StmtResult Interpreter::operator()(const ExpressionStmtPtr &expressionStmt) {
 StmtResult Interpreter::operator()(const PrintStmtPtr &printStmt) {
     // 计算表达式的值
     const auto object = evaluate(printStmt->expression);
+    if (unwinding()) [[unlikely]] { return Unwind{}; }
     // 将对象转换为字符串并输出到标准输出
     //llvm::outs() << to_string(object) << "\n";
     //auto temp = to_string(object);
 
-    llvm::outs() << to_string(object) << "\n";
+    *output << to_string(object) << "\n";
     // 返回 Nothing
     return Nothing();
 }
@@ -151,6 +194,7 @@ StmtResult Interpreter::operator()(const PrintStmtPtr &printStmt) {
 StmtResult Interpreter::operator()(const VarStmtPtr &varStmt) {
     // 计算初始值
     const auto value = evaluate(varStmt->initializer);
+    if (unwinding()) [[unlikely]] { return Unwind{}; }
     // 在当前环境中定义变量
     environment->define(varStmt->name.getLexeme(), value);
     // 返回 Nothing
@@ -163,48 +207,142 @@ StmtResult Interpreter::operator()(const VarStmtPtr &varStmt) {
  * 该函数执行 while 循环语句，只要条件为真就继续执行循环体。
  *
  * @param whileStmt 指向 WhileStmt 的智能指针。
- * @return StmtResult 执行结果，如果循环体中遇到 Return 语句则返回该结果，否则返回 Nothing。
+ * @return StmtResult 执行结果，如果循环体中遇到 Return 语句或运行时错误则返回该结果，否则返回 Nothing。
  */
 StmtResult Interpreter::operator()(const WhileStmtPtr &whileStmt) {
     // 只要条件为真，就继续执行循环体
-    while (isTruthy(evaluate(whileStmt->condition))) {
+    while (true) {
+        const auto condition = evaluate(whileStmt->condition);
+        if (unwinding()) [[unlikely]] { return Unwind{}; }
+        if (!isTruthy(condition)) { break; }
         // 执行循环体
-        if (auto result = evaluate(whileStmt->body); std::holds_alternative<Return>(result)) {
-            // 如果循环体中遇到 Return 语句，返回该结果
+        if (auto result = evaluate(whileStmt->body);
+            std::holds_alternative<Return>(result) || std::holds_alternative<Unwind>(result)) {
+            // 如果循环体中遇到 Return 语句或运行时错误，返回该结果
             return result;
         }
+        // 循环回边是安全点，消耗一条指令
+        if (!safepoint(whileStmt->loc)) [[unlikely]] { return Unwind{}; }
     }
     // 如果没有遇到 Return 语句，返回 Nothing
     return Nothing();
 }
 
+/**
+ * @brief 处理 ForStmt 语句的调用运算符重载。
+ *
+ * 循环变量存放在唯一的循环环境中，条件和增量直接在该环境中求值。循环体是代码块且
+ * Resolver 判定其中没有创建闭包时，所有迭代复用同一个清空后的代码块环境；
+ * 否则每次迭代照常创建新环境，保证闭包捕获的语义不变。
+ *
+ * @param forStmt 指向 ForStmt 的智能指针。
+ * @return StmtResult 执行结果，如果循环体中遇到 Return 语句或运行时错误则返回该结果，否则返回 Nothing。
+ */
+StmtResult Interpreter::operator()(const ForStmtPtr &forStmt) {
+    // 保存原来的环境，并创建循环环境
+    const auto previous = environment;
+    environment = make_ref<Environment>(previous);
+
+    // 没有闭包时可以复用的循环体环境
+    const BlockStmtPtr *block = forStmt->captured ? nullptr : std::get_if<BlockStmtPtr>(&forStmt->body);
+    const EnvironmentPtr bodyEnvironment = block != nullptr ? make_ref<Environment>(environment) : nullptr;
+
+    StmtResult result = Nothing{};
+    // 执行初始化语句
+    if (forStmt->initializer.has_value()) {
+        if (std::holds_alternative<Unwind>(evaluate(forStmt->initializer.value()))) [[unlikely]] { result = Unwind{}; }
+    }
+
+    while (!std::holds_alternative<Unwind>(result)) {
+        // 计算循环条件
+        if (forStmt->condition.has_value()) {
+            const auto condition = evaluate(forStmt->condition.value());
+            if (unwinding()) [[unlikely]] {
+                result = Unwind{};
+                break;
+            }
+            if (!isTruthy(condition)) { break; }
+        }
+
+        // 执行循环体
+        StmtResult bodyResult = Nothing{};
+        if (block != nullptr) {
+            bodyEnvironment->clear();
+            bodyResult = executeBlock((*block)->statements, bodyEnvironment);
+        } else {
+            bodyResult = evaluate(forStmt->body);
+        }
+        if (std::holds_alternative<Return>(bodyResult) || std::holds_alternative<Unwind>(bodyResult)) {
+            // 如果循环体中遇到 Return 语句或运行时错误，结束循环并返回该结果
+            result = std::move(bodyResult);
+            break;
+        }
+
+        // 在循环环境中执行增量表达式
+        if (forStmt->increment.has_value()) {
+            evaluate(forStmt->increment.value());
+            if (unwinding()) [[unlikely]] {
+                result = Unwind{};
+                break;
+            }
+        }
+
+        // 循环回边是安全点，消耗一条指令
+        if (!safepoint(forStmt->loc)) [[unlikely]] { result = Unwind{}; }
+    }
+
+    // 恢复原来的环境
+    environment = previous;
+    return result;
+}
+
 /**
  * @brief 处理函数调用表达式的调用运算符重载。
  *
  * 该函数用于计算并执行函数调用表达式。它会检查调用深度是否超过限制，
  * 计算被调用函数的表达式值，收集参数，并确保参数数量与函数期望的参数数量匹配。
- * 如果一切正常，它会调用函数并返回结果；否则，抛出运行时错误。
+ * 如果一切正常，它会调用函数并返回结果；否则，记录运行时错误。
  *
  * @param callExpr 指向 CallExpr 的智能指针，表示函数调用表达式。
  * @return LoxObject 函数调用的结果。
  */
 LoxObject Interpreter::operator()(const CallExprPtr &callExpr) {
-    // 检查函数调用深度是否超过最大限制
-    if (function_depth > MAX_CALL_DEPTH) {
-        // 如果超过限制，抛出运行时错误
-        throw runtime_error(callExpr->keyword, "Stack overflow.");
-    }
-
     // 计算被调用函数的表达式的值
     const auto &callee = evaluate(callExpr->callee);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
 
     // 用于存储函数调用的参数
     std::vector<LoxObject> arguments;
+    arguments.reserve(callExpr->arguments.size());
     // 遍历调用表达式中的参数列表
     for (auto &argument: callExpr->arguments) {
         // 计算每个参数的值并添加到参数列表中
         arguments.push_back(evaluate(argument));
+        if (unwinding()) [[unlikely]] { return LoxNil(); }
+    }
+
+    return call(callExpr->loc, callee, arguments);
+}
+
+/**
+ * @brief 调用一个已经求值的被调用对象。
+ *
+ * 树遍历和闭包编译两种执行方式共用该函数：检查调用深度、消耗安全点、
+ * 检查被调用对象和参数数量，然后执行调用。
+ *
+ * @param loc 调用表达式的源码位置。
+ * @param callee 被调用对象。
+ * @param arguments 参数列表。
+ * @return LoxObject 函数调用的结果，出错时记录运行时错误并返回 nil。
+ */
+LoxObject Interpreter::call(const SourceLoc loc, const LoxObject &callee, const std::vector<LoxObject> &arguments) {
+    // 检查函数调用深度是否超过最大限制
+    if (function_depth > MAX_CALL_DEPTH) {
+        // 如果超过限制，记录运行时错误
+        return raise(loc, "Stack overflow.");
     }
+    // 函数调用是安全点，消耗一条指令
+    if (!safepoint(loc)) [[unlikely]] { return LoxNil(); }
 
     // 检查被调用的对象是否为可调用对象
     if (std::holds_alternative<LoxCallablePtr>(callee)) {
@@ -212,28 +350,69 @@ LoxObject Interpreter::operator()(const CallExprPtr &callExpr) {
         const auto &callable = std::get<LoxCallablePtr>(callee);
         // 检查传递的参数数量是否与可调用对象期望的参数数量一致
         if (static_cast<int>(arguments.size()) != callable->arity()) {
-            // 构建错误信息，说明期望的参数数量和实际传递的参数数量
-            // std::string result = "Expected " + std::to_string(callable->arity()) + " arguments but got " +
-            //                      std::to_string(arguments.size()) + ".";
-            // 抛出运行时错误，包含错误信息
-            // throw runtime_error(callExpr->keyword, result);
-            throw runtime_error(
-                callExpr->keyword, ("Expected {} arguments but got {}." + std::to_string(callable->arity()) +
+            // 记录运行时错误，包含错误信息
+            return raise(
+                loc, ("Expected {} arguments but got {}." + std::to_string(callable->arity()) +
                                     std::to_string(arguments.size()))
             );
         }
         // 增加函数调用深度
         function_depth++;
+        calls++;
+        // 原生函数以这里作为回调的安全点和报告错误的位置；返回时恢复外层的调用点，
+        // 使原生函数在回调之后报告的错误仍然指向它自己的调用点
+        const SourceLoc outerCallSite = std::exchange(callSite, loc);
+        const bool profiled = perf != nullptr && enterProfiled(*callable);
         // 调用可调用对象并传递解释器和参数列表，获取返回值
         auto lox_object = (*callable)(*this, arguments);
         // 减少函数调用深度
         function_depth--;
+        callSite = outerCallSite;
+        if (profiled) [[unlikely]] { perf->leaveFunction(); }
         // 返回函数调用的结果
         return lox_object;
     }
 
-    // 如果被调用的对象不是可调用对象，抛出运行时错误
-    throw runtime_error(callExpr->keyword, "Can only call functions and classes.");
+    // 如果被调用的对象不是可调用对象，记录运行时错误
+    return raise(loc, "Can only call functions and classes.");
+}
+
+/**
+ * @brief 原生函数回调 Lox 函数的快速路径。
+ *
+ * @param loc 原生函数调用点的源码位置。
+ * @param function 被调用的函数。
+ * @param arguments 参数列表，个数已由调用方检查。
+ * @param frame 调用方保存的环境，未被捕获时复用。
+ * @return LoxObject 函数调用的结果，出错时记录运行时错误并返回 nil。
+ */
+LoxObject Interpreter::callFunction(
+    const SourceLoc loc, LoxFunction &function, const std::vector<LoxObject> &arguments, EnvironmentPtr &frame
+) {
+    if (function_depth > MAX_CALL_DEPTH) { return raise(loc, "Stack overflow."); }
+    if (!safepoint(loc)) [[unlikely]] { return LoxNil(); }
+    function_depth++;
+    calls++;
+    const bool profiled = perf != nullptr && enterProfiled(function);
+    auto result = function.invokeIn(*this, arguments, frame);
+    function_depth--;
+    if (profiled) [[unlikely]] { perf->leaveFunction(); }
+    return result;
+}
+
+/**
+ * @brief 被调用的是顶层函数时通知剖析器进入该函数。
+ *
+ * 顶层函数的闭包就是全局环境；方法、局部函数和类的调用计入调用它们的顶层函数。
+ *
+ * @param callable 被调用的对象。
+ * @return bool 是否进入了函数。
+ */
+bool Interpreter::enterProfiled(LoxCallable &callable) {
+    const auto *function = dynamic_cast<LoxFunction *>(&callable);
+    if (function == nullptr || function->closure.get() != globals.get()) { return false; }
+    perf->enterFunction(function->declaration.get(), function->declaration->name.getLexeme());
+    return true;
 }
 
 /**
@@ -246,7 +425,7 @@ LoxObject Interpreter::operator()(const CallExprPtr &callExpr) {
  * @return StmtResult 执行结果，如果代码块中遇到 Return 语句则返回该结果，否则返回 Nothing。
  */
 StmtResult Interpreter::operator()(const BlockStmtPtr &blockStmt) {
-    return executeBlock(blockStmt->statements, std::make_shared<Environment>(environment));
+    return executeBlock(blockStmt->statements, make_ref<Environment>(environment));
 }
 
 
@@ -260,13 +439,15 @@ StmtResult Interpreter::operator()(const BlockStmtPtr &blockStmt) {
  */
 StmtResult Interpreter::operator()(const ClassStmtPtr &classStmt) {
     // 处理父类
-    std::optional<std::shared_ptr<LoxClass>> super_class;
+    std::optional<LoxClassPtr> super_class;
     if (classStmt->super_class.has_value()) {
-        if (const auto &s = (*this)(classStmt->super_class.value());
-            std::holds_alternative<LoxCallablePtr>(s) && dynamic_cast<LoxClass *>(std::get<LoxCallablePtr>(s).get())) {
-            super_class = std::reinterpret_pointer_cast<LoxClass>(std::get<LoxCallablePtr>(s));
+        const auto &s = (*this)(classStmt->super_class.value());
+        if (unwinding()) [[unlikely]] { return Unwind{}; }
+        if (std::holds_alternative<LoxCallablePtr>(s) && dynamic_cast<LoxClass *>(std::get<LoxCallablePtr>(s).get())) {
+            super_class = static_ref_cast<LoxClass>(std::get<LoxCallablePtr>(s));
         } else {
-            throw runtime_error(classStmt->super_class.value()->name, "Superclass must be a class.");
+            raise(classStmt->super_class.value()->name.getLoc(), "Superclass must be a class.");
+            return Unwind{};
         }
     }
 
@@ -275,7 +456,7 @@ StmtResult Interpreter::operator()(const ClassStmtPtr &classStmt) {
 
     // 如果有父类，创建新的环境并定义super
     if (super_class.has_value()) {
-        environment = std::make_shared<Environment>(environment);
+        environment = make_ref<Environment>(environment);
         environment->define("super", super_class.value());
     }
 
@@ -283,19 +464,88 @@ StmtResult Interpreter::operator()(const ClassStmtPtr &classStmt) {
     std::unordered_map<std::string_view, LoxFunctionPtr> methods;
     for (auto &method: classStmt->methods) {
         methods[method->name.getLexeme()] =
-            std::make_shared<LoxFunction>(method, environment, method->type == LoxFunctionType::INITIALIZER);
+            make_ref<LoxFunction>(method, environment, method->type == LoxFunctionType::INITIALIZER);
     }
 
     // 如果有父类，恢复原来的环境
     if (super_class.has_value()) { environment = environment->get_enclosing(); }
     // 在环境中创建类对象
     environment->assign(
-        classStmt->name, std::make_shared<LoxClass>(classStmt->name.getLexeme(), super_class, std::move(methods))
+        classStmt->name, make_ref<LoxClass>(classStmt->name.getLexeme(), super_class, std::move(methods))
     );
 
     return Nothing();
 }
 
+/**
+ * @brief 处理 TryStmt 语句的调用运算符重载。
+ *
+ * 进入 try 块不登记任何处理器，与普通代码块的开销相同。只有 try 块返回 Unwind 时，
+ * 才取出并清除记录的运行时错误，把错误信息绑定到 catch 变量并执行 catch 块。
+ *
+ * @param tryStmt 指向 TryStmt 的智能指针。
+ * @return StmtResult 执行结果，try 块或 catch 块中的 Return 和未捕获的错误会继续向外返回。
+ */
+StmtResult Interpreter::operator()(const TryStmtPtr &tryStmt) {
+    // 执行 try 块
+    auto result = executeBlock(tryStmt->body, make_ref<Environment>(environment));
+    if (!std::holds_alternative<Unwind>(result)) [[likely]] { return result; }
+
+    // 在新环境中绑定 catch 变量并执行 catch 块
+    return executeBlock(tryStmt->handler, catchError(tryStmt->name));
+}
+
+/**
+ * @brief 处理 ImportStmt 语句的调用运算符重载。
+ *
+ * 等待 ModuleLoader 的加载结果，在全局环境中执行模块的顶层语句，模块定义的函数、类和变量因此成为全局变量。
+ * 模块只在第一次被导入时执行；执行前先登记，循环导入时再次遇到同一个模块直接跳过。
+ *
+ * @param importStmt 指向 ImportStmt 的智能指针。
+ * @return StmtResult 执行结果，模块中未捕获的运行时错误会继续向外返回。
+ */
+StmtResult Interpreter::operator()(const ImportStmtPtr &importStmt) {
+    if (!importStmt->module.valid()) [[unlikely]] {
+        raise(importStmt->loc, "Module '" + std::string(importStmt->path) + "' was not loaded.");
+        return Unwind{};
+    }
+    const auto &module = importStmt->module.get();
+    if (!module->error.empty()) {
+        raise(importStmt->loc, module->error);
+        return Unwind{};
+    }
+    if (!importedModules.insert(module.get()).second) { return Nothing{}; }
+
+    // 模块通常已经在加载线程上编译好，只有未开启 ModuleLoader::precompile 时才在这里编译
+    StmtResult result;
+    if (engine != ExecutionEngine::CLOSURE) {
+        result = executeBlock(module->statements, globals);
+    } else if (module->compiled != nullptr) {
+        result = executeCompiled(*module->compiled, globals);
+    } else {
+        result = executeCompiled(*ClosureCompiler().compile(module->statements), globals);
+    }
+    if (std::holds_alternative<Unwind>(result)) [[unlikely]] { return result; }
+    return Nothing{};
+}
+
+/**
+ * @brief 捕获当前的运行时错误。
+ *
+ * 取出并清除错误状态，之后的代码正常执行；返回一个绑定了 catch 变量的新环境。
+ *
+ * @param name catch 变量名。
+ * @return EnvironmentPtr catch 块使用的环境。
+ */
+EnvironmentPtr Interpreter::catchError(const Identifier &name) {
+    LoxObject message = std::string(pendingError->what());
+    pendingError.reset();
+
+    auto handlerEnvironment = make_ref<Environment>(environment);
+    handlerEnvironment->define(name.getLexeme(), message);
+    return handlerEnvironment;
+}
+
 /**
  * @brief 处理 GetExpr 表达式的调用运算符重载。
  *
@@ -305,11 +555,16 @@ StmtResult Interpreter::operator()(const ClassStmtPtr &classStmt) {
  * @return LoxObject 获取到的属性值。
  */
 LoxObject Interpreter::operator()(const GetExprPtr &getExpr) {
-    if (const auto &object = evaluate(getExpr->object); std::holds_alternative<LoxInstancePtr>(object)) {
-        return std::get<LoxInstancePtr>(object)->get(getExpr->name);
+    const auto &object = evaluate(getExpr->object);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
+    if (std::holds_alternative<LoxInstancePtr>(object)) {
+        if (auto property = std::get<LoxInstancePtr>(object)->get(getExpr->name); property.has_value()) {
+            return std::move(property.value());
+        }
+        return raise(getExpr->name.getLoc(), "Undefined property '" + std::string(getExpr->name.getLexeme()) + "'.");
     }
 
-    throw runtime_error(getExpr->name, "Only instances have properties.");
+    return raise(getExpr->name.getLoc(), "Only instances have properties.");
 }
 
 /**
@@ -322,12 +577,14 @@ LoxObject Interpreter::operator()(const GetExprPtr &getExpr) {
  */
 LoxObject Interpreter::operator()(const SetExprPtr &setExpr) {
     const auto &object = evaluate(setExpr->object);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
 
     if (!std::holds_alternative<LoxInstancePtr>(object)) {
-        throw runtime_error(setExpr->name, "Only instances have fields.");
+        return raise(setExpr->name.getLoc(), "Only instances have fields.");
     }
 
     auto value = evaluate(setExpr->value);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
     std::get<LoxInstancePtr>(object)->set(setExpr->name, value);
     return value;
 }
@@ -340,16 +597,16 @@ LoxObject Interpreter::operator()(const SetExprPtr &setExpr) {
  * @param superExpr 指向 SuperExpr 的智能指针，表示父类方法调用表达式。
  * @return LoxObject 方法调用的返回值。
  */
-LoxObject Interpreter::operator()(const SuperExprPtr &superExpr) const {
+LoxObject Interpreter::operator()(const SuperExprPtr &superExpr) {
     // 获取父类对象
     const auto &callable = std::get<LoxCallablePtr>(environment->getAt(superExpr->distance, "super"));
-    const auto &super_class = std::reinterpret_pointer_cast<LoxClass>(callable);
+    const auto &super_class = static_ref_cast<LoxClass>(callable);
     // 获取当前实例
     const auto &instance = std::get<LoxInstancePtr>(environment->getAt(superExpr->distance - 1, "this"));
     // 查找父类方法
     const auto &method = super_class->findMethod(superExpr->method.getLexeme());
     if (method == nullptr) {
-        throw runtime_error(superExpr->method, ("Undefined property" + std::string(superExpr->method.getLexeme())));
+        return raise(superExpr->method.getLoc(), ("Undefined property" + std::string(superExpr->method.getLexeme())));
     }
     // 绑定实例并返回方法
     return method->bind(instance);
@@ -367,10 +624,27 @@ LoxObject Interpreter::operator()(const SuperExprPtr &superExpr) const {
 LoxObject Interpreter::operator()(const BinaryExprPtr &binaryExpr) {
     // 计算左右操作数的值
     const auto &left = evaluate(binaryExpr->left);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
     const auto &right = evaluate(binaryExpr->right);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
+
+    return binary(binaryExpr->op, binaryExpr->loc, left, right);
+}
 
+/**
+ * @brief 对两个已经求值的操作数执行二元运算。
+ *
+ * 树遍历和闭包编译两种执行方式共用该函数。
+ *
+ * @param op 二元运算符。
+ * @param loc 运算符的源码位置。
+ * @param left 左操作数。
+ * @param right 右操作数。
+ * @return LoxObject 运算结果，操作数类型错误时记录运行时错误并返回 nil。
+ */
+LoxObject Interpreter::binary(const BinaryOp op, const SourceLoc loc, const LoxObject &left, const LoxObject &right) {
     // 根据运算符类型执行相应操作
-    switch (binaryExpr->op) {
+    switch (op) {
         case BinaryOp::PLUS: {
             // 处理加法运算
             if (std::holds_alternative<LoxNumber>(left) && std::holds_alternative<LoxNumber>(right)) {
@@ -382,29 +656,29 @@ LoxObject Interpreter::operator()(const BinaryExprPtr &binaryExpr) {
                 return std::get<LoxString>(left) + std::get<LoxString>(right);
             }
 
-            // 如果操作数类型不匹配，抛出错误
-            throw runtime_error(binaryExpr->token, "Operands must be two numbers or two strings.");
+            // 如果操作数类型不匹配，记录运行时错误
+            return raise(loc, "Operands must be two numbers or two strings.");
         }
         case BinaryOp::MINUS:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) - std::get<LoxNumber>(right);
         case BinaryOp::SLASH:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) / std::get<LoxNumber>(right);
         case BinaryOp::STAR:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) * std::get<LoxNumber>(right);
         case BinaryOp::GREATER:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) > std::get<LoxNumber>(right);
         case BinaryOp::GREATER_EQUAL:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) >= std::get<LoxNumber>(right);
         case BinaryOp::LESS:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) < std::get<LoxNumber>(right);
         case BinaryOp::LESS_EQUAL:
-            checkNumberOperands(binaryExpr->token, left, right);
+            if (!checkNumberOperands(loc, left, right)) [[unlikely]] { return LoxNil(); }
             return std::get<LoxNumber>(left) <= std::get<LoxNumber>(right);
         case BinaryOp::BANG_EQUAL:
             return left != right;
@@ -424,7 +698,7 @@ LoxObject Interpreter::operator()(const BinaryExprPtr &binaryExpr) {
  * @param thisExpr 指向 ThisExpr 的智能指针，表示 this 表达式。
  * @return LoxObject 当前实例的引用。
  */
-LoxObject Interpreter::operator()(const ThisExprPtr &thisExpr) const {
+LoxObject Interpreter::operator()(const ThisExprPtr &thisExpr) {
     return lookUpVariable(thisExpr->name, *thisExpr);
 }
 
@@ -441,27 +715,14 @@ LoxObject Interpreter::operator()(const GroupingExprPtr &groupingExpr) { return
 /**
  * @brief 处理 LiteralExpr 表达式的调用运算符重载。
  *
- * 该函数用于处理字面量表达式，将字面量值转换为 LoxObject。
+ * 该函数用于处理字面量表达式，返回构造 AST 时已转换好的 LoxObject。
  *
  * @param literalExpr 指向 LiteralExpr 的智能指针，表示字面量表达式。
  * @return LoxObject 字面量值对应的 LoxObject。
  */
 LoxObject Interpreter::operator()(const LiteralExprPtr &literalExpr) const {
-    // 使用 std::visit 遍历 literalExpr->value 的变体类型
-    return std::visit(
-        // 定义一个 overloaded 结构体，用于处理不同类型的字面量
-        overloaded{
-            // 处理布尔类型字面量
-            [](const bool value) -> LoxObject { return value; },
-            // 处理双精度浮点类型字面量
-            [](const double value) -> LoxObject { return value; },
-            // 处理字符串视图类型字面量，将其转换为 std::string 类型
-            [](const std::string_view value) -> LoxObject { return std::string(value); },
-            // 处理空指针类型字面量，返回 LoxNil 类型
-            [](const std::nullptr_t) -> LoxObject { return LoxNil(); },
-        },
-        literalExpr->value
-    );
+    // 字面量在构造 AST 时已经转换为运行时值，直接返回它的副本
+    return literalExpr->value;
 }
 
 /**
@@ -470,15 +731,16 @@ LoxObject Interpreter::operator()(const LiteralExprPtr &literalExpr) const {
  * 该函数根据变量的作用域距离查找变量的值。如果距离为 -1，表示全局变量；
  * 否则，根据距离在环境中查找变量。
  *
- * @param name 变量的 Token。
+ * @param name 变量名。
  * @param expr 包含变量作用域距离的表达式。
- * @return LoxObject& 变量的引用。
+ * @return LoxObject 变量的值，全局变量未定义时记录运行时错误并返回 nil。
  */
-[[nodiscard]] LoxObject &Interpreter::lookUpVariable(const Token &name, const Assignable &expr) const {
+LoxObject Interpreter::lookUpVariable(const Identifier &name, const Assignable &expr) {
     // 判断变量是否为全局变量
     if (expr.distance == -1) {
         // 如果是全局变量，从全局环境中获取变量的值
-        return globals->get(name);
+        if (const LoxObject *value = globals->get(name); value != nullptr) [[likely]] { return *value; }
+        return raise(name.getLoc(), "Undefined variable '" + std::string(name.getLexeme()) + "'.");
     }
     // 如果是局部变量，根据作用域距离从当前环境中获取变量的值
     return environment->getAt(expr.distance, name.getLexeme());
@@ -495,6 +757,7 @@ LoxObject Interpreter::operator()(const LiteralExprPtr &literalExpr) const {
 LoxObject Interpreter::operator()(const LogicalExprPtr &logicalExpr) {
     // 计算逻辑表达式的左操作数
     auto left = evaluate(logicalExpr->left);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
 
     // 判断逻辑运算符类型
     if (logicalExpr->op == LogicalOp::OR) {
@@ -521,11 +784,13 @@ LoxObject Interpreter::operator()(const LogicalExprPtr &logicalExpr) {
 LoxObject Interpreter::operator()(const UnaryExprPtr &unaryExpr) {
     // 计算一元表达式的操作数
     const auto &result = evaluate(unaryExpr->expression);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
     // 根据一元运算符类型进行相应操作
     switch (unaryExpr->op) {
         case UnaryOp::MINUS: {
             // 如果是负号运算符，检查操作数是否为数字类型，并返回其相反数
-            return -checkNumberOperand(unaryExpr->token, result);
+            if (!checkNumberOperand(unaryExpr->loc, result)) [[unlikely]] { return LoxNil(); }
+            return -std::get<LoxNumber>(result);
         }
         case UnaryOp::BANG:
             // 如果是逻辑非运算符，返回操作数的逻辑非结果
@@ -544,7 +809,7 @@ LoxObject Interpreter::operator()(const UnaryExprPtr &unaryExpr) {
  * @param varExpr 指向 VarExpr 的智能指针，表示变量表达式。
  * @return LoxObject 变量的值。
  */
-LoxObject Interpreter::operator()(const VarExprPtr &varExpr) const {
+LoxObject Interpreter::operator()(const VarExprPtr &varExpr) {
     // 调用 lookUpVariable 函数查找变量的值
     return lookUpVariable(varExpr->name, *varExpr);
 }
@@ -562,10 +827,15 @@ LoxObject Interpreter::operator()(const VarExprPtr &varExpr) const {
 LoxObject Interpreter::operator()(const AssignExprPtr &assignExpr) {
     // 计算赋值表达式右侧的值
     const auto &value = evaluate(assignExpr->value);
+    if (unwinding()) [[unlikely]] { return LoxNil(); }
     // 判断变量是否为全局变量
     if (assignExpr->distance == -1) {
         // 如果是全局变量，在全局环境中进行赋值
-        globals->assign(assignExpr->name, value);
+        if (!globals->assign(assignExpr->name, value)) [[unlikely]] {
+            return raise(
+                assignExpr->name.getLoc(), "Undefined variable '" + std::string(assignExpr->name.getLexeme()) + "'."
+            );
+        }
     } else {
         // 如果是局部变量，根据作用域距离在局部环境中进行赋值
         environment->assignAt(assignExpr->distance, assignExpr->name, value);
@@ -574,6 +844,24 @@ LoxObject Interpreter::operator()(const AssignExprPtr &assignExpr) {
     return value;
 }
 
+/**
+ * @brief 处理插值字符串表达式。
+ *
+ * 依次对内嵌表达式求值，然后一次性拼接出结果字符串。
+ *
+ * @param interpolationExpr 指向 InterpolationExpr 的智能指针。
+ * @return LoxObject 拼接得到的字符串。
+ */
+LoxObject Interpreter::operator()(const InterpolationExprPtr &interpolationExpr) {
+    llvm::SmallVector<LoxObject, 8> values;
+    values.reserve(interpolationExpr->expressions.size());
+    for (const auto &expression: interpolationExpr->expressions) {
+        values.push_back(evaluate(expression));
+        if (unwinding()) [[unlikely]] { return LoxNil(); }
+    }
+    return interpolate(interpolationExpr->strings, values);
+}
+
 
 /**
  * @brief 计算表达式的值。
@@ -598,20 +886,242 @@ StmtResult Interpreter::evaluate(const Stmt &stmt) { return std::visit(*this, st
 /**
  * @brief 执行程序。
  *
- * 该函数依次执行程序中的每个语句，并捕获可能的运行时错误。
+ * 该函数依次执行程序中的每个语句，并报告可能的运行时错误。
  *
  * @param program 要执行的程序，即语句列表。
  */
 void Interpreter::evaluate(const Program &program) {
     try {
-        // 依次执行程序中的每个语句
-        for (const auto &stmt: program) { evaluate(stmt); }
+        execute(program);
     } catch (const runtime_error &e) {
         // 捕获并处理运行时错误
         runtimeError(e);
     }
 }
 
+/**
+ * @brief 执行程序，出错时抛出异常。
+ *
+ * 解释器内部只传递错误状态，这里是唯一把错误状态转换为 C++ 异常的地方。
+ *
+ * @param program 要执行的程序，即语句列表。
+ */
+void Interpreter::execute(const Program &program) {
+    if (engine == ExecutionEngine::CLOSURE) {
+        // 先把整个程序编译为闭包，再依次执行
+        const auto compiled = ClosureCompiler().compile(program);
+        for (const auto &stmt: compiled->statements) {
+            if (std::holds_alternative<Unwind>(stmt(*this))) [[unlikely]] { break; }
+        }
+    } else {
+        // 依次执行程序中的每个语句
+        for (const auto &stmt: program) {
+            if (std::holds_alternative<Unwind>(evaluate(stmt))) [[unlikely]] { break; }
+        }
+    }
+    if (pendingError.has_value()) {
+        // 清除错误状态，使解释器可以继续执行后续程序
+        auto error = std::move(pendingError.value());
+        pendingError.reset();
+        function_depth = 0;
+        environment = globals;
+        throw error;
+    }
+}
+
+/**
+ * @brief 以给定的参数调用一个全局函数，出错时抛出异常。
+ *
+ * @param name 全局函数名。
+ * @param arguments 参数列表。
+ * @return LoxObject 调用结果。
+ */
+LoxObject Interpreter::callGlobal(const Identifier &name, const std::vector<LoxObject> &arguments) {
+    LoxObject result;
+    if (const auto *callee = globals->get(name); callee == nullptr) {
+        raise(name.getLoc(), "Undefined function '" + std::string(name.getLexeme()) + "'.");
+    } else {
+        // 复制一份：调用过程中定义新的全局变量可能使指向全局环境的指针失效
+        const LoxObject function = *callee;
+        result = call(name.getLoc(), function, arguments);
+    }
+    if (pendingError.has_value()) {
+        auto error = std::move(pendingError.value());
+        pendingError.reset();
+        function_depth = 0;
+        environment = globals;
+        throw error;
+    }
+    return result;
+}
+
+/**
+ * @brief 安全点慢路径。
+ *
+ * 检查中断标志，结算本轮消耗的指令数，检查时间和堆大小，再分配下一轮燃料。
+ * 只限制指令数时一轮燃料就是全部剩余指令；启用时间或内存限制（或热重载、指标、中断标志）时，每轮最多 SAFEPOINT_INTERVAL 个安全点。
+ *
+ * @param loc 安全点的源码位置。
+ * @return bool 预算未耗尽时返回 true，否则记录运行时错误并返回 false。
+ */
+bool Interpreter::refuel(const SourceLoc loc) {
+    // 预算耗尽后不再恢复，下一个安全点立即再次报错
+    if (exhausted) {
+        fuel = fuelSlice = 1;
+        raise(loc, "Execution budget exhausted.");
+        return false;
+    }
+
+    // 服务停止时中断正在执行的请求
+    if (interrupt != nullptr && interrupt->load(std::memory_order_relaxed)) [[unlikely]] {
+        exhausted = true;
+        fuel = fuelSlice = 1;
+        raise(loc, "Interrupted.");
+        return false;
+    }
+
+    // 热重载在两个语句之间的安全点上执行，只修改全局环境
+    if (hotReload && reloadPending.load(std::memory_order_acquire)) [[unlikely]] { applyReloads(); }
+    // 运行时指标同样在安全点上采样
+    if (metrics != nullptr && metrics->due()) [[unlikely]] { metrics->sample(); }
+
+    // 结算本轮消耗的指令数
+    const auto consumed = static_cast<std::uint64_t>(fuelSlice - std::max<std::int64_t>(fuel, 0));
+    if (limits.maxInstructions > 0) {
+        // 上一轮已经用完全部指令，当前这条指令超出预算
+        if (instructionsLeft == 0) {
+            exhausted = true;
+            fuel = fuelSlice = 1;
+            raise(loc, "Instruction limit exceeded.");
+            return false;
+        }
+        instructionsLeft -= std::min(consumed, instructionsLeft);
+    }
+
+    // 检查墙钟时间
+    if (limits.timeout.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+        exhausted = true;
+        fuel = fuelSlice = 1;
+        raise(loc, "Timeout exceeded.");
+        return false;
+    }
+
+    // 检查本线程堆的增长
+    if (limits.maxHeapBytes > 0) {
+        if (const std::int64_t grown = threadHeapBytes() - heapBaseline;
+            grown > 0 && static_cast<std::size_t>(grown) > limits.maxHeapBytes) {
+            exhausted = true;
+            fuel = fuelSlice = 1;
+            raise(loc, "Heap limit exceeded.");
+            return false;
+        }
+    }
+
+    // 分配下一轮燃料；指令恰好用完时燃料为 1，使下一个安全点报错
+    std::uint64_t slice = std::max<std::uint64_t>(instructionsLeft, 1);
+    if (limits.timeout.count() > 0 || limits.maxHeapBytes > 0 || hotReload || metrics != nullptr || interrupt != nullptr) {
+        slice = std::min<std::uint64_t>(slice, SAFEPOINT_INTERVAL);
+    }
+    fuel = fuelSlice = static_cast<std::int64_t>(std::min<std::uint64_t>(slice, INT64_MAX));
+    return true;
+}
+
+/**
+ * @brief 记录运行时错误。
+ *
+ * 只保留第一个错误，返回 nil 供表达式求值直接返回。
+ *
+ * @param loc 出错位置。
+ * @param message 错误信息。
+ * @return LoxObject nil。
+ */
+LoxObject Interpreter::raise(const SourceLoc loc, const std::string &message) {
+    if (!pendingError.has_value()) { pendingError.emplace(loc, message); }
+    return LoxNil();
+}
+
+/**
+ * @brief 提交一组重新加载的声明。
+ *
+ * @param declarations 已经完成变量解析的声明。
+ */
+void Interpreter::scheduleReload(std::shared_ptr<const Module> declarations) {
+    std::lock_guard lock(reloadMutex);
+    pendingReloads.push_back(std::move(declarations));
+    reloadPending.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 执行所有已提交的重载。
+ *
+ * 同名的类先记下原来的类对象，执行声明之后把新的父类和方法移到原来的对象上，再放回全局环境，
+ * 这样已有的实例和保存了类对象的变量都会使用新的定义。出错的重载只输出错误，程序继续运行。
+ *
+ * 一次重载中的声明要么全部生效，要么全部不生效：执行前记下每个名字原来的值，任何一个声明出错时
+ * 把已经执行的声明全部恢复，原来的类对象也不会被修改。重载在安全点上同步执行，期间没有 Lox 代码运行。
+ * 模块的 AST 无论成败都保留下来：出错之前定义的函数可能已经被其他地方引用，它们的字符串字面量借用其中的文本。
+ */
+void Interpreter::applyReloads() {
+    std::vector<std::shared_ptr<const Module>> modules;
+    {
+        std::lock_guard lock(reloadMutex);
+        modules.swap(pendingReloads);
+        reloadPending.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto &module: modules) {
+        reloaded.push_back(module);
+        // 每个声明的名字在执行前的值，原来没有定义的为空
+        std::vector<std::pair<const Identifier *, std::optional<LoxObject>>> bindings;
+        std::vector<std::pair<const Identifier *, LoxClassPtr>> classes;
+        for (const auto &stmt: module->statements) {
+            const Identifier *name = nullptr;
+            if (const auto *functionStmt = std::get_if<FunctionStmtPtr>(&stmt)) { name = &(*functionStmt)->name; }
+            if (const auto *classStmt = std::get_if<ClassStmtPtr>(&stmt)) { name = &(*classStmt)->name; }
+            if (name == nullptr) { continue; }
+            const auto *value = globals->get(*name);
+            bindings.emplace_back(name, value != nullptr ? std::optional<LoxObject>(*value) : std::nullopt);
+            if (value == nullptr || !std::holds_alternative<ClassStmtPtr>(stmt) ||
+                !std::holds_alternative<LoxCallablePtr>(*value)) {
+                continue;
+            }
+            if (dynamic_cast<LoxClass *>(std::get<LoxCallablePtr>(*value).get()) != nullptr) {
+                classes.emplace_back(name, static_ref_cast<LoxClass>(std::get<LoxCallablePtr>(*value)));
+            }
+        }
+
+        if (engine == ExecutionEngine::CLOSURE) {
+            executeCompiled(*ClosureCompiler().compile(module->statements), globals);
+        } else {
+            executeBlock(module->statements, globals);
+        }
+        if (pendingError.has_value()) {
+            // 重载失败不是程序的运行时错误，不影响退出状态
+            const bool failed = hadRuntimeError;
+            runtimeError(pendingError.value());
+            hadRuntimeError = failed;
+            pendingError.reset();
+            // 撤销已经执行的声明
+            for (const auto &[name, value]: bindings) {
+                if (value.has_value()) {
+                    globals->define(name->getLexeme(), *value);
+                } else {
+                    globals->remove(name->getLexeme());
+                }
+            }
+            continue;
+        }
+
+        for (const auto &[name, previous]: classes) {
+            const auto replaced = static_ref_cast<LoxClass>(std::get<LoxCallablePtr>(*globals->get(*name)));
+            previous->superClass = replaced->superClass;
+            previous->methods = replaced->methods;
+            previous->initializer = replaced->initializer;
+            globals->assign(*name, previous);
+        }
+    }
+}
+
 /**
  * @brief 执行代码块。
  *
@@ -619,7 +1129,7 @@ void Interpreter::evaluate(const Program &program) {
  *
  * @param statements 要执行的语句列表。
  * @param newenvironment 新的环境。
- * @return StmtResult 执行结果，如果代码块中遇到 Return 语句则返回该结果，否则返回 Nothing。
+ * @return StmtResult 执行结果，如果代码块中遇到 Return 语句或运行时错误则返回该结果，否则返回 Nothing。
  */
 StmtResult Interpreter::executeBlock(const StmtList &statements, const EnvironmentPtr &newenvironment) {
     // 保存原来的环境
@@ -630,8 +1140,9 @@ StmtResult Interpreter::executeBlock(const StmtList &statements, const Environme
     // 依次执行代码块中的每个语句
     for (const auto &statement: statements) {
         // 执行语句
-        if (auto result = evaluate(statement); std::holds_alternative<Return>(result)) {
-            // 如果语句执行结果不是 Nothing，恢复原来的环境并返回该结果
+        if (auto result = evaluate(statement);
+            std::holds_alternative<Return>(result) || std::holds_alternative<Unwind>(result)) {
+            // 如果遇到 Return 语句或运行时错误，恢复原来的环境并返回该结果
             environment = previous;
             return result;
         }
@@ -643,3 +1154,31 @@ StmtResult Interpreter::executeBlock(const StmtList &statements, const Environme
     return Nothing{};
 }
 
+/**
+ * @brief 执行编译后的代码块。
+ *
+ * 该函数在新的环境中依次调用编译后的语句闭包，并在执行完毕后恢复原来的环境。
+ *
+ * @param block 编译后的语句块。
+ * @param newenvironment 新的环境。
+ * @return StmtResult 执行结果，如果代码块中遇到 Return 语句或运行时错误则返回该结果，否则返回 Nothing。
+ */
+StmtResult Interpreter::executeCompiled(const CompiledBlock &block, const EnvironmentPtr &newenvironment) {
+    // 保存原来的环境并设置新的环境
+    const auto previous = environment;
+    environment = newenvironment;
+
+    for (const auto &statement: block.statements) {
+        if (auto result = statement(*this);
+            std::holds_alternative<Return>(result) || std::holds_alternative<Unwind>(result)) {
+            // 如果遇到 Return 语句或运行时错误，恢复原来的环境并返回该结果
+            environment = previous;
+            return result;
+        }
+    }
+
+    // 恢复原来的环境
+    environment = previous;
+    return Nothing{};
+}
+
@@ -0,0 +1,580 @@
+#include "Lox/Json.h"
+#include "Lox/LoxClass.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "frontend/SourceMap.h"
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 数组和对象嵌套的最大深度，超过时报告错误而不是耗尽栈空间；序列化时也用它发现循环引用
+static constexpr int MAX_JSON_DEPTH = 1024;
+
+// 一个 64 字节块中各类字符的位掩码，第 i 位对应块中第 i 个字节
+struct BlockMasks {
+    std::uint64_t quote = 0;
+    std::uint64_t backslash = 0;
+    std::uint64_t structural = 0;
+    std::uint64_t whitespace = 0;
+};
+
+/**
+ * @brief 对 64 字节的块做字符分类
+ *
+ * SSE2 下每 16 字节用几次 pcmpeqb + pmovmskb 得到掩码；'[' ']' 与 '{' '}' 只差 0x20 这一位，
+ * 先或上 0x20 再比较，两次比较就能覆盖四个括号。
+ *
+ * @param block 块的起始地址，调用方保证可以读取 64 字节
+ * @return BlockMasks 块的字符分类
+ */
+static BlockMasks classify(const char *block) {
+    BlockMasks masks;
+#if defined(__SSE2__)
+    for (int i = 0; i < 4; i++) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        const __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        const auto equal = [](const __m128i bytes, const char c) { return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)); };
+        const auto bits = [i](const __m128i match) {
+            return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(match))) << (16 * i);
+        };
+        masks.quote |= bits(equal(chunk, '"'));
+        masks.backslash |= bits(equal(chunk, '\\'));
+        masks.structural |= bits(_mm_or_si128(
+            _mm_or_si128(equal(folded, '{'), equal(folded, '}')), _mm_or_si128(equal(chunk, ':'), equal(chunk, ','))
+        ));
+        masks.whitespace |= bits(_mm_or_si128(
+            _mm_or_si128(equal(chunk, ' '), equal(chunk, '\t')), _mm_or_si128(equal(chunk, '\n'), equal(chunk, '\r'))
+        ));
+    }
+#else
+    for (int i = 0; i < 64; i++) {
+        const std::uint64_t bit = std::uint64_t{1} << i;
+        switch (block[i]) {
+            case '"': masks.quote |= bit; break;
+            case '\\': masks.backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks.structural |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': masks.whitespace |= bit; break;
+            default: break;
+        }
+    }
+#endif
+    return masks;
+}
+
+/**
+ * @brief 计算块中哪些字符被反斜杠转义
+ *
+ * 只在块中出现反斜杠（或上一块以未转义的反斜杠结尾）时调用，循环次数等于反斜杠的个数。
+ *
+ * @param backslash 块中反斜杠的位掩码
+ * @param carry 输入为上一块最后一个字节是否是未转义的反斜杠，输出为本块的对应结果
+ * @return std::uint64_t 被转义字符的位掩码
+ */
+static std::uint64_t escapedChars(std::uint64_t backslash, std::uint64_t &carry) {
+    std::uint64_t escaped = carry;
+    carry = 0;
+    backslash &= ~escaped;
+    while (backslash != 0) {
+        const std::uint64_t bit = backslash & -backslash;
+        backslash ^= bit;
+        if (bit == std::uint64_t{1} << 63) {
+            carry = 1;
+        } else {
+            // 被转义的反斜杠不再转义下一个字符
+            escaped |= bit << 1;
+            backslash &= ~(bit << 1);
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief 前缀异或：结果的第 i 位是 x 的第 0 到 i 位的异或
+ *
+ * 对引号掩码做前缀异或，得到的就是"位于一对引号之间"的掩码（包含开引号，不包含闭引号）。
+ */
+static std::uint64_t prefixXor(std::uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+bool scanJsonStructurals(const std::string_view text, std::vector<std::uint32_t> &indices) {
+    // 跨块传递的状态：上一块末尾的反斜杠、是否仍在字符串内部、是否仍在标量内部
+    std::uint64_t escapeCarry = 0;
+    std::uint64_t inStringCarry = 0;
+    std::uint64_t scalarCarry = 0;
+
+    for (std::size_t base = 0; base < text.size(); base += 64) {
+        const char *block = text.data() + base;
+        // 最后一个不足 64 字节的块复制出来，用空白补齐
+        std::array<char, 64> tail;
+        if (text.size() - base < 64) {
+            tail.fill(' ');
+            std::memcpy(tail.data(), block, text.size() - base);
+            block = tail.data();
+        }
+
+        const auto masks = classify(block);
+        const std::uint64_t escaped =
+            masks.backslash == 0 && escapeCarry == 0 ? 0 : escapedChars(masks.backslash, escapeCarry);
+        const std::uint64_t quote = masks.quote & ~escaped;
+        const std::uint64_t inString = prefixXor(quote) ^ inStringCarry;
+        inStringCarry = static_cast<std::uint64_t>(static_cast<std::int64_t>(inString) >> 63);
+
+        // 字符串之外的结构字符、全部引号，以及字符串之外连续非空白非结构字符（数字、true 等）的起点
+        const std::uint64_t outside = ~(inString | quote);
+        const std::uint64_t scalar = ~(masks.structural | masks.whitespace) & outside;
+        const std::uint64_t scalarStart = scalar & ~(scalar << 1 | scalarCarry);
+        scalarCarry = scalar >> 63;
+        std::uint64_t bits = (masks.structural & outside) | quote | scalarStart;
+
+        // 先按位数扩容，再逐位写入，避免每个位置都检查容量
+        const std::size_t count = indices.size();
+        indices.resize(count + std::popcount(bits));
+        for (auto *out = indices.data() + count; bits != 0; bits &= bits - 1) {
+            *out++ = static_cast<std::uint32_t>(base + std::countr_zero(bits));
+        }
+    }
+    return inStringCarry == 0;
+}
+
+/**
+ * @brief JSON 对象对应的 Lox 类，没有方法
+ *
+ * 键都已在 SourceMap 中驻留的对象共用这个类。引用计数不是原子的，每个线程各用一个。
+ */
+static const LoxClassPtr &objectClass() {
+    static thread_local const LoxClassPtr klass =
+        make_ref<LoxClass>("Object", std::nullopt, std::unordered_map<std::string_view, LoxFunctionPtr>{});
+    return klass;
+}
+
+/**
+ * @brief 第二阶段：沿着第一阶段给出的位置递归下降，构造 Lox 值
+ *
+ * 格式错误时记录第一条错误信息并返回 nil，每层递归返回后检查 failed()，不使用异常。
+ */
+class JsonParser {
+public:
+    JsonParser(const LoxString &text, const std::vector<std::uint32_t> &indices, std::string &error)
+        : text{text}, input{text.view()}, indices{indices}, error{error} {}
+
+    LoxObject parseDocument() {
+        auto value = parseValue(0);
+        if (!failed() && next < indices.size()) { return fail("unexpected trailing characters", indices[next]); }
+        return value;
+    }
+
+private:
+    const LoxString &text;
+    const std::string_view input;
+    const std::vector<std::uint32_t> &indices;
+    // 下一个要处理的位置在 indices 中的下标
+    std::size_t next = 0;
+    // 本文档中原始键文本到键的缓存，同名的键只查找一次；second 表示键是否保存在本文档的键表中
+    std::unordered_map<std::string_view, std::pair<std::string_view, bool>> keys;
+    // 本文档的键表和持有它的类，第一次遇到程序中没有出现过的键时才创建
+    std::shared_ptr<std::deque<std::string>> ownKeys;
+    LoxClassPtr documentClass;
+    // 第一条错误信息，没有错误时为空
+    std::string &error;
+
+    // 记录错误并返回 nil
+    LoxObject fail(const std::string_view message, const std::size_t offset) {
+        if (!failed()) { error = "jsonParse: " + std::string(message) + " at offset " + std::to_string(offset) + "."; }
+        return nullptr;
+    }
+
+    [[nodiscard]] bool failed() const { return !error.empty(); }
+
+    // 下一个位置上的字符，没有更多位置时为 '\0'
+    [[nodiscard]] char peek() const { return next < indices.size() ? input[indices[next]] : '\0'; }
+
+    // 下一个位置的偏移量，用于错误信息
+    [[nodiscard]] std::size_t offset() const { return next < indices.size() ? indices[next] : input.size(); }
+
+    // 标量之后必须是结构字符、空白或输入结尾
+    [[nodiscard]] bool atBoundary(const std::size_t position) const {
+        return position >= input.size() || std::string_view("{}[]:, \t\n\r").find(input[position]) != std::string_view::npos;
+    }
+
+    LoxObject parseValue(const int depth) {
+        if (next >= indices.size()) { return fail("unexpected end of input", input.size()); }
+        const std::uint32_t position = indices[next++];
+        switch (input[position]) {
+            case '{': return parseObject(position, depth + 1);
+            case '[': return parseArray(position, depth + 1);
+            case '"': return parseString(position);
+            case '}':
+            case ']':
+            case ':':
+            case ',': return fail(std::string("unexpected '") + input[position] + "'", position);
+            default: return parseScalar(position);
+        }
+    }
+
+    LoxObject parseObject(const std::uint32_t position, const int depth) {
+        if (depth > MAX_JSON_DEPTH) { return fail("nesting too deep", position); }
+        auto instance = make_ref<LoxInstance>(objectClass());
+        if (peek() == '}') {
+            next++;
+            return instance;
+        }
+        while (true) {
+            if (peek() != '"') { return fail("expected a string key", offset()); }
+            const auto key = parseKey(indices[next++], *instance);
+            if (failed()) { return nullptr; }
+            if (peek() != ':') { return fail("expected ':'", offset()); }
+            next++;
+            auto value = parseValue(depth);
+            if (failed()) { return nullptr; }
+            instance->fields.insert_or_assign(key, std::move(value));
+            const char c = peek();
+            if (c != ',' && c != '}') { return fail("expected ',' or '}'", offset()); }
+            next++;
+            if (c == '}') { return instance; }
+        }
+    }
+
+    LoxObject parseArray(const std::uint32_t position, const int depth) {
+        if (depth > MAX_JSON_DEPTH) { return fail("nesting too deep", position); }
+        auto list = make_ref<LoxList>();
+        if (peek() == ']') {
+            next++;
+            return list;
+        }
+        while (true) {
+            list->elements.push_back(parseValue(depth));
+            if (failed()) { return nullptr; }
+            const char c = peek();
+            if (c != ',' && c != ']') { return fail("expected ',' or ']'", offset()); }
+            next++;
+            if (c == ']') { return list; }
+        }
+    }
+
+    // 开引号之后的下一个位置一定是配对的闭引号，两者之间是字符串的原始内容
+    std::string_view rawString(const std::uint32_t open) {
+        const std::uint32_t close = indices[next++];
+        return input.substr(open + 1, close - open - 1);
+    }
+
+    LoxObject parseString(const std::uint32_t open) {
+        const auto raw = rawString(open);
+        if (std::memchr(raw.data(), '\\', raw.size()) == nullptr) { return text.slice(open + 1, raw.size()); }
+        auto unescaped = unescape(raw, open);
+        if (failed()) { return nullptr; }
+        return LoxString(std::move(unescaped));
+    }
+
+    /**
+     * @brief 解析对象的键
+     *
+     * 实例的字段表以 std::string_view 为键，键必须比实例活得更久。程序中出现过的名字已在 SourceMap 中驻留，
+     * 直接复用；其余的键只属于这个文档，保存在本文档的键表中，由实例的类持有，随最后一个引用它的对象一起释放，
+     * 不会因为数据中的键各不相同而让全局的驻留池无限增长。
+     *
+     * @param open 开引号的偏移量
+     * @param instance 键所属的实例，用到本文档的键表时改用持有键表的类
+     */
+    std::string_view parseKey(const std::uint32_t open, LoxInstance &instance) {
+        const auto raw = rawString(open);
+        auto it = keys.find(raw);
+        if (it == keys.end()) {
+            std::string unescaped;
+            if (std::memchr(raw.data(), '\\', raw.size()) != nullptr) {
+                unescaped = unescape(raw, open);
+                if (failed()) { return {}; }
+            }
+            const std::string_view text = unescaped.empty() ? raw : unescaped;
+            if (const auto symbol = SourceMap::instance().find(text)) {
+                it = keys.emplace(raw, std::pair{*symbol, false}).first;
+            } else {
+                if (ownKeys == nullptr) {
+                    ownKeys = std::make_shared<std::deque<std::string>>();
+                    documentClass = make_ref<LoxClass>("Object", std::nullopt, std::unordered_map<std::string_view, LoxFunctionPtr>{});
+                    documentClass->storage = ownKeys;
+                }
+                it = keys.emplace(raw, std::pair{std::string_view(ownKeys->emplace_back(text)), true}).first;
+            }
+        }
+        if (it->second.second) { instance.klass = documentClass; }
+        return it->second.first;
+    }
+
+    LoxObject parseScalar(const std::uint32_t position) {
+        const auto word = [this, position](const std::string_view literal) {
+            return input.substr(position, literal.size()) == literal && atBoundary(position + literal.size());
+        };
+        const char c = input[position];
+        if (c == 't' && word("true")) { return true; }
+        if (c == 'f' && word("false")) { return false; }
+        if (c == 'n' && word("null")) { return nullptr; }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            // from_chars 还接受前导零、"1."、".5" 和 inf，先按 JSON 的数字语法确定结尾
+            const std::size_t end = numberEnd(position);
+            LoxNumber number;
+            if (end != 0 && atBoundary(end)) {
+                const auto [ptr, ec] = std::from_chars(input.data() + position, input.data() + end, number);
+                if (ec == std::errc::result_out_of_range) { return fail("number out of range", position); }
+                if (ptr == input.data() + end) { return number; }
+            }
+        }
+        return fail("invalid value", position);
+    }
+
+    /**
+     * @brief 按 JSON 的数字语法 -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? 找出数字的结尾
+     *
+     * @return std::size_t 数字之后的位置，不符合语法时为 0
+     */
+    [[nodiscard]] std::size_t numberEnd(std::size_t position) const {
+        const auto digit = [this](const std::size_t at) { return at < input.size() && input[at] >= '0' && input[at] <= '9'; };
+        const auto digits = [&](std::size_t at) {
+            while (digit(at)) { at++; }
+            return at;
+        };
+        if (position < input.size() && input[position] == '-') { position++; }
+        if (!digit(position)) { return 0; }
+        // 0 之后不能再跟数字
+        position = input[position] == '0' ? position + 1 : digits(position);
+        if (position < input.size() && input[position] == '.') {
+            if (!digit(position + 1)) { return 0; }
+            position = digits(position + 1);
+        }
+        if (position < input.size() && (input[position] == 'e' || input[position] == 'E')) {
+            position++;
+            if (position < input.size() && (input[position] == '+' || input[position] == '-')) { position++; }
+            if (!digit(position)) { return 0; }
+            position = digits(position);
+        }
+        return position;
+    }
+
+    // 读取 \u 之后的四位十六进制数，格式错误时记录错误并返回 0
+    std::uint32_t hex4(const std::string_view raw, const std::size_t at, const std::size_t position) {
+        std::uint32_t value = 0;
+        if (at + 4 > raw.size() || std::from_chars(raw.data() + at, raw.data() + at + 4, value, 16).ptr != raw.data() + at + 4) {
+            fail("invalid unicode escape", position + 1 + at);
+        }
+        return value;
+    }
+
+    static void appendUtf8(std::string &out, const std::uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            out.push_back(static_cast<char>(codepoint));
+        } else if (codepoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | codepoint >> 6));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else if (codepoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | codepoint >> 12));
+            out.push_back(static_cast<char>(0x80 | (codepoint >> 6 & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | codepoint >> 18));
+            out.push_back(static_cast<char>(0x80 | (codepoint >> 12 & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint >> 6 & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    /**
+     * @brief 处理字符串中的转义序列，\u 转义按 UTF-8 编码，代理对合并为一个码点
+     *
+     * @param raw 字符串的原始内容
+     * @param open 开引号的偏移量，用于错误信息
+     * @return std::string 转义后的内容，出错时内容不完整，由调用方检查 failed()
+     */
+    std::string unescape(const std::string_view raw, const std::uint32_t open) {
+        std::string out;
+        out.reserve(raw.size());
+        for (std::size_t i = 0; i < raw.size(); i++) {
+            // 两个反斜杠之间的字符整段复制
+            const auto *slash = static_cast<const char *>(std::memchr(raw.data() + i, '\\', raw.size() - i));
+            const std::size_t end = slash == nullptr ? raw.size() : slash - raw.data();
+            out.append(raw.substr(i, end - i));
+            if ((i = end) == raw.size()) { break; }
+            if (++i == raw.size()) {
+                fail("invalid escape", open + 1 + i);
+                return out;
+            }
+            switch (raw[i]) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    std::uint32_t codepoint = hex4(raw, i + 1, open);
+                    if (failed()) { return out; }
+                    i += 4;
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00) {
+                        if (raw.substr(i + 1, 2) != "\\u") {
+                            fail("unpaired surrogate", open + 1 + i);
+                            return out;
+                        }
+                        const std::uint32_t low = hex4(raw, i + 3, open);
+                        if (failed()) { return out; }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            fail("unpaired surrogate", open + 1 + i);
+                            return out;
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else if (codepoint >= 0xDC00 && codepoint < 0xE000) {
+                        fail("unpaired surrogate", open + 1 + i);
+                        return out;
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default: fail("invalid escape", open + 1 + i); return out;
+            }
+        }
+        return out;
+    }
+};
+
+std::optional<LoxObject> parseJson(const LoxString &text, std::string &error) {
+    error.clear();
+    if (text.size() > UINT32_MAX) {
+        error = "jsonParse: input larger than 4 GiB.";
+        return std::nullopt;
+    }
+    // 位置数组在同一线程的多次调用之间复用，jsonLines 逐行解析时不必反复分配
+    static thread_local std::vector<std::uint32_t> indices;
+    indices.clear();
+    if (!scanJsonStructurals(text.view(), indices)) {
+        error = "jsonParse: unterminated string.";
+        return std::nullopt;
+    }
+    if (indices.empty()) {
+        error = "jsonParse: empty input.";
+        return std::nullopt;
+    }
+    auto value = JsonParser(text, indices, error).parseDocument();
+    if (!error.empty()) { return std::nullopt; }
+    return value;
+}
+
+/**
+ * @brief 把 Lox 值写成 JSON 文本
+ *
+ * 遇到不能序列化的值时记录第一条错误信息，之后的写入都直接返回。
+ */
+class JsonWriter {
+public:
+    std::string out;
+    // 第一条错误信息，没有错误时为空
+    std::string error;
+
+    void write(const LoxObject &value, const int depth) {
+        if (!error.empty()) { return; }
+        if (depth > MAX_JSON_DEPTH) {
+            error = "jsonStringify: nesting too deep (cyclic value?).";
+            return;
+        }
+        std::visit(
+            overloaded{
+                [this](LoxNil) { out.append("null"); },
+                [this](const LoxBoolean boolean) { out.append(boolean ? "true" : "false"); },
+                [this](const LoxNumber number) { writeNumber(number); },
+                [this](const LoxString &string) { writeString(string.view()); },
+                [this, depth](const LoxListPtr &list) {
+                    out.push_back('[');
+                    for (std::size_t i = 0; i < list->elements.size(); i++) {
+                        if (i > 0) { out.push_back(','); }
+                        write(list->elements[i], depth + 1);
+                    }
+                    out.push_back(']');
+                },
+                [this, depth](const LoxInstancePtr &instance) {
+                    out.push_back('{');
+                    bool first = true;
+                    for (const auto &[key, field]: instance->fields) {
+                        if (!first) { out.push_back(','); }
+                        first = false;
+                        writeString(key);
+                        out.push_back(':');
+                        write(field, depth + 1);
+                    }
+                    out.push_back('}');
+                },
+                [this](const LoxCallablePtr &callable) {
+                    error = "jsonStringify: cannot serialize " + callable->to_string() + ".";
+                },
+            },
+            value
+        );
+    }
+
+private:
+    void writeNumber(const LoxNumber number) {
+        if (!std::isfinite(number)) {
+            out.append("null");
+            return;
+        }
+        std::array<char, 32> buffer;
+        // 可以精确表示的整数按整数输出，与字符串插值一致
+        const auto result = std::trunc(number) == number && std::abs(number) < 0x1p53
+                                ? std::to_chars(buffer.data(), buffer.data() + buffer.size(), static_cast<std::int64_t>(number))
+                                : std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+        out.append(buffer.data(), result.ptr);
+    }
+
+    // 不需要转义的字符整段追加，只在遇到引号、反斜杠和控制字符时逐个处理
+    void writeString(const std::string_view string) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        out.push_back('"');
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < string.size(); i++) {
+            const auto c = static_cast<unsigned char>(string[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') [[likely]] { continue; }
+            out.append(string.substr(run, i - run));
+            run = i + 1;
+            switch (c) {
+                case '"': out.append("\\\""); break;
+                case '\\': out.append("\\\\"); break;
+                case '\n': out.append("\\n"); break;
+                case '\r': out.append("\\r"); break;
+                case '\t': out.append("\\t"); break;
+                case '\b': out.append("\\b"); break;
+                case '\f': out.append("\\f"); break;
+                default:
+                    out.append("\\u00");
+                    out.push_back(HEX[c >> 4]);
+                    out.push_back(HEX[c & 0xF]);
+                    break;
+            }
+        }
+        out.append(string.substr(run));
+        out.push_back('"');
+    }
+};
+
+std::optional<std::string> stringifyJson(const LoxObject &value, std::string &error) {
+    JsonWriter writer;
+    writer.write(value, 0);
+    if (!writer.error.empty()) {
+        error = std::move(writer.error);
+        return std::nullopt;
+    }
+    return std::move(writer.out);
+}
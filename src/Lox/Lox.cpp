@@ -1,69 +1,179 @@
 #include "Lox/Lox.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "frontend/Parser.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <llvm/Support/ErrorHandling.h>
 #include <llvm/Support/raw_ostream.h>
+#include <sstream>
 #include <string>
+#include <unistd.h>
+
+/**
+ * @brief 计算一段输入中尚未闭合的花括号个数。
+ *
+ * 用扫描器得到的 LEFT_BRACE 和 RIGHT_BRACE 计数，字符串和注释中的花括号不算在内。
+ * 扫描错误（例如跨行的字符串还没有结束）在这里不报告，等整段输入执行时再报告。
+ *
+ * @param source 目前读到的输入。
+ * @return long 未闭合的左花括号个数。
+ */
+static long openBraces(const std::string &source) {
+    const bool hadErrorBefore = hadError;
+    auto *const previousDiagnostics = diagnostics;
+    diagnostics = &llvm::nulls();
+    long depth = 0;
+    for (const auto &token: Scanner(source).scanTokens()) {
+        if (token.getType() == LEFT_BRACE) { depth++; }
+        if (token.getType() == RIGHT_BRACE) { depth--; }
+    }
+    diagnostics = previousDiagnostics;
+    hadError = hadErrorBefore;
+    return depth;
+}
+
+Lox::Lox(const ExecutionLimits &limits, const ExecutionEngine engine, const bool autoMemoize)
+    : limits{limits}, resolver(autoMemoize), interpreter(limits, engine) {}
+
+/**
+ * @brief 开启热重载。
+ */
+void Lox::enableHotReload() {
+    interpreter.enableHotReload();
+    reloader = std::make_unique<HotReloader>(interpreter);
+}
+
+/**
+ * @brief 开启运行时指标导出。
+ */
+void Lox::enableMetrics(const MetricsOptions &options) {
+    metrics = std::make_unique<MetricsExporter>(interpreter, options);
+    interpreter.setMetricsExporter(metrics.get());
+}
+
+/**
+ * @brief 开启硬件计数器。
+ */
+void Lox::enablePerfCounters(const bool perFunction) {
+    perf = std::make_unique<PerfProfile>(perFunction);
+    if (perFunction && perf->available()) { interpreter.setPerfProfile(perf.get()); }
+}
 
 /**
  * @brief 运行指定路径的脚本文件。
- * 
- * 该函数尝试打开指定路径的文件，并读取其中的内容。
- * 如果文件无法打开，将输出错误信息并终止程序。
- * 
+ *
+ * 该函数读取指定路径的文件，并运行其中的代码。相对导入路径以脚本所在目录为基准。
+ *
  * @param path 脚本文件的路径。
+ * @return int 退出状态。
  */
-void Lox::runFile(const std::string &path) {
+int Lox::runFile(const std::string &path) {
     // 尝试打开指定路径的文件
-    std::ifstream file(path);
+    const std::ifstream file(path, std::ios_base::binary);
     // 检查文件是否成功打开
-    if (!file.is_open()) {
-        // 使用LLVM的错误输出流输出错误信息
-        llvm::errs() << "could not open the file" << path << "\n";
-        // 报告致命错误并终止程序
-        llvm::report_fatal_error("Failed to open the script file");
+    if (file.fail()) {
+        llvm::errs() << "Cannot open script '" << path << "'.\n";
+        return 66;
     }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return run(buffer.str(), path, std::filesystem::absolute(path).parent_path());
 }
 
 /**
  * @brief 启动REPL（Read-Eval-Print Loop）以接受用户输入并即时运行lox代码。
- * 
+ *
  * 该函数创建一个交互式的命令行环境，允许用户输入Lox代码并立即执行。
  * 它会持续读取用户输入，直到用户终止输入（例如，通过Ctrl+D）。
  */
 void Lox::runPrompt() {
+    // 从管道读取时不输出提示符，输出中只有程序自己的输出
+    const bool interactive = ::isatty(STDIN_FILENO) != 0;
+    // 下一次输入第一行的行号，错误信息中的行号在整个会话中连续
+    int lineNumber = 1;
+    std::string source;
+    int lines = 0;
     // 用于存储用户输入的每一行代码
     std::string line;
-    // 进入无限循环，持续读取用户输入
     while (true) {
-        // 使用LLVM的输出流输出提示符
-        llvm::outs() << ">";
-        // 刷新输出流，确保提示符立即显示
-        llvm::outs().flush();
+        if (interactive) {
+            llvm::outs() << (source.empty() ? "> " : ". ");
+            llvm::outs().flush();
+        }
         // 从标准输入读取一行用户输入
-        if (!std::getline(std::cin, line)) { 
-            // 如果读取失败（例如，用户终止输入），跳出循环
-            break; 
+        if (!std::getline(std::cin, line)) {
+            // 如果读取失败（例如，用户终止输入），执行剩下的输入后退出
+            if (!source.empty()) { run(std::move(source), "<stdin>", std::filesystem::current_path(), lineNumber); }
+            break;
         }
+        source += line;
+        source += '\n';
+        lines++;
+        // 花括号没有闭合时继续读取下一行
+        if (openBraces(source) > 0) { continue; }
+
         // 调用run函数执行用户输入的代码
-        run(line);
-        // 重置错误标记，准备下一次输入
-        hadError = false;
+        run(std::move(source), "<stdin>", std::filesystem::current_path(), lineNumber);
+        llvm::outs().flush();
+        lineNumber += lines;
+        source.clear();
+        lines = 0;
     }
 }
 
 /**
- * 处理并运行lox代码。
- * @param line 包含lox代码的字符串。
+ * @brief 扫描、解析、变量解析并执行一段lox代码。
+ *
+ * 变量解析器和解释器在多次调用之间共享，每次只处理新的代码。编译失败的代码不会执行，也不会保存。
+ *
+ * @param source 包含lox代码的字符串。
+ * @param name 用于错误信息的名字。
+ * @param directory 相对导入路径的基准目录。
+ * @param firstLine 源代码第一行的行号。
+ * @return int 退出状态。
  */
-void Lox::run(const std::string &source) {
-    // 这里通常会调用词法分析器、解析器和解释器
-    // 现在只是简单地输出源代码
-    llvm::outs() << source << "\n";// 使用LLVM的输出流
+int Lox::run(std::string source, const std::string &name, const std::filesystem::path &directory, const int firstLine) {
+    // 重置错误标记，上一段代码的错误不影响这一段
+    hadError = false;
+    hadRuntimeError = false;
 
-    // 示例错误处理
-    if (source.find("error") != std::string::npos) { hadError = true; }
-}
+    auto module = std::make_unique<Module>();
+    module->path = name;
+    module->scanner = std::make_unique<Scanner>(std::move(source), firstLine);
+    // 只有 --perf-counters 时 perf 不为空，各阶段的 Phase 才会读计数器
+    std::vector<Token> tokens;
+    {
+        PerfProfile::Phase phase(perf.get(), PerfPhase::SCAN);
+        tokens = module->scanner->scanTokens();
+    }
+    Parser parser(std::move(tokens));
+    try {
+        PerfProfile::Phase phase(perf.get(), PerfPhase::PARSE);
+        module->statements = parser.parse();
+    } catch (const ParseError &) { return 65; }
+    if (hadError) { return 65; }
 
+    // 导入的模块在工作线程上加载，与变量解析并行
+    auto &loader = ModuleLoader::instance();
+    module->imports = parser.importStatements();
+    loader.loadImports(module->imports, directory);
 
+    {
+        PerfProfile::Phase phase(perf.get(), PerfPhase::RESOLVE);
+        resolver.resolve(module->statements);
+    }
+    if (hadError) { return 65; }
+    if (!loader.waitFor(module->imports)) { return 65; }
+    if (reloader != nullptr) { reloader->watch(*module); }
 
+    const auto &program = chunks.emplace_back(std::move(module))->statements;
+    // 执行预算从每段代码开始执行时计算
+    interpreter.setLimits(limits);
+    {
+        PerfProfile::Phase phase(perf.get(), PerfPhase::EXECUTE);
+        interpreter.evaluate(program);
+    }
+    return hadRuntimeError ? 70 : 0;
+}
@@ -13,13 +13,13 @@
  */
 LoxObject LoxClass::operator()(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
     // 创建一个新的类实例，并将当前类的共享指针传递给它
-    const auto &instance = std::make_shared<LoxInstance>(shared_from_this());
+    const auto &instance = make_ref<LoxInstance>(LoxClassPtr(this));
     // 检查类是否有构造函数
     if (const auto &initializer = this->initializer; initializer != nullptr) {
         // 将构造函数绑定到新创建的实例上
         const auto &function = initializer->bind(instance);
         // 将绑定后的函数转换为可调用对象
-        const auto &callable = std::reinterpret_pointer_cast<LoxCallable>(function);
+        const auto &callable = LoxCallablePtr(function);
         // 调用构造函数，并传递解释器和参数
         (*callable)(interpreter, arguments);
     }
@@ -61,7 +61,7 @@ int LoxClass::arity() {
     // 检查类是否有构造函数
     return this->initializer == nullptr ? 0
         // 如果有构造函数，则返回其参数数量
-        : std::reinterpret_pointer_cast<LoxCallable>(this->initializer)->arity();
+        : this->initializer->arity();
 }
 
 /**
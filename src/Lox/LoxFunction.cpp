@@ -1,4 +1,6 @@
 #include <Lox/LoxFunction.h>
+#include "Lox/ClosureCompiler.h"
+#include "Lox/LoxInstance.h"
 #include <cstddef>
 
 /**
@@ -12,8 +14,59 @@
  * @return LoxObject 函数的返回值。
  */
 LoxObject LoxFunction::operator()(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    calls++;
+    // 被纯度分析判定为可记忆化的函数，参数全为数字或字符串时先查记忆表
+    if (declaration->memoize && MemoCache::isMemoizable(arguments)) {
+        if (memo == nullptr) { memo = std::make_unique<MemoCache>(); }
+        if (auto cached = memo->lookup(arguments); cached.has_value()) { return std::move(cached.value()); }
+        auto result = invoke(interpreter, arguments);
+        // 出错中止的调用没有有效返回值，不写入记忆表
+        if (!interpreter.unwinding()) { memo->insert(arguments, result); }
+        return result;
+    }
+    return invoke(interpreter, arguments);
+}
+
+/**
+ * @brief 在新环境中执行函数体，不经过记忆表。
+ *
+ * @param interpreter 解释器实例，用于执行函数体。
+ * @param arguments 传递给函数的参数列表。
+ * @return LoxObject 函数的返回值。
+ */
+LoxObject LoxFunction::invoke(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
     // 创建一个新的环境，该环境的封闭环境为当前函数的闭包
-    const auto environment = std::make_shared<Environment>(closure);
+    return run(interpreter, arguments, make_ref<Environment>(closure));
+}
+
+/**
+ * @brief 在调用方提供的环境中执行函数体，未被捕获的环境清空后复用。
+ *
+ * @param interpreter 解释器实例，用于执行函数体。
+ * @param arguments 传递给函数的参数列表。
+ * @param frame 调用方保存的环境，为空时创建。
+ * @return LoxObject 函数的返回值。
+ */
+LoxObject LoxFunction::invokeIn(Interpreter &interpreter, const std::vector<LoxObject> &arguments, EnvironmentPtr &frame) {
+    calls++;
+    // 只有调用方持有时才能复用；被闭包或内层环境引用的环境必须保留原样
+    if (frame != nullptr && frame->useCount() == 1) {
+        frame->clear();
+    } else {
+        frame = make_ref<Environment>(closure);
+    }
+    return run(interpreter, arguments, frame);
+}
+
+/**
+ * @brief 在给定环境中绑定参数并执行函数体。
+ *
+ * @param interpreter 解释器实例，用于执行函数体。
+ * @param arguments 传递给函数的参数列表。
+ * @param environment 函数体的环境。
+ * @return LoxObject 函数的返回值。
+ */
+LoxObject LoxFunction::run(Interpreter &interpreter, const std::vector<LoxObject> &arguments, const EnvironmentPtr &environment) {
     // 遍历函数声明中的参数列表
     //auto j = declaration->parameters.size();
     for (size_t i = 0; i < (declaration->parameters.size()); i++) {
@@ -22,8 +75,12 @@ LoxObject LoxFunction::operator()(Interpreter &interpreter, const std::vector<Lo
     }
 
     // 执行函数体，并获取执行结果
-    if (const auto &result = interpreter.executeBlock(declaration->body, environment);
-        std::holds_alternative<Return>(result)) {
+    // 闭包编译执行方式下函数体已经编译好，直接执行编译结果
+    auto result = declaration->compiled != nullptr ? interpreter.executeCompiled(*declaration->compiled, environment)
+                                                   : interpreter.executeBlock(declaration->body, environment);
+    // 函数体因运行时错误中止，返回 nil，由调用方继续向上返回
+    if (std::holds_alternative<Unwind>(result)) [[unlikely]] { return LoxNil(); }
+    if (std::holds_alternative<Return>(result)) {
         // 如果函数是初始化器，返回 `this` 对象
         if (isInitializer) { return std::move(closure->getAt(0, "this")); }
 
@@ -48,11 +105,11 @@ LoxObject LoxFunction::operator()(Interpreter &interpreter, const std::vector<Lo
  */
 LoxFunctionPtr LoxFunction::bind(const LoxInstancePtr &instance) {
     // 创建一个新的环境，该环境的封闭环境为当前函数的闭包
-    auto environment = std::make_shared<Environment>(closure);
+    auto environment = make_ref<Environment>(closure);
     // 将 `this` 绑定到指定的实例上
     environment->define("this", instance);
     // 返回一个新的 LoxFunction 实例，使用新的环境
-    return std::make_shared<LoxFunction>(declaration, environment, isInitializer);
+    return make_ref<LoxFunction>(declaration, environment, isInitializer);
 }
 
 /**
@@ -7,29 +7,28 @@
  * 
  * 该函数尝试获取实例的属性或方法。首先检查实例的字段中是否包含指定名称的属性，如果包含则返回该属性的值。
  * 如果字段中不包含该属性，则尝试在实例所属的类中查找同名的方法。如果找到方法，则将其绑定到当前实例并返回。
- * 如果既没有找到属性也没有找到方法，则抛出运行时错误。
+ * 如果既没有找到属性也没有找到方法，则返回空值，由解释器报告运行时错误。
  * 
- * @param name 要获取的属性或方法的名称的 Token
- * @return LoxObject 属性的值或绑定到当前实例的方法
- * @throws runtime_error 如果属性或方法未定义
+ * @param name 要获取的属性或方法的名称
+ * @return std::optional<LoxObject> 属性的值或绑定到当前实例的方法，未定义时为空
  */
-LoxObject LoxInstance::get(const Token &name) {
+std::optional<LoxObject> LoxInstance::get(const Identifier &name) {
     // 检查实例的字段中是否包含指定名称的属性
-    if (fields.contains(name.getLexeme())) { 
+    if (const auto it = fields.find(name.getLexeme()); it != fields.end()) {
         // 如果包含，则返回该属性的值
-        return fields[name.getLexeme()]; 
+        return it->second;
     }
 
     // 尝试在实例所属的类中查找同名的方法
     if (const auto method = klass->findMethod(name.getLexeme()); method != nullptr) {
-        // 获取当前实例的共享指针
-        const auto instance = shared_from_this();
+        // 获取指向当前实例的句柄
+        const auto instance = LoxInstancePtr(this);
         // 将方法绑定到当前实例，并将其转换为可调用对象返回
-        return std::reinterpret_pointer_cast<LoxCallable>(method->bind(instance));
+        return LoxObject(LoxCallablePtr(method->bind(instance)));
     }
 
-    // 如果既没有找到属性也没有找到方法，则抛出运行时错误
-    throw runtime_error(name, "Undefined property '" + std::string(name.getLexeme()) + "'.");
+    // 如果既没有找到属性也没有找到方法，则返回空值
+    return std::nullopt;
 }
 
 /**
@@ -37,10 +36,10 @@ LoxObject LoxInstance::get(const Token &name) {
  * 
  * 该函数用于设置实例的指定属性的值。如果属性不存在，则会创建该属性。
  * 
- * @param name 要设置的属性的名称的 Token
+ * @param name 要设置的属性的名称
  * @param value 要设置的属性的值
  */
-void LoxInstance::set(const Token &name, const LoxObject &value) { 
+void LoxInstance::set(const Identifier &name, const LoxObject &value) { 
     // 将指定名称的属性设置为指定的值
     fields[name.getLexeme()] = value; 
 }
@@ -1,11 +1,41 @@
 #include "Lox/LoxObject.h"
 #include "Lox/LoxCallable.h"
+#include "Lox/LoxFunction.h"
 #include "Lox/LoxInstance.h"
+#include "frontend/Ast.h"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/raw_ostream.h>
 #include <string>
 #include <iomanip>
 
+/**
+ * @brief 构造字面量表达式，把扫描得到的字面量一次性转换为运行时值。
+ * 
+ * 字符串字面量复制到 text 中，值只借用它：求值时复制值不改动引用计数，
+ * 多个线程上的解释器可以同时执行同一个模块。字面量的值因此不能比 AST 活得更久，
+ * 解释器总是先于它执行的 AST 销毁。
+ * 
+ * @param value 字面量值。
+ */
+LiteralExpr::LiteralExpr(const Literal &value)
+    : text{std::holds_alternative<std::string_view>(value) ? std::get<std::string_view>(value) : std::string_view()},
+      value{std::visit(
+          overloaded{
+              [](const bool literal) -> LoxObject { return literal; },
+              [](const double literal) -> LoxObject { return literal; },
+              [this](const std::string_view) -> LoxObject { return LoxString::borrow(text); },
+              [](const std::nullptr_t) -> LoxObject { return LoxNil(); },
+          },
+          value
+      )} {}
+
+LiteralExpr::~LiteralExpr() = default;
+
 /**
  * @brief 判断一个 LoxObject 是否为真值。
  * 
@@ -39,11 +69,79 @@ std::string to_string(const LoxObject &object) {
             overloaded{
                 [](const LoxBoolean value) -> std::string { return value ? "true" : "false"; },
                 [](const LoxNumber value) -> std::string { return ("{"+  std::to_string(value)+"}"); },
-                [](const LoxString &value) -> std::string { return value; },
+                [](const LoxString &value) -> std::string { return std::string(value.view()); },
                 [](const LoxCallablePtr &callable) -> std::string { return callable->to_string(); },
                 [](const LoxInstancePtr &instance) -> std::string { return instance->to_string(); },
+                [](const LoxListPtr &list) -> std::string { return list->to_string(); },
                 [](LoxNil) -> std::string { return "nil"; },
             },
             object
         );
 }
+
+/**
+ * @brief 拼接插值字符串：strings[0] values[0] strings[1] ... strings[n]。
+ * 
+ * 先把每个值格式化为字符串视图并累计总长度，再一次性分配结果，避免逐个拼接产生中间字符串。
+ * 数字按最短的可往返表示格式化，整数不带小数部分，写入栈上的缓冲区；
+ * 字符串直接引用原缓冲区；只有函数、实例和列表需要临时构造字符串。
+ * 
+ * @param strings 字符串的各段，比 values 多一个元素。
+ * @param values 内嵌表达式的值。
+ * @return LoxString 拼接结果。
+ */
+LoxString interpolate(const std::span<const std::string_view> strings, const std::span<const LoxObject> values) {
+    // 预留足够的空间，保证下面保存的视图不会因为扩容而失效
+    llvm::SmallVector<std::array<char, 32>, 8> numbers;
+    numbers.reserve(values.size());
+    std::vector<std::string> owned;
+    owned.reserve(values.size());
+    llvm::SmallVector<std::string_view, 8> parts;
+    parts.reserve(values.size());
+
+    std::size_t length = 0;
+    for (const auto &string: strings) { length += string.size(); }
+    for (const auto &value: values) {
+        const std::string_view part = std::visit(
+            overloaded{
+                [](const LoxString &string) -> std::string_view { return string.view(); },
+                [&numbers](const LoxNumber number) -> std::string_view {
+                    auto &buffer = numbers.emplace_back();
+                    // 可以精确表示的整数按整数输出，避免 1e+12 这样的指数形式
+                    const auto result = std::trunc(number) == number && std::abs(number) < 0x1p53
+                                            ? std::to_chars(buffer.data(), buffer.data() + buffer.size(), static_cast<std::int64_t>(number))
+                                            : std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+                    return {buffer.data(), static_cast<std::size_t>(result.ptr - buffer.data())};
+                },
+                [](const LoxBoolean boolean) -> std::string_view { return boolean ? "true" : "false"; },
+                [](LoxNil) -> std::string_view { return "nil"; },
+                [&owned, &value](const auto &) -> std::string_view { return owned.emplace_back(::to_string(value)); },
+            },
+            value
+        );
+        length += part.size();
+        parts.push_back(part);
+    }
+
+    std::string text;
+    text.reserve(length);
+    for (std::size_t i = 0; i < parts.size(); i++) { text.append(strings[i]).append(parts[i]); }
+    text.append(strings.back());
+    return {std::move(text)};
+}
+
+LoxList::LoxList(std::vector<LoxObject> elements) : elements{std::move(elements)} {}
+
+/**
+ * @brief 将列表转换为字符串表示，格式为 "[a, b, c]"
+ *
+ * @return std::string 列表的字符串表示
+ */
+std::string LoxList::to_string() const {
+    std::string result = "[";
+    for (std::size_t i = 0; i < elements.size(); i++) {
+        if (i > 0) { result += ", "; }
+        result += ::to_string(elements[i]);
+    }
+    return result + "]";
+}
@@ -0,0 +1,35 @@
+#include "Lox/LoxString.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::optional<LoxString> LoxString::mapFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return std::nullopt; }
+    struct stat status{};
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return std::nullopt;
+    }
+    // 空文件无法映射，直接返回空字符串
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size == 0) {
+        close(fd);
+        return LoxString();
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后文件描述符就不再需要了
+    close(fd);
+    if (mapping == MAP_FAILED) { return std::nullopt; }
+    // 调用方通常从头到尾扫描一遍，提示内核加大预读
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    LoxString result;
+    result.buffer = make_ref<Buffer>(mapping, size);
+    result.start = static_cast<const char *>(mapping);
+    result.length = size;
+    return result;
+}
+
+void LoxString::unmap(void *mapping, const std::size_t size) { munmap(mapping, size); }
@@ -0,0 +1,205 @@
+#include "Lox/Metrics.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "Utils/SlabAllocator.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 导出的调用最多的顶层函数个数
+static constexpr std::size_t TOP_FUNCTIONS = 10;
+
+MetricsExporter::MetricsExporter(Interpreter &interpreter, MetricsOptions options)
+    : interpreter{interpreter}, options{std::move(options)} {
+    thread = std::thread([this] { run(); });
+}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+    // 最后一份在解释器线程上直接采样
+    publish(collect(Clock::now()));
+    if (socketFd >= 0) { ::close(socketFd); }
+}
+
+/**
+ * @brief 导出线程：每个间隔请求一次采样，等解释器在安全点上交回样本后写出。
+ */
+void MetricsExporter::run() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        if (wakeup.wait_for(lock, options.interval, [this] { return stopping; })) { break; }
+        requestedAt = Clock::now();
+        requested.store(true, std::memory_order_release);
+        wakeup.wait(lock, [this] { return stopping || pending.has_value(); });
+        if (!pending.has_value()) { break; }
+        const Sample current = std::move(pending.value());
+        pending.reset();
+        lock.unlock();
+        publish(current);
+        lock.lock();
+    }
+    requested.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 在解释器线程上采样，并把样本交给导出线程。
+ */
+void MetricsExporter::sample() {
+    std::lock_guard lock(mutex);
+    requested.store(false, std::memory_order_relaxed);
+    pending = collect(requestedAt);
+    wakeup.notify_all();
+}
+
+/**
+ * @brief 读取解释器的计数。
+ *
+ * slab 的计数是线程局部的，因此必须在解释器线程上调用。顶层函数从全局环境中找出，按调用次数排序。
+ *
+ * @param requestTime 导出线程发出请求的时间，用于计算安全点延迟。
+ */
+MetricsExporter::Sample MetricsExporter::collect(const Clock::time_point requestTime) {
+    Sample sample;
+    sample.time = Clock::now();
+    sample.heapBytes = heapInUse();
+    std::tie(sample.allocations, sample.frees) = SlabPool::threadTotals();
+    sample.calls = interpreter.calls;
+    sample.lagSeconds = std::chrono::duration<double>(sample.time - requestTime).count();
+
+    for (const auto &[name, value]: interpreter.globals->variables()) {
+        if (!std::holds_alternative<LoxCallablePtr>(value)) { continue; }
+        const auto *function = dynamic_cast<const LoxFunction *>(std::get<LoxCallablePtr>(value).get());
+        if (function != nullptr && function->calls > 0) { sample.topFunctions.emplace_back(name, function->calls); }
+    }
+    const auto count = std::min(sample.topFunctions.size(), TOP_FUNCTIONS);
+    std::partial_sort(
+        sample.topFunctions.begin(), sample.topFunctions.begin() + static_cast<std::ptrdiff_t>(count),
+        sample.topFunctions.end(), [](const auto &a, const auto &b) { return a.second > b.second; }
+    );
+    sample.topFunctions.resize(count);
+    return sample;
+}
+
+/**
+ * @brief 格式化并写出一份样本，速率按与上一份样本的差值计算。
+ */
+void MetricsExporter::publish(const Sample &current) {
+    write(format(current));
+    previous = current;
+}
+
+/**
+ * @brief 按配置的格式输出一份样本。
+ *
+ * Prometheus 格式中累计值是 counter，速率和大小是 gauge；JSON 格式是一行一个对象。
+ */
+std::string MetricsExporter::format(const Sample &current) const {
+    const double uptime = std::chrono::duration<double>(current.time - start).count();
+    double allocationRate = 0;
+    double callRate = 0;
+    if (previous.has_value()) {
+        if (const double elapsed = std::chrono::duration<double>(current.time - previous->time).count(); elapsed > 0) {
+            allocationRate = static_cast<double>(current.allocations - previous->allocations) / elapsed;
+            callRate = static_cast<double>(current.calls - previous->calls) / elapsed;
+        }
+    }
+
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    if (options.format == MetricsFormat::JSON) {
+        os << "{\"uptime_seconds\":" << llvm::format("%.3f", uptime) << ",\"heap_bytes\":" << current.heapBytes
+           << ",\"allocations_total\":" << current.allocations << ",\"frees_total\":" << current.frees
+           << ",\"live_objects\":" << current.allocations - current.frees
+           << ",\"allocations_per_second\":" << llvm::format("%.1f", allocationRate)
+           << ",\"calls_total\":" << current.calls << ",\"calls_per_second\":" << llvm::format("%.1f", callRate)
+           << ",\"safepoint_lag_seconds\":" << llvm::format("%.6f", current.lagSeconds) << ",\"top_functions\":[";
+        for (std::size_t i = 0; i < current.topFunctions.size(); i++) {
+            // 函数名是标识符，不需要转义
+            os << (i == 0 ? "" : ",") << "{\"name\":\"" << current.topFunctions[i].first
+               << "\",\"calls\":" << current.topFunctions[i].second << "}";
+        }
+        os << "]}\n";
+        return os.str();
+    }
+
+    const auto metric = [&](const char *name, const char *type, const char *help) {
+        os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+    metric("lox_uptime_seconds", "gauge", "Seconds since the script started.");
+    os << "lox_uptime_seconds " << llvm::format("%.3f", uptime) << "\n";
+    metric("lox_heap_bytes", "gauge", "Bytes of heap in use.");
+    os << "lox_heap_bytes " << current.heapBytes << "\n";
+    metric("lox_allocations_total", "counter", "Runtime objects allocated from the slab pools.");
+    os << "lox_allocations_total " << current.allocations << "\n";
+    metric("lox_frees_total", "counter", "Runtime objects returned to the slab pools.");
+    os << "lox_frees_total " << current.frees << "\n";
+    metric("lox_live_objects", "gauge", "Runtime objects currently allocated from the slab pools.");
+    os << "lox_live_objects " << current.allocations - current.frees << "\n";
+    metric("lox_allocations_per_second", "gauge", "Slab allocations per second over the last interval.");
+    os << "lox_allocations_per_second " << llvm::format("%.1f", allocationRate) << "\n";
+    metric("lox_calls_total", "counter", "Function, method and class calls.");
+    os << "lox_calls_total " << current.calls << "\n";
+    metric("lox_calls_per_second", "gauge", "Calls per second over the last interval.");
+    os << "lox_calls_per_second " << llvm::format("%.1f", callRate) << "\n";
+    metric("lox_safepoint_lag_seconds", "gauge", "Delay between a sample request and the next interpreter safepoint.");
+    os << "lox_safepoint_lag_seconds " << llvm::format("%.6f", current.lagSeconds) << "\n";
+    metric("lox_function_calls_total", "counter", "Calls of the most called top-level functions.");
+    for (const auto &[name, count]: current.topFunctions) {
+        os << "lox_function_calls_total{function=\"" << name << "\"} " << count << "\n";
+    }
+    return os.str();
+}
+
+/**
+ * @brief 写出一份格式化后的指标。
+ *
+ * 文件先写到同目录的临时文件再改名；套接字断开或无法连接时丢弃这一份，下次重新连接。
+ */
+void MetricsExporter::write(const std::string &text) {
+    constexpr std::string_view UNIX_PREFIX = "unix:";
+    if (!options.output.starts_with(UNIX_PREFIX)) {
+        const std::string temporary = options.output + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios_base::binary | std::ios_base::trunc);
+            file << text;
+            if (!file) { return; }
+        }
+        std::rename(temporary.c_str(), options.output.c_str());
+        return;
+    }
+
+    if (socketFd < 0) {
+        const auto path = std::string_view(options.output).substr(UNIX_PREFIX.size());
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) { return; }
+        path.copy(address.sun_path, path.size());
+        socketFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (socketFd < 0) { return; }
+        if (::connect(socketFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            ::close(socketFd);
+            socketFd = -1;
+            return;
+        }
+    }
+    for (std::size_t written = 0; written < text.size();) {
+        const ssize_t n = ::send(socketFd, text.data() + written, text.size() - written, MSG_NOSIGNAL);
+        if (n <= 0) {
+            ::close(socketFd);
+            socketFd = -1;
+            return;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+}
@@ -0,0 +1,27 @@
+#include "Lox/NativeCallback.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include <string>
+
+NativeCallback::NativeCallback(Interpreter &interpreter, const std::string_view native, const LoxObject &callee, const int arity)
+    : interpreter{interpreter}, loc{interpreter.currentCallSite()}, callee{callee}, arguments(arity) {
+    const auto *callable = std::get_if<LoxCallablePtr>(&callee);
+    if (callable == nullptr) {
+        interpreter.nativeError(std::string(native) + ": callback must be a function.");
+        return;
+    }
+    if ((*callable)->arity() != arity) {
+        interpreter.nativeError(
+            std::string(native) + ": callback must take " + std::to_string(arity) + " argument" + (arity == 1 ? "" : "s") + "."
+        );
+        return;
+    }
+    // 记忆化的函数仍然走普通调用，以便查询记忆表
+    if (auto *lox = dynamic_cast<LoxFunction *>(callable->get()); lox != nullptr && !lox->declaration->memoize) { function = lox; }
+}
+
+LoxObject NativeCallback::invoke() {
+    if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    return function != nullptr ? interpreter.callFunction(loc, *function, arguments, frame)
+                               : interpreter.call(loc, callee, arguments);
+}
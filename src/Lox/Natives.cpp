@@ -0,0 +1,539 @@
+#include "Lox/Natives.h"
+#include "Lox/Csv.h"
+#include "Lox/Json.h"
+#include "Lox/LoxCallable.h"
+#include "Lox/LoxClass.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "Lox/NativeCallback.h"
+#include "Lox/NativeFunction.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// 原生函数的错误通过 Interpreter::nativeError 记录在调用点上，然后返回 nil；
+// 下面取参数的函数出错时同样先记录错误，再返回空指针或空的 optional，调用方直接返回。
+
+/**
+ * @brief 取出字符串类型的参数，类型不对时报告错误
+ *
+ * @param interpreter 解释器实例
+ * @param native 原生函数名，用于错误信息
+ * @param arguments 参数列表
+ * @param index 参数下标
+ * @return const LoxString* 字符串参数，类型不对时为空
+ */
+static const LoxString *stringArgument(
+    Interpreter &interpreter, const std::string_view native, const std::vector<LoxObject> &arguments, const std::size_t index
+) {
+    if (const auto *string = std::get_if<LoxString>(&arguments[index])) [[likely]] { return string; }
+    interpreter.nativeError(std::string(native) + ": argument " + std::to_string(index + 1) + " must be a string.");
+    return nullptr;
+}
+
+/**
+ * @brief 取出整数类型的参数，类型不对或不是整数时报告错误
+ *
+ * @param interpreter 解释器实例
+ * @param native 原生函数名，用于错误信息
+ * @param arguments 参数列表
+ * @param index 参数下标
+ * @return std::optional<double> 整数参数，类型不对时为空
+ */
+static std::optional<double> integerArgument(
+    Interpreter &interpreter, const std::string_view native, const std::vector<LoxObject> &arguments, const std::size_t index
+) {
+    if (const auto *number = std::get_if<LoxNumber>(&arguments[index]); number != nullptr && std::trunc(*number) == *number)
+        [[likely]] {
+        return *number;
+    }
+    interpreter.nativeError(std::string(native) + ": argument " + std::to_string(index + 1) + " must be an integer.");
+    return std::nullopt;
+}
+
+/**
+ * @brief 取出下标参数，不是整数或不在 [0, size) 之内（包括 ±inf）时报告错误
+ *
+ * @param interpreter 解释器实例
+ * @param native 原生函数名，用于错误信息
+ * @param arguments 参数列表
+ * @param index 参数下标
+ * @param size 下标的上界（不含）
+ * @return std::optional<std::size_t> 下标，出错时为空
+ */
+static std::optional<std::size_t> indexArgument(
+    Interpreter &interpreter, const std::string_view native, const std::vector<LoxObject> &arguments,
+    const std::size_t index, const std::size_t size
+) {
+    const auto value = integerArgument(interpreter, native, arguments, index);
+    if (!value.has_value()) { return std::nullopt; }
+    if (*value < 0 || *value >= static_cast<double>(size)) {
+        interpreter.nativeError(std::string(native) + ": index out of range.");
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(*value);
+}
+
+/**
+ * @brief 在 haystack 中从 from 开始查找 needle
+ *
+ * 单字符模式串使用 memchr，其余使用 memmem；glibc 的两者都有 SIMD 实现，memmem 对长模式串使用 two-way 算法。
+ *
+ * @return std::size_t 匹配的位置，没有找到时为 std::string_view::npos
+ */
+static std::size_t find(const std::string_view haystack, const std::string_view needle, const std::size_t from) {
+    if (from > haystack.size() || needle.size() > haystack.size() - from) { return std::string_view::npos; }
+    if (needle.empty()) { return from; }
+    const void *match = needle.size() == 1
+                            ? std::memchr(haystack.data() + from, needle.front(), haystack.size() - from)
+                            : memmem(haystack.data() + from, haystack.size() - from, needle.data(), needle.size());
+    return match == nullptr ? std::string_view::npos : static_cast<const char *>(match) - haystack.data();
+}
+
+/**
+ * @brief len(value)：字符串的字节数或列表的元素个数
+ */
+static LoxObject len(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    if (const auto *string = std::get_if<LoxString>(&arguments[0])) { return static_cast<LoxNumber>(string->size()); }
+    if (const auto *list = std::get_if<LoxListPtr>(&arguments[0])) {
+        return static_cast<LoxNumber>((*list)->elements.size());
+    }
+    return interpreter.nativeError("len: argument must be a string or a list.");
+}
+
+/**
+ * @brief slice(string, begin, end)：取 [begin, end) 的子串，与原字符串共享缓冲区
+ *
+ * 下标被限制在 [0, len] 之内，end 不大于 begin 时返回空字符串。
+ */
+static LoxObject slice(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *string = stringArgument(interpreter, "slice", arguments, 0);
+    if (string == nullptr) { return nullptr; }
+    const auto first = integerArgument(interpreter, "slice", arguments, 1);
+    if (!first.has_value()) { return nullptr; }
+    const auto last = integerArgument(interpreter, "slice", arguments, 2);
+    if (!last.has_value()) { return nullptr; }
+    const auto size = static_cast<double>(string->size());
+    const auto begin = static_cast<std::size_t>(std::clamp(*first, 0.0, size));
+    const auto end = static_cast<std::size_t>(std::clamp(*last, 0.0, size));
+    return string->slice(begin, end > begin ? end - begin : 0);
+}
+
+/**
+ * @brief indexOf(string, needle)：needle 第一次出现的位置，没有出现时为 -1
+ */
+static LoxObject indexOf(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *string = stringArgument(interpreter, "indexOf", arguments, 0);
+    if (string == nullptr) { return nullptr; }
+    const auto *needle = stringArgument(interpreter, "indexOf", arguments, 1);
+    if (needle == nullptr) { return nullptr; }
+    const auto position = find(*string, *needle, 0);
+    return position == std::string_view::npos ? -1.0 : static_cast<LoxNumber>(position);
+}
+
+/**
+ * @brief split(string, separator)：按分隔符切分为子串列表，每个子串都与原字符串共享缓冲区
+ */
+static LoxObject split(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *source = stringArgument(interpreter, "split", arguments, 0);
+    if (source == nullptr) { return nullptr; }
+    const auto *separatorArgument = stringArgument(interpreter, "split", arguments, 1);
+    if (separatorArgument == nullptr) { return nullptr; }
+    const auto &string = *source;
+    const std::string_view separator = *separatorArgument;
+    if (separator.empty()) { return interpreter.nativeError("split: separator must not be empty."); }
+
+    auto list = make_ref<LoxList>();
+    std::size_t begin = 0;
+    for (std::size_t position; (position = find(string, separator, begin)) != std::string_view::npos;
+         begin = position + separator.size()) {
+        list->elements.emplace_back(string.slice(begin, position - begin));
+    }
+    list->elements.emplace_back(string.slice(begin, string.size() - begin));
+    return list;
+}
+
+/**
+ * @brief startsWith(string, prefix)：字符串是否以 prefix 开头
+ */
+static LoxObject startsWith(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *string = stringArgument(interpreter, "startsWith", arguments, 0);
+    if (string == nullptr) { return nullptr; }
+    const auto *prefix = stringArgument(interpreter, "startsWith", arguments, 1);
+    if (prefix == nullptr) { return nullptr; }
+    return string->view().starts_with(prefix->view());
+}
+
+/**
+ * @brief trim(string)：去掉首尾的空白字符，结果与原字符串共享缓冲区
+ */
+static LoxObject trim(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *argument = stringArgument(interpreter, "trim", arguments, 0);
+    if (argument == nullptr) { return nullptr; }
+    const auto &string = *argument;
+    constexpr std::string_view whitespace = " \t\r\n\f\v";
+    const auto view = string.view();
+    const auto begin = view.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos) { return LoxString(); }
+    const auto end = view.find_last_not_of(whitespace) + 1;
+    return string.slice(begin, end - begin);
+}
+
+/**
+ * @brief at(list, index)：列表中下标为 index 的元素
+ */
+static LoxObject at(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *list = std::get_if<LoxListPtr>(&arguments[0]);
+    if (list == nullptr) { return interpreter.nativeError("at: argument 1 must be a list."); }
+    const auto index = indexArgument(interpreter, "at", arguments, 1, (*list)->elements.size());
+    if (!index.has_value()) { return nullptr; }
+    return (*list)->elements[*index];
+}
+
+void defineStringNatives(Environment &globals) {
+    globals.define("len", make_ref<NativeFunction>(len, 1));
+    globals.define("slice", make_ref<NativeFunction>(slice, 3));
+    globals.define("indexOf", make_ref<NativeFunction>(indexOf, 2));
+    globals.define("split", make_ref<NativeFunction>(split, 2));
+    globals.define("startsWith", make_ref<NativeFunction>(startsWith, 2));
+    globals.define("trim", make_ref<NativeFunction>(trim, 1));
+    globals.define("at", make_ref<NativeFunction>(at, 2));
+}
+
+/**
+ * @brief readFile(path)：以字符串形式读取整个文件
+ */
+static LoxObject readFile(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *argument = stringArgument(interpreter, "readFile", arguments, 0);
+    if (argument == nullptr) { return nullptr; }
+    const std::string path(argument->view());
+    std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
+    if (!file.is_open()) { return interpreter.nativeError("readFile: could not open '" + path + "'."); }
+    // 先取得文件大小，一次分配后整体读入
+    std::string text(static_cast<std::size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(text.data(), static_cast<std::streamsize>(text.size()))) {
+        return interpreter.nativeError("readFile: could not read '" + path + "'.");
+    }
+    return LoxString(std::move(text));
+}
+
+/**
+ * @brief jsonParse(string)：解析 JSON 文本
+ */
+static LoxObject jsonParse(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *text = stringArgument(interpreter, "jsonParse", arguments, 0);
+    if (text == nullptr) { return nullptr; }
+    std::string error;
+    auto value = parseJson(*text, error);
+    if (!value.has_value()) { return interpreter.nativeError(error); }
+    return std::move(*value);
+}
+
+/**
+ * @brief jsonStringify(value)：将值序列化为 JSON 文本
+ */
+static LoxObject jsonStringify(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    std::string error;
+    auto text = stringifyJson(arguments[0], error);
+    if (!text.has_value()) { return interpreter.nativeError(error); }
+    return LoxString(std::move(*text));
+}
+
+/**
+ * @brief jsonLines(string)：逐行读取换行分隔的 JSON（NDJSON）
+ *
+ * 返回一个读取器对象：reader.hasNext() 判断是否还有记录，reader.next() 解析并返回下一条记录，空行被跳过。
+ * null 本身就是合法的记录，因此结束由 hasNext() 判断，而不是用特殊的返回值；没有记录时调用 next() 报告错误。
+ * 记录在调用 next() 时才解析，不会一次性构造出全部记录，字符串仍与输入共享缓冲区。
+ */
+static LoxObject jsonLines(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto *argument = stringArgument(interpreter, "jsonLines", arguments, 0);
+    if (argument == nullptr) { return nullptr; }
+
+    // hasNext 和 next 共享的读取位置
+    struct Cursor {
+        LoxString text;
+        std::size_t offset = 0;
+
+        // 跳过空行，返回是否还有记录
+        bool skipBlankLines() {
+            const auto view = text.view();
+            while (offset < view.size()) {
+                const auto end = std::min(view.find('\n', offset), view.size());
+                if (view.substr(offset, end - offset).find_first_not_of(" \t\r") != std::string_view::npos) { return true; }
+                offset = end + 1;
+            }
+            return false;
+        }
+    };
+    const auto cursor = std::make_shared<Cursor>(Cursor{*argument});
+
+    // 读取器的类没有方法，hasNext 和 next 是保存在字段中的原生函数；引用计数不是原子的，每个线程各用一个
+    static thread_local const LoxClassPtr readerClass =
+        make_ref<LoxClass>("JsonLines", std::nullopt, std::unordered_map<std::string_view, LoxFunctionPtr>{});
+    auto reader = make_ref<LoxInstance>(readerClass);
+    reader->fields.emplace("hasNext", make_ref<NativeFunction>([cursor](Interpreter &, const std::vector<LoxObject> &) -> LoxObject {
+        return cursor->skipBlankLines();
+    }));
+    reader->fields.emplace("next", make_ref<NativeFunction>([cursor](Interpreter &interpreter, const std::vector<LoxObject> &) -> LoxObject {
+        if (!cursor->skipBlankLines()) { return interpreter.nativeError("jsonLines: no more records."); }
+        const auto view = cursor->text.view();
+        const auto end = std::min(view.find('\n', cursor->offset), view.size());
+        const auto line = cursor->text.slice(cursor->offset, end - cursor->offset);
+        cursor->offset = end + 1;
+        std::string error;
+        auto value = parseJson(line, error);
+        if (!value.has_value()) { return interpreter.nativeError(error); }
+        return std::move(*value);
+    }));
+    return reader;
+}
+
+/**
+ * @brief 映射 native 的第 index 个参数指定的文件，失败时报告错误并返回空的 optional
+ */
+static std::optional<LoxString> mapFileArgument(
+    Interpreter &interpreter, const std::string_view native, const std::vector<LoxObject> &arguments, const std::size_t index
+) {
+    const auto *argument = stringArgument(interpreter, native, arguments, index);
+    if (argument == nullptr) { return std::nullopt; }
+    const std::string path(argument->view());
+    auto text = LoxString::mapFile(path);
+    if (!text.has_value()) {
+        interpreter.nativeError(std::string(native) + ": could not open '" + path + "': " + std::strerror(errno) + ".");
+    }
+    return text;
+}
+
+/**
+ * @brief csvReader(path)：逐行读取 CSV 文件
+ *
+ * 文件被映射到内存，返回一个无参的函数，每次调用返回下一行的字段列表，读完时返回 nil。
+ * 字段是映射的子串，不复制字符；只要还有字段存活，映射就不会解除。
+ */
+static LoxObject csvReader(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    auto text = mapFileArgument(interpreter, "csvReader", arguments, 0);
+    if (!text.has_value()) { return nullptr; }
+    return make_ref<NativeFunction>(
+        [cursor = CsvCursor(std::move(*text))](Interpreter &interpreter, const std::vector<LoxObject> &) mutable -> LoxObject {
+            static thread_local std::vector<CsvField> fields;
+            if (!cursor.nextRow(fields)) {
+                if (!cursor.error().empty()) { return interpreter.nativeError(cursor.error()); }
+                return nullptr;
+            }
+            auto row = make_ref<LoxList>();
+            row->elements.reserve(fields.size());
+            for (const auto &field: fields) { row->elements.emplace_back(cursor.toString(field)); }
+            return row;
+        }
+    );
+}
+
+/**
+ * @brief csvColumn(path, column)：把 CSV 文件的一列解析为数字列表
+ *
+ * column 为字符串时按第一行的列名查找，第一行不参与解析；为整数时是从 0 开始的列号，必须小于第一行的字段数，
+ * 所有行都参与解析。
+ * 字段直接用 from_chars 解析为 double，不构造中间的字符串；空字段为 nil，其余不是数字的字段报告错误。
+ */
+static LoxObject csvColumn(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    auto text = mapFileArgument(interpreter, "csvColumn", arguments, 0);
+    if (!text.has_value()) { return nullptr; }
+    CsvCursor cursor(std::move(*text));
+    std::vector<CsvField> fields;
+    std::size_t column;
+    // fields 中是否有一行等待解析
+    bool haveRow;
+    if (const auto *name = std::get_if<LoxString>(&arguments[1])) {
+        if (!cursor.nextRow(fields)) {
+            return interpreter.nativeError(cursor.error().empty() ? "csvColumn: file is empty." : cursor.error());
+        }
+        const auto match = std::ranges::find_if(fields, [name](const CsvField &field) { return field.text == name->view(); });
+        if (match == fields.end()) {
+            return interpreter.nativeError("csvColumn: no column named '" + std::string(name->view()) + "'.");
+        }
+        column = match - fields.begin();
+        haveRow = cursor.nextRow(fields);
+    } else {
+        // 先读出第一行，列号以它的字段数为上界；空文件没有任何列
+        haveRow = cursor.nextRow(fields);
+        if (!haveRow && !cursor.error().empty()) { return interpreter.nativeError(cursor.error()); }
+        const auto index = indexArgument(interpreter, "csvColumn", arguments, 1, fields.size());
+        if (!index.has_value()) { return nullptr; }
+        column = *index;
+    }
+
+    auto list = make_ref<LoxList>();
+    for (; haveRow; haveRow = cursor.nextRow(fields)) {
+        if (column >= fields.size()) {
+            return interpreter.nativeError(
+                "csvColumn: row " + std::to_string(cursor.rowNumber()) + " has no column " + std::to_string(column) + "."
+            );
+        }
+        const auto text = fields[column].text;
+        if (text.empty()) {
+            list->elements.emplace_back(nullptr);
+            continue;
+        }
+        LoxNumber number;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (error != std::errc() || end != text.data() + text.size()) {
+            return interpreter.nativeError(
+                "csvColumn: row " + std::to_string(cursor.rowNumber()) + ": '" + std::string(text) + "' is not a number."
+            );
+        }
+        list->elements.emplace_back(number);
+    }
+    if (!cursor.error().empty()) { return interpreter.nativeError(cursor.error()); }
+    return list;
+}
+
+void defineDataNatives(Environment &globals) {
+    globals.define("readFile", make_ref<NativeFunction>(readFile, 1));
+    globals.define("jsonParse", make_ref<NativeFunction>(jsonParse, 1));
+    globals.define("jsonStringify", make_ref<NativeFunction>(jsonStringify, 1));
+    globals.define("jsonLines", make_ref<NativeFunction>(jsonLines, 1));
+    globals.define("csvReader", make_ref<NativeFunction>(csvReader, 1));
+    globals.define("csvColumn", make_ref<NativeFunction>(csvColumn, 2));
+}
+
+/**
+ * @brief 取出列表类型的参数，类型不对时报告错误并返回空指针
+ */
+static LoxListPtr listArgument(
+    Interpreter &interpreter, const std::string_view native, const std::vector<LoxObject> &arguments, const std::size_t index
+) {
+    if (const auto *list = std::get_if<LoxListPtr>(&arguments[index])) [[likely]] { return *list; }
+    interpreter.nativeError(std::string(native) + ": argument " + std::to_string(index + 1) + " must be a list.");
+    return nullptr;
+}
+
+/**
+ * @brief map(list, fn)：对每个元素调用 fn，返回结果组成的新列表
+ *
+ * 回调可能修改原列表，因此每次都重新检查长度，并在调用前复制出当前元素。
+ */
+static LoxObject map(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto list = listArgument(interpreter, "map", arguments, 0);
+    if (list == nullptr) { return nullptr; }
+    NativeCallback fn(interpreter, "map", arguments[1], 1);
+    auto result = make_ref<LoxList>();
+    result->elements.reserve(list->elements.size());
+    for (std::size_t i = 0; i < list->elements.size(); i++) {
+        LoxObject element = list->elements[i];
+        result->elements.push_back(fn(std::move(element)));
+        if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    }
+    if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    return result;
+}
+
+/**
+ * @brief filter(list, fn)：返回 fn 结果为真的元素组成的新列表
+ */
+static LoxObject filter(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto list = listArgument(interpreter, "filter", arguments, 0);
+    if (list == nullptr) { return nullptr; }
+    NativeCallback fn(interpreter, "filter", arguments[1], 1);
+    auto result = make_ref<LoxList>();
+    for (std::size_t i = 0; i < list->elements.size(); i++) {
+        LoxObject element = list->elements[i];
+        const bool keep = isTruthy(fn(element));
+        if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+        if (keep) { result->elements.push_back(std::move(element)); }
+    }
+    if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    return result;
+}
+
+/**
+ * @brief reduce(list, fn, initial)：从 initial 开始依次计算 fn(累积值, 元素)
+ */
+static LoxObject reduce(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto list = listArgument(interpreter, "reduce", arguments, 0);
+    if (list == nullptr) { return nullptr; }
+    NativeCallback fn(interpreter, "reduce", arguments[1], 2);
+    LoxObject accumulator = arguments[2];
+    for (std::size_t i = 0; i < list->elements.size(); i++) {
+        LoxObject element = list->elements[i];
+        accumulator = fn(std::move(accumulator), std::move(element));
+        if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    }
+    if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    return accumulator;
+}
+
+/**
+ * @brief 自底向上的稳定归并排序
+ *
+ * 比较函数来自用户代码，不一定满足严格弱序；std::sort 的插入排序阶段依赖严格弱序省略边界检查，
+ * 比较结果不一致时会越界。归并排序无论比较结果如何都只访问区间之内的元素。
+ *
+ * @param elements 要排序的元素
+ * @param less less(a, b) 为真表示 a 应排在 b 之前
+ */
+template<typename Less>
+static void mergeSort(std::vector<LoxObject> &elements, Less &&less) {
+    const std::size_t size = elements.size();
+    std::vector<LoxObject> buffer(size);
+    for (std::size_t width = 1; width < size; width *= 2) {
+        for (std::size_t left = 0; left < size; left += 2 * width) {
+            const std::size_t middle = std::min(left + width, size);
+            const std::size_t right = std::min(left + 2 * width, size);
+            std::size_t i = left, j = middle, k = left;
+            // 右半边的元素严格小于左半边时才先取右边，保证稳定
+            while (i < middle && j < right) { buffer[k++] = std::move(less(elements[j], elements[i]) ? elements[j++] : elements[i++]); }
+            while (i < middle) { buffer[k++] = std::move(elements[i++]); }
+            while (j < right) { buffer[k++] = std::move(elements[j++]); }
+        }
+        elements.swap(buffer);
+    }
+}
+
+/**
+ * @brief sort(list, less)：按 less(a, b) 稳定地原地排序并返回列表
+ *
+ * less 为 nil 时按数字或字符串的自然顺序排序。排序在副本上进行，完成后才写回，
+ * 回调出错或在排序过程中修改列表都不会让列表处于中间状态。出错之后剩下的比较都直接返回 false，
+ * 不再调用回调，归并排序照常结束后丢弃副本。
+ */
+static LoxObject sort(Interpreter &interpreter, const std::vector<LoxObject> &arguments) {
+    const auto list = listArgument(interpreter, "sort", arguments, 0);
+    if (list == nullptr) { return nullptr; }
+    auto elements = list->elements;
+    if (std::holds_alternative<LoxNil>(arguments[1])) {
+        mergeSort(elements, [&interpreter](const LoxObject &left, const LoxObject &right) {
+            if (const auto *a = std::get_if<LoxNumber>(&left), *b = std::get_if<LoxNumber>(&right); a != nullptr && b != nullptr) {
+                return *a < *b;
+            }
+            if (const auto *a = std::get_if<LoxString>(&left), *b = std::get_if<LoxString>(&right); a != nullptr && b != nullptr) {
+                return a->view() < b->view();
+            }
+            if (!interpreter.unwinding()) {
+                interpreter.nativeError("sort: without a comparator, elements must be all numbers or all strings.");
+            }
+            return false;
+        });
+    } else {
+        NativeCallback less(interpreter, "sort", arguments[1], 2);
+        mergeSort(elements, [&less](const LoxObject &left, const LoxObject &right) { return isTruthy(less(left, right)); });
+    }
+    if (interpreter.unwinding()) [[unlikely]] { return nullptr; }
+    list->elements = std::move(elements);
+    return list;
+}
+
+void defineListNatives(Environment &globals) {
+    globals.define("map", make_ref<NativeFunction>(map, 2));
+    globals.define("filter", make_ref<NativeFunction>(filter, 2));
+    globals.define("reduce", make_ref<NativeFunction>(reduce, 3));
+    globals.define("sort", make_ref<NativeFunction>(sort, 2));
+}
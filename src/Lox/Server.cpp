@@ -0,0 +1,424 @@
+#include "Lox/Server.h"
+#include "Lox/Json.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "Lox/ServerProtocol.h"
+#include "frontend/ModuleLoader.h"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <poll.h>
+#include <sstream>
+#include <string_view>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unordered_map>
+
+// 信号处理函数通过自管道唤醒主线程的 poll
+static int wakeWriteFd = -1;
+static std::atomic<bool> stopRequested = false;
+
+static void requestStop(int) {
+    stopRequested = true;
+    const char byte = 0;
+    [[maybe_unused]] const auto ignored = ::write(wakeWriteFd, &byte, 1);
+}
+
+namespace {
+
+/**
+ * @brief 一个请求
+ */
+struct Request {
+    enum class Kind { RUN, CALL } kind = Kind::RUN;
+    // CALL 的函数名
+    std::string function;
+    // RUN 的脚本源码或 CALL 的 JSON 参数数组
+    std::string body;
+};
+
+/**
+ * @brief 一个响应
+ */
+struct Response {
+    int status = 0;
+    std::string output;
+    std::string errors;
+    std::string result;
+};
+
+/**
+ * @brief 连接上一个收齐的请求，或者一个格式错误的请求
+ */
+struct Job {
+    int fd = -1;
+    Request request;
+    // 格式错误的原因，非空时只回复错误并关闭连接
+    std::string malformed;
+};
+
+/**
+ * @brief 从连接已收到的字节中取出一个请求
+ *
+ * @param buffer 已收到但尚未处理的字节
+ * @param request 取出的请求
+ * @param malformed 格式错误时写入原因
+ * @return std::size_t 请求占用的字节数；请求还不完整或格式错误时为 0，格式错误时 malformed 非空
+ */
+std::size_t parseRequest(const std::string_view buffer, Request &request, std::string &malformed) {
+    const auto newline = buffer.find('\n');
+    if (newline == std::string_view::npos || newline >= MAX_HEADER_BYTES) {
+        if (std::min(newline, buffer.size()) >= MAX_HEADER_BYTES) {
+            malformed = "Request header exceeds " + std::to_string(MAX_HEADER_BYTES) + " bytes.";
+        }
+        return 0;
+    }
+    const std::string header(buffer.substr(0, newline));
+    std::istringstream fields(header);
+    std::string command;
+    std::size_t length = 0;
+    fields >> command;
+    if (command == "RUN") {
+        request.kind = Request::Kind::RUN;
+    } else if (command == "CALL") {
+        request.kind = Request::Kind::CALL;
+        fields >> request.function;
+    } else {
+        malformed = "Unknown request '" + command + "'.";
+        return 0;
+    }
+    if (!(fields >> length) || (request.kind == Request::Kind::CALL && request.function.empty())) {
+        malformed = "Malformed request header '" + header + "'.";
+        return 0;
+    }
+    if (length > MAX_BODY_BYTES) {
+        malformed = "Request body of " + std::to_string(length) + " bytes exceeds the limit of " +
+                    std::to_string(MAX_BODY_BYTES) + " bytes.";
+        return 0;
+    }
+    if (buffer.size() - newline - 1 < length) { return 0; }
+    request.body = buffer.substr(newline + 1, length);
+    return newline + 1 + length;
+}
+
+bool writeResponse(const int fd, const Response &response) {
+    const std::string header = std::to_string(response.status) + " " + std::to_string(response.output.size()) + " " +
+                               std::to_string(response.errors.size()) + " " + std::to_string(response.result.size()) +
+                               "\n";
+    return writeAll(fd, header.data(), header.size()) &&
+           writeAll(fd, response.output.data(), response.output.size()) &&
+           writeAll(fd, response.errors.data(), response.errors.size()) &&
+           writeAll(fd, response.result.data(), response.result.size());
+}
+
+class Server {
+public:
+    explicit Server(const ServerOptions &options) : options{options} {}
+
+    int run();
+
+private:
+    const ServerOptions &options;
+    // 预加载模块的导入语句，所有隔离区共享同一份加载结果
+    Program preloads;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    // 已经收齐、等待隔离区处理的请求
+    std::deque<Job> pending;
+    // 隔离区处理完一个请求后交还的连接
+    std::vector<int> returned;
+    bool stopping = false;
+    int wakeReadFd = -1;
+    // 各连接已收到但还没有交给隔离区的字节，只由主线程访问
+    std::unordered_map<int, std::string> received;
+
+    // 准备一个导入了预加载模块的解释器
+    std::unique_ptr<Interpreter> prepare() const;
+    // 隔离区线程的主循环
+    void isolate();
+    // 执行一个请求；script 保存 RUN 请求的 AST，必须比执行它的解释器活得更久
+    Response handle(Interpreter &interpreter, const Request &request, std::shared_ptr<const Module> &script);
+    // 等待一个收齐的请求，服务停止时返回空
+    std::optional<Job> take();
+    // 把连接交还主线程
+    void giveBack(int fd);
+    // 在主线程上读走连接中已经到达的字节，返回连接是否仍然打开
+    bool receive(int fd);
+    // 连接上已经收齐一个请求（或发现格式错误）时把它交给隔离区，返回是否交出
+    bool dispatch(int fd);
+};
+
+std::unique_ptr<Interpreter> Server::prepare() const {
+    auto interpreter = std::make_unique<Interpreter>(ExecutionLimits{}, options.engine);
+    // 收到 SIGINT 或 SIGTERM 时中断正在执行的请求，没有设置预算的死循环也不会阻止服务停止
+    interpreter->setInterrupt(&stopRequested);
+    try {
+        interpreter->execute(preloads);
+    } catch (const runtime_error &error) { runtimeError(error); }
+    return interpreter;
+}
+
+Response Server::handle(Interpreter &interpreter, const Request &request, std::shared_ptr<const Module> &script) {
+    Response response;
+    llvm::raw_string_ostream output(response.output);
+    llvm::raw_string_ostream errors(response.errors);
+    interpreter.setOutput(output);
+    diagnostics = &errors;
+    hadError = false;
+    hadRuntimeError = false;
+
+    if (request.kind == Request::Kind::RUN) {
+        script = ModuleLoader::instance().compile(request.body, "<request>", std::filesystem::current_path());
+        if (!script->error.empty()) {
+            errors << script->error << "\n";
+            response.status = 65;
+        } else {
+            interpreter.setLimits(options.limits);
+            interpreter.evaluate(script->statements);
+            response.status = hadRuntimeError ? 70 : 0;
+        }
+    } else {
+        const Identifier name(Token(IDENTIFIER, request.function, nullptr, 0));
+        std::string error;
+        const auto arguments = parseJson(LoxString(request.body), error);
+        const auto *list = arguments.has_value() ? std::get_if<LoxListPtr>(&*arguments) : nullptr;
+        if (list == nullptr) {
+            errors << (error.empty() ? "CALL arguments must be a JSON array." : error) << "\n";
+            response.status = 70;
+        } else {
+            try {
+                interpreter.setLimits(options.limits);
+                if (auto result = stringifyJson(interpreter.callGlobal(name, (*list)->elements), error)) {
+                    response.result = std::move(*result);
+                } else {
+                    errors << error << "\n";
+                    response.status = 70;
+                }
+            } catch (const runtime_error &runtime) {
+                runtimeError(runtime);
+                response.status = 70;
+            }
+        }
+    }
+
+    output.flush();
+    errors.flush();
+    diagnostics = nullptr;
+    interpreter.setOutput(llvm::outs());
+    return response;
+}
+
+std::optional<Job> Server::take() {
+    std::unique_lock lock(mutex);
+    available.wait(lock, [this] { return stopping || !pending.empty(); });
+    if (stopping) { return std::nullopt; }
+    Job job = std::move(pending.front());
+    pending.pop_front();
+    return job;
+}
+
+void Server::giveBack(const int fd) {
+    {
+        std::lock_guard lock(mutex);
+        returned.push_back(fd);
+    }
+    const char byte = 1;
+    [[maybe_unused]] const auto ignored = ::write(wakeWriteFd, &byte, 1);
+}
+
+bool Server::receive(const int fd) {
+    auto &buffer = received[fd];
+    // 缓冲最多一个最大的请求，其余的留在内核中，交出请求后再读
+    char chunk[65536];
+    while (buffer.size() <= MAX_HEADER_BYTES + MAX_BODY_BYTES) {
+        const ssize_t count = ::read(fd, chunk, sizeof(chunk));
+        if (count > 0) {
+            buffer.append(chunk, static_cast<std::size_t>(count));
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    return true;
+}
+
+bool Server::dispatch(const int fd) {
+    auto &buffer = received[fd];
+    Job job{fd, {}, {}};
+    const std::size_t consumed = parseRequest(buffer, job.request, job.malformed);
+    if (consumed == 0 && job.malformed.empty()) { return false; }
+    // 格式错误之后无法再找到下一个请求的边界，隔离区回复错误后关闭连接
+    if (job.malformed.empty()) {
+        buffer.erase(0, consumed);
+    } else {
+        buffer.clear();
+    }
+    {
+        std::lock_guard lock(mutex);
+        pending.push_back(std::move(job));
+    }
+    available.notify_one();
+    return true;
+}
+
+void Server::isolate() {
+    auto interpreter = prepare();
+    for (std::optional<Job> job; (job = take());) {
+        const int fd = job->fd;
+        if (!job->malformed.empty()) {
+            writeResponse(fd, {64, "", job->malformed + "\n", ""});
+            // 由主线程在读到连接关闭时关闭描述符，避免它被重新分配时主线程还留着旧连接的缓冲
+            ::shutdown(fd, SHUT_RDWR);
+            giveBack(fd);
+            continue;
+        }
+
+        {
+            // 请求登记的源码位置和驻留的字符串在请求结束时释放
+            const SourceMap::Segment segment;
+            std::shared_ptr<const Module> script;
+            Response response;
+            try {
+                response = handle(*interpreter, job->request, script);
+            } catch (const std::exception &exception) {
+                diagnostics = nullptr;
+                response = {70, "", std::string("Internal error: ") + exception.what() + "\n", ""};
+            }
+            if (!writeResponse(fd, response)) { ::shutdown(fd, SHUT_RDWR); }
+            giveBack(fd);
+            // 回复之后再丢弃用过的解释器，先销毁解释器再销毁它执行的 AST，二者都不能比段活得更久
+            interpreter.reset();
+            script.reset();
+        }
+        // 服务正在停止，不再准备新的解释器
+        if (stopRequested) { break; }
+        // 新的解释器在段外准备，预加载模块执行时创建的对象不引用请求的段
+        interpreter = prepare();
+    }
+}
+
+int Server::run() {
+    // 预加载模块在启动时加载并试运行一次，出错时直接退出
+    auto &loader = ModuleLoader::instance();
+    std::vector<ImportStmtPtr> imports;
+    for (const auto &path: options.preloads) {
+        const Token token(IMPORT, "import", nullptr, 0);
+        auto stmt = std::make_shared<ImportStmt>(SourceMap::instance().add(token), SourceMap::instance().intern(path));
+        imports.push_back(stmt);
+        preloads.emplace_back(std::move(stmt));
+    }
+    loader.loadImports(imports, std::filesystem::current_path());
+    if (!loader.waitFor(imports)) { return 65; }
+    hadRuntimeError = false;
+    prepare();
+    if (hadRuntimeError) { return 70; }
+
+    const int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listenFd < 0 || options.socketPath.size() >= sizeof(address.sun_path)) {
+        llvm::errs() << "Cannot create socket '" << options.socketPath << "'.\n";
+        return 71;
+    }
+    std::memcpy(address.sun_path, options.socketPath.c_str(), options.socketPath.size() + 1);
+    // 上一次运行留下的套接字文件
+    if (struct stat status{}; ::stat(address.sun_path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+        ::unlink(address.sun_path);
+    }
+    if (::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listenFd, 128) != 0) {
+        llvm::errs() << "Cannot listen on '" << options.socketPath << "': " << std::strerror(errno) << "\n";
+        ::close(listenFd);
+        return 71;
+    }
+
+    int wake[2];
+    if (::pipe2(wake, O_CLOEXEC | O_NONBLOCK) != 0) { return 71; }
+    wakeReadFd = wake[0];
+    wakeWriteFd = wake[1];
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < std::max(options.isolates, 1U); i++) { threads.emplace_back([this] { isolate(); }); }
+    llvm::errs() << "lox: serving on " << options.socketPath << " with " << threads.size() << " isolates\n";
+
+    // 前两项是监听套接字和自管道，其余是空闲连接
+    std::vector<pollfd> watched{{listenFd, POLLIN, 0}, {wakeReadFd, POLLIN, 0}};
+    const auto disconnect = [this](const int fd) {
+        received.erase(fd);
+        ::close(fd);
+    };
+    while (!stopRequested) {
+        if (::poll(watched.data(), watched.size(), -1) < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        // 交还的连接上可能已经收齐了下一个请求，不必等待新的数据
+        std::vector<int> back;
+        if (watched[1].revents != 0) {
+            char buffer[64];
+            while (::read(wakeReadFd, buffer, sizeof(buffer)) > 0) {}
+            std::lock_guard lock(mutex);
+            back.swap(returned);
+        }
+        std::size_t kept = 2;
+        for (std::size_t i = 2; i < watched.size(); i++) {
+            const int fd = watched[i].fd;
+            if (watched[i].revents == 0) {
+                watched[kept++] = watched[i];
+                continue;
+            }
+            const bool open = receive(fd);
+            if (dispatch(fd)) { continue; }
+            if (open) {
+                watched[kept++] = watched[i];
+            } else {
+                disconnect(fd);
+            }
+        }
+        watched.resize(kept);
+        for (const int fd: back) {
+            if (!dispatch(fd)) { watched.push_back({fd, POLLIN, 0}); }
+        }
+        if (watched[0].revents != 0) {
+            if (const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK); fd >= 0) {
+                watched.push_back({fd, POLLIN, 0});
+            }
+        }
+        for (auto &entry: watched) { entry.revents = 0; }
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto &thread: threads) { thread.join(); }
+    for (std::size_t i = 2; i < watched.size(); i++) { ::close(watched[i].fd); }
+    for (const auto &job: pending) { ::close(job.fd); }
+    for (const int fd: returned) { ::close(fd); }
+    ::close(listenFd);
+    ::unlink(options.socketPath.c_str());
+    llvm::errs() << "lox: server stopped\n";
+    return 0;
+}
+
+}// namespace
+
+int serve(const ServerOptions &options) {
+    // 多个隔离区会同时执行同一个模块，函数声明必须在加载线程上预先编译
+    ModuleLoader::instance().precompile = options.engine == ExecutionEngine::CLOSURE;
+    Server server(options);
+    return server.run();
+}
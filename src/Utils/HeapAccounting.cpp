@@ -0,0 +1,65 @@
+#include "Utils/HeapAccounting.h"
+#include <cstddef>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// 当前线程的净分配字节数；只是一个整数，不需要动态初始化，线程退出时也不会析构
+static thread_local std::int64_t threadBytes = 0;
+
+std::int64_t threadHeapBytes() { return threadBytes; }
+
+void countThreadHeap(const std::int64_t bytes) {
+    if (threadHeapAccounting) { threadBytes += bytes; }
+}
+
+/**
+ * @brief 分配内存，失败时按标准的要求反复调用 new_handler，没有 new_handler 时抛出 bad_alloc
+ *
+ * @param size 字节数
+ * @param alignment 对齐要求，不超过 malloc 的对齐时直接用 malloc
+ * @return void* 分配到的内存
+ */
+static void *allocate(std::size_t size, const std::size_t alignment) {
+    if (size == 0) { size = 1; }
+    while (true) {
+        void *pointer = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            pointer = std::malloc(size);
+        } else if (::posix_memalign(&pointer, alignment, size) != 0) {
+            pointer = nullptr;
+        }
+        if (pointer != nullptr) [[likely]] {
+            if (threadHeapAccounting) { threadBytes += static_cast<std::int64_t>(malloc_usable_size(pointer)); }
+            return pointer;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) { throw std::bad_alloc(); }
+        handler();
+    }
+}
+
+static void release(void *pointer) noexcept {
+    if (pointer == nullptr) { return; }
+    if (threadHeapAccounting) { threadBytes -= static_cast<std::int64_t>(malloc_usable_size(pointer)); }
+    std::free(pointer);
+}
+
+// 标准库的 nothrow 版本都转发到下面这些函数
+void *operator new(const std::size_t size) { return allocate(size, 0); }
+void *operator new[](const std::size_t size) { return allocate(size, 0); }
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { release(pointer); }
@@ -0,0 +1,198 @@
+#include "Utils/PerfCounters.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// 每个事件的名字和 perf_event_attr 中的类型、配置
+struct EventSpec {
+    const char *name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr std::uint64_t cacheConfig(const std::uint64_t cache, const std::uint64_t op, const std::uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+constexpr std::array<EventSpec, PERF_EVENT_COUNT> EVENTS{{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"L1d-misses", PERF_TYPE_HW_CACHE,
+     cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"LLC-misses", PERF_TYPE_HW_CACHE,
+     cacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+}};
+
+constexpr std::array<const char *, PERF_PHASE_COUNT> PHASES{"scan", "parse", "resolve", "execute"};
+
+int openEvent(const EventSpec &event, const int groupFd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    // 只统计用户态：perf_event_paranoid 为 2 时普通用户也可以打开
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // 同时读出启用和实际计数的时间，用来发现并校正多路复用
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // 组长创建时处于停止状态，整组打开后一起启动
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+
+}// namespace
+
+/**
+ * @brief 打开计数器。
+ *
+ * 第一个能打开的事件作为组长，其余事件加入它的组；打不开的事件单独跳过，不影响其他事件。
+ */
+PerfProfile::PerfProfile(const bool perFunction) : functions{perFunction} {
+    fds.fill(-1);
+    int firstError = 0;
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i] = openEvent(EVENTS[i], groupFd);
+        if (fds[i] < 0) {
+            if (firstError == 0) { firstError = errno; }
+            continue;
+        }
+        if (groupFd < 0) { groupFd = fds[i]; }
+        slots[i] = opened++;
+    }
+    if (groupFd < 0) {
+        llvm::errs() << "lox: cannot open hardware performance counters: " << std::strerror(firstError) << "\n";
+        return;
+    }
+    ::ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfProfile::~PerfProfile() {
+    for (const int fd: fds) {
+        if (fd >= 0) { ::close(fd); }
+    }
+}
+
+/**
+ * @brief 读出所有计数器的当前值。
+ *
+ * 组读数依次是事件个数、启用时间、计数时间，后面跟着每个事件的值，顺序与加入组的顺序相同。
+ * 这里返回原始值，放大在输出时按每一段的时间差进行。
+ */
+PerfCounts PerfProfile::read() const {
+    PerfCounts counts;
+    if (groupFd < 0) { return counts; }
+    std::array<std::uint64_t, PERF_EVENT_COUNT + 3> buffer{};
+    if (::read(groupFd, buffer.data(), sizeof(buffer)) <= 0) { return counts; }
+    counts.enabled = buffer[1];
+    counts.running = buffer[2];
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] >= 0) { counts.values[i] = buffer[3 + slots[i]]; }
+    }
+    return counts;
+}
+
+/**
+ * @brief 进入一个顶层函数，上一段计数记到调用方。
+ */
+void PerfProfile::enterFunction(const void *key, const std::string_view name) {
+    const auto now = read();
+    if (!stack.empty()) { stack.back()->counts += now - last; }
+    auto &function = functionCounts[key];
+    if (function.name.empty()) { function.name = name; }
+    function.calls++;
+    stack.push_back(&function);
+    last = now;
+}
+
+/**
+ * @brief 离开最近进入的顶层函数，上一段计数记到它上面。
+ */
+void PerfProfile::leaveFunction() {
+    if (stack.empty()) { return; }
+    const auto now = read();
+    stack.back()->counts += now - last;
+    stack.pop_back();
+    last = now;
+}
+
+/**
+ * @brief 输出各阶段和各函数的计数。
+ *
+ * 每行依次是各事件的计数和每周期执行的指令数，函数按指令数从多到少排列。
+ * 被多路复用的行按 enabled / running 放大并在行尾标 "*"；running 为 0 的行没有任何有效计数，显示为 "(not counted)"。
+ */
+void PerfProfile::print(llvm::raw_ostream &os) const {
+    os << "=== lox perf counters (user space) ===\n";
+    if (groupFd < 0) {
+        os << "(unavailable)\n";
+        return;
+    }
+    // llvm::format 只接受指针，不接受字符数组
+    const char *ipc = "IPC";
+    const char *missing = "-";
+    const auto header = [&](const char *title) {
+        os << llvm::format("%-24s", title);
+        for (const auto &event: EVENTS) { os << llvm::format(" %15s", event.name); }
+        os << llvm::format(" %7s\n", ipc);
+    };
+    const auto row = [&](const std::string &name, const PerfCounts &raw) {
+        os << llvm::format("%-24s", name.c_str());
+        if (raw.running == 0 && raw.enabled > 0) {
+            os << " (not counted)\n";
+            return;
+        }
+        const bool multiplexed = raw.running < raw.enabled;
+        PerfCounts counts = raw;
+        if (multiplexed) {
+            const double scale = static_cast<double>(raw.enabled) / static_cast<double>(raw.running);
+            for (auto &value: counts.values) {
+                value = static_cast<std::uint64_t>(static_cast<double>(value) * scale);
+            }
+        }
+        for (std::size_t i = 0; i < PERF_EVENT_COUNT; i++) {
+            if (fds[i] >= 0) {
+                os << llvm::format(" %15llu", static_cast<unsigned long long>(counts.values[i]));
+            } else {
+                os << llvm::format(" %15s", missing);
+            }
+        }
+        const auto instructions = counts[PerfEvent::INSTRUCTIONS];
+        if (fds[0] >= 0 && fds[1] >= 0 && counts[PerfEvent::CYCLES] > 0) {
+            os << llvm::format(" %7.3f", static_cast<double>(instructions) / static_cast<double>(counts[PerfEvent::CYCLES]));
+        } else {
+            os << llvm::format(" %7s", missing);
+        }
+        os << (multiplexed ? " *\n" : "\n");
+    };
+
+    header("phase");
+    PerfCounts total;
+    for (std::size_t i = 0; i < PERF_PHASE_COUNT; i++) {
+        row(PHASES[i], phases[i]);
+        total += phases[i];
+    }
+    row("total", total);
+    if (total.running < total.enabled) {
+        os << "* counters were multiplexed; values are scaled estimates\n";
+    }
+
+    if (!functions) { return; }
+    std::vector<const FunctionCounts *> sorted;
+    sorted.reserve(functionCounts.size());
+    for (const auto &[key, function]: functionCounts) { sorted.push_back(&function); }
+    std::sort(sorted.begin(), sorted.end(), [](const FunctionCounts *a, const FunctionCounts *b) {
+        return a->counts[PerfEvent::INSTRUCTIONS] > b->counts[PerfEvent::INSTRUCTIONS];
+    });
+    header("function (self, calls)");
+    for (const auto *function: sorted) { row(function->name + " (" + std::to_string(function->calls) + ")", function->counts); }
+}
@@ -0,0 +1,128 @@
+#include "Utils/SlabAllocator.h"
+#include "Utils/HeapAccounting.h"
+#include <algorithm>
+#include <iterator>
+#include <llvm/Support/raw_ostream.h>
+#include <sys/mman.h>
+
+// 当前线程中已创建的池组成的链表，用于输出统计信息
+static thread_local SlabPool *threadPools = nullptr;
+
+SlabPool::SlabPool(const std::size_t sizeClass) : sizeClass{sizeClass}, next{threadPools} { threadPools = this; }
+
+SlabPool::~SlabPool() {
+    // 从当前线程的池列表中摘除
+    for (SlabPool **link = &threadPools; *link != nullptr; link = &(*link)->next) {
+        if (*link == this) {
+            *link = next;
+            break;
+        }
+    }
+
+    // 仍有对象在使用这些 slab（例如进程退出时尚未析构的对象），或者块被其他线程释放后挂在那个线程的空闲链表上，
+    // 保留内存。只比较分配和释放次数不够：本线程可能恰好释放了同样多个其他线程的块
+    if (allocations != frees || !allBlocksHome()) { return; }
+    for (const auto &[slab, bytes]: slabs) {
+        if (bytes == SLAB_HUGE_PAGE_BYTES) {
+            munmap(slab, bytes);
+            mappedBytes -= bytes;
+            countThreadHeap(-static_cast<std::int64_t>(bytes));
+        } else {
+            ::operator delete(slab, std::align_val_t{SLAB_PAGE_BYTES});
+        }
+    }
+}
+
+/**
+ * @brief 空闲链表为空时申请一个新的 slab，切分后挂到空闲链表上
+ *
+ * 启用大页时用 mmap 映射 2 MiB 并通过 madvise 请求透明大页，映射失败时退回普通页。
+ *
+ * @return void* 新 slab 中的第一个块
+ */
+void *SlabPool::refill() {
+    void *slab = nullptr;
+    std::size_t bytes = SLAB_PAGE_BYTES;
+    if (useHugePages) {
+        slab = mmap(nullptr, SLAB_HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (slab != MAP_FAILED) {
+            madvise(slab, SLAB_HUGE_PAGE_BYTES, MADV_HUGEPAGE);
+            bytes = SLAB_HUGE_PAGE_BYTES;
+            mappedBytes += bytes;
+            countThreadHeap(static_cast<std::int64_t>(bytes));
+        } else {
+            slab = nullptr;
+        }
+    }
+    if (slab == nullptr) { slab = ::operator new(SLAB_PAGE_BYTES, std::align_val_t{SLAB_PAGE_BYTES}); }
+    slabs.emplace_back(slab, bytes);
+
+    // 第一个块直接返回，其余的块按地址顺序挂到空闲链表上
+    auto *base = static_cast<char *>(slab);
+    const std::size_t count = bytes / sizeClass;
+    for (std::size_t i = count - 1; i >= 1; i--) {
+        auto *block = reinterpret_cast<FreeBlock *>(base + i * sizeClass);
+        block->next = freeList;
+        freeList = block;
+    }
+    return base;
+}
+
+/**
+ * @brief 本池切出的块是否都在本池的空闲链表上
+ *
+ * 数出空闲链表中落在本池 slab 内的块，与切出的块数比较；空闲链表中其他池的块不计入。
+ * 其他池的块所在的 slab 不会被归还（它们的池会发现这个块不在自己的空闲链表上），遍历时可以安全地读取。
+ */
+bool SlabPool::allBlocksHome() const {
+    // 按起始地址排序的 slab 地址范围
+    std::vector<std::pair<std::uintptr_t, std::size_t>> ranges;
+    ranges.reserve(slabs.size());
+    std::size_t carved = 0;
+    for (const auto &[slab, bytes]: slabs) {
+        ranges.emplace_back(reinterpret_cast<std::uintptr_t>(slab), bytes);
+        carved += bytes / sizeClass;
+    }
+    std::sort(ranges.begin(), ranges.end());
+    std::size_t home = 0;
+    for (const FreeBlock *block = freeList; block != nullptr; block = block->next) {
+        const auto address = reinterpret_cast<std::uintptr_t>(block);
+        // 起始地址不大于 address 的最后一个 slab 可能包含它
+        const auto after = std::upper_bound(
+            ranges.begin(), ranges.end(), address, [](const std::uintptr_t value, const auto &range) { return value < range.first; }
+        );
+        if (after != ranges.begin() && address < std::prev(after)->first + std::prev(after)->second) { home++; }
+    }
+    return home == carved;
+}
+
+/**
+ * @brief 输出当前线程所有池的统计信息，用于 --stats
+ *
+ * @param os 输出流
+ */
+void SlabPool::printStats(llvm::raw_ostream &os) {
+    if (threadPools == nullptr) {
+        os << "slab pools: (none)\n";
+        return;
+    }
+    for (const SlabPool *pool = threadPools; pool != nullptr; pool = pool->next) {
+        std::size_t reserved = 0;
+        for (const auto &[slab, bytes]: pool->slabs) { reserved += bytes; }
+        os << "slab " << pool->sizeClass << "B: allocs " << pool->allocations << ", frees " << pool->frees
+           << ", live " << pool->allocations - pool->frees << ", slabs " << pool->slabs.size() << " ("
+           << reserved / 1024 << " KiB)\n";
+    }
+}
+
+/**
+ * @brief 当前线程所有池累计的分配和释放次数。
+ */
+std::pair<std::uint64_t, std::uint64_t> SlabPool::threadTotals() {
+    std::pair<std::uint64_t, std::uint64_t> totals{0, 0};
+    for (const SlabPool *pool = threadPools; pool != nullptr; pool = pool->next) {
+        totals.first += pool->allocations;
+        totals.second += pool->frees;
+    }
+    return totals;
+}
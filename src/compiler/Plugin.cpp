@@ -0,0 +1,38 @@
+#include "compiler/CompilerPlugin.h"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <string>
+#include <type_traits>
+
+// 代码生成插件的入口。src/compiler 下的文件只编译进 liblox-compiler.so，
+// 以后的 JIT 和 AOT 编译在这里通过函数表提供给解释器。
+
+namespace {
+
+const char *targetTriple() {
+    static const std::string triple = llvm::sys::getDefaultTargetTriple();
+    return triple.c_str();
+}
+
+const char *hostCPU() {
+    static const std::string cpu = llvm::sys::getHostCPUName().str();
+    return cpu.c_str();
+}
+
+}// namespace
+
+extern "C" __attribute__((visibility("default"))) const CompilerPlugin *loxCompilerPlugin() {
+    static const CompilerPlugin plugin = [] {
+        // 目标初始化只在插件第一次被使用时执行
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        return CompilerPlugin{COMPILER_PLUGIN_ABI_VERSION, LLVM_VERSION_STRING, targetTriple, hostCPU};
+    }();
+    return &plugin;
+}
+
+static_assert(
+    std::is_same_v<decltype(loxCompilerPlugin), CompilerPluginEntry>, "plugin entry must match CompilerPluginEntry"
+);
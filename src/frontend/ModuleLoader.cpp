@@ -0,0 +1,110 @@
+#include "frontend/ModuleLoader.h"
+#include "Lox/ClosureCompiler.h"
+#include "Lox/LoxFunction.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/LoxList.h"
+#include "frontend/Parser.h"
+#include "frontend/Resolver.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+ModuleLoader &ModuleLoader::instance() {
+    static auto *loader = [] {
+        auto *created = new ModuleLoader();
+        // 主线程返回后，全局对象析构之前，等待仍在解析的模块，避免工作线程访问已析构的对象
+        std::atexit([] { instance().pool.wait(); });
+        return created;
+    }();
+    return *loader;
+}
+
+ModuleFuture ModuleLoader::load(const std::filesystem::path &path) {
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(path, ec);
+    std::string key = ec ? path.lexically_normal().string() : canonical.string();
+
+    // 先登记再启动：循环依赖中的模块再次导入自己时会命中缓存，而不是重复加载
+    auto promise = std::make_shared<std::promise<std::shared_ptr<const Module>>>();
+    ModuleFuture future = promise->get_future().share();
+    {
+        std::lock_guard lock(mutex);
+        if (const auto cached = modules.find(key); cached != modules.end()) { return cached->second; }
+        modules.emplace(key, future);
+    }
+    pool.async([this, promise, key = std::move(key)] { promise->set_value(parse(key)); });
+    return future;
+}
+
+void ModuleLoader::loadImports(const std::vector<ImportStmtPtr> &imports, const std::filesystem::path &directory) {
+    for (const auto &stmt: imports) { stmt->module = load(directory / std::filesystem::path(stmt->path)); }
+}
+
+bool ModuleLoader::waitFor(const std::vector<ImportStmtPtr> &imports) {
+    // 模块的导入语句在它的结果就绪之前已经启动加载，沿着导入关系逐个等待即可到达所有间接导入的模块
+    std::unordered_set<const Module *> visited;
+    std::vector<const ImportStmt *> pending;
+    for (const auto &stmt: imports) { pending.push_back(stmt.get()); }
+    bool ok = true;
+    while (!pending.empty()) {
+        const Module *module = pending.back()->module.get().get();
+        pending.pop_back();
+        if (!visited.insert(module).second) { continue; }
+        if (!module->error.empty()) {
+            diagnosticStream() << module->error << "\n";
+            ok = false;
+        }
+        for (const auto &stmt: module->imports) { pending.push_back(stmt.get()); }
+    }
+    return ok;
+}
+
+std::shared_ptr<const Module> ModuleLoader::compile(
+    std::string source, const std::string &name, const std::filesystem::path &directory
+) {
+    auto module = std::make_shared<Module>();
+    module->path = name;
+    build(*module, std::move(source), directory);
+    if (module->error.empty() && !waitFor(module->imports)) { module->error = "Error in imports of '" + name + "'."; }
+    return module;
+}
+
+std::shared_ptr<const Module> ModuleLoader::parse(const std::string &path) {
+    auto module = std::make_shared<Module>();
+    module->path = path;
+
+    const std::ifstream input(path, std::ios_base::binary);
+    if (input.fail()) {
+        module->error = "Cannot open module '" + path + "'.";
+        return module;
+    }
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    build(*module, buffer.str(), std::filesystem::path(path).parent_path());
+    // 函数声明的编译结果写在共享的 AST 中，在结果发布之前完成
+    if (precompile && module->error.empty()) { module->compiled = ClosureCompiler().compile(module->statements); }
+    return module;
+}
+
+void ModuleLoader::build(Module &module, std::string source, const std::filesystem::path &directory) {
+    // 错误标记是线程局部的，清除本线程上一个任务留下的状态
+    hadError = false;
+    module.scanner = std::make_unique<Scanner>(std::move(source));
+
+    Parser parser(module.scanner->scanTokens());
+    try {
+        module.statements = parser.parse();
+    } catch (const ParseError &) { hadError = true; }
+    if (hadError) {
+        module.error = "Error in module '" + module.path + "'.";
+        return;
+    }
+    // 尽早启动下一层导入，与本模块的变量解析并行
+    module.imports = parser.importStatements();
+    loadImports(module.imports, directory);
+
+    Resolver resolver(autoMemoize);
+    resolver.resolve(module.statements);
+    if (hadError) { module.error = "Error in module '" + module.path + "'."; }
+}
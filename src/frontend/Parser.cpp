@@ -165,7 +165,8 @@ Expr Parser::parseBinaryExpr(const std::initializer_list<TokenType> &types, Expr
     while (match(types)) {
         auto token = previous();
         expr = std::make_unique<BinaryExpr>(
-            std::move(expr), token, static_cast<BinaryOp>(token.getType()), std::invoke(f, this)
+            std::move(expr), SourceMap::instance().add(token), static_cast<BinaryOp>(token.getType()),
+            std::invoke(f, this)
         );
     }
 
@@ -184,16 +185,18 @@ Expr Parser::primary() {
 
     if (match({NUMBER, STRING})) { return std::make_unique<LiteralExpr>(previous().getLiteral()); }
 
-    if (match(THIS)) { return std::make_unique<ThisExpr>(previous()); }
+    if (match(INTERPOLATION)) { return interpolation(); }
+
+    if (match(THIS)) { return std::make_unique<ThisExpr>(Identifier(previous())); }
 
     if (match(SUPER)) {
         Token keyword = previous();
         consume(DOT, "Expect '.' after 'super'.");
         Token method = consume(IDENTIFIER, "Expect superclass method name.");
-        return std::make_unique<SuperExpr>(keyword, method);
+        return std::make_unique<SuperExpr>(Identifier(keyword), Identifier(method));
     }
 
-    if (match(IDENTIFIER)) { return std::make_unique<VarExpr>(previous()); }
+    if (match(IDENTIFIER)) { return std::make_unique<VarExpr>(Identifier(previous())); }
 
     if (match(LEFT_PAREN)) {
         auto expr = expression();
@@ -203,6 +206,27 @@ Expr Parser::primary() {
 
     throw error(peek(), "Expect expression.");
 }
+/**
+ * @brief 解析插值字符串
+ * 
+ * 扫描器把插值字符串拆成交替的 INTERPOLATION 段和内嵌表达式的词法单元，最后一段是 STRING。
+ * 调用时第一个 INTERPOLATION 已经被消耗。
+ * 
+ * @return Expr 解析得到的插值字符串表达式
+ */
+Expr Parser::interpolation() {
+    const auto loc = SourceMap::instance().add(previous());
+    std::vector<std::string_view> strings;
+    std::vector<Expr> expressions;
+    do {
+        strings.push_back(std::get<std::string_view>(previous().getLiteral()));
+        expressions.push_back(expression());
+    } while (match(INTERPOLATION));
+    const Token last = consume(STRING, "Expect end of string interpolation.");
+    strings.push_back(std::get<std::string_view>(last.getLiteral()));
+    return std::make_unique<InterpolationExpr>(loc, std::move(strings), std::move(expressions));
+}
+
 /**
  * @brief 完成函数调用表达式的解析
  * 
@@ -231,7 +255,7 @@ Expr Parser::finishCall(Expr &callee) {
     // 消耗右括号，如果没有则报错
     consume(RIGHT_PAREN, "Expect ')' after arguments.");
     // 创建一个 CallExpr 对象表示函数调用，并返回该对象
-    return std::make_unique<CallExpr>(std::move(callee), previous(), std::move(arguments));
+    return std::make_unique<CallExpr>(std::move(callee), SourceMap::instance().add(previous()), std::move(arguments));
 }
 
 /**
@@ -257,7 +281,7 @@ Expr Parser::call() {
             // 消耗属性名标识符，如果没有则报错
             Token name = consume(IDENTIFIER, "Expect property name after '.'.");
             // 创建一个 GetExpr 对象表示属性访问，并更新当前表达式
-            expr = std::make_unique<GetExpr>(std::move(expr), name);
+            expr = std::make_unique<GetExpr>(std::move(expr), Identifier(name));
             // 如果既不是左括号也不是点号，则跳出循环
         } else {
             break;
@@ -289,7 +313,9 @@ Expr Parser::unary() {
     if (match({BANG, MINUS})) {
         const Token token = previous();
         auto right = unary();
-        return std::make_unique<UnaryExpr>(token, static_cast<UnaryOp>(token.getType()), std::move(right));
+        return std::make_unique<UnaryExpr>(
+            SourceMap::instance().add(token), static_cast<UnaryOp>(token.getType()), std::move(right)
+        );
     }
     // 如果不是一元表达式，则解析基本表达式
     //return primary();
@@ -467,6 +493,8 @@ void Parser::synchronize() {
             case FOR:
             case IF:
             case WHILE:
+            case TRY:
+            case IMPORT:
             case PRINT:
             case RETURN:
                 return;
@@ -496,7 +524,7 @@ ClassStmtPtr Parser::classDeclaration() {
         // 消耗父类名标识符，如果没有则报错
         consume(IDENTIFIER, "expect superclass name.");
         // 创建一个变量表达式表示父类
-        superclass = std::make_unique<VarExpr>(previous());
+        superclass = std::make_unique<VarExpr>(Identifier(previous()));
     }
     // 消耗左花括号，如果没有则报错，确保类体开始处有左花括号
     consume(LEFT_BRACE, "Expect '{' before class body.");
@@ -513,7 +541,7 @@ ClassStmtPtr Parser::classDeclaration() {
     consume(RIGHT_BRACE, "Expect '}' after class body.");
 
     // 创建一个类声明语句对象，包含类名、父类和方法列表，并返回其智能指针
-    return std::make_shared<ClassStmt>(name, std::move(superclass), std::move(methods));
+    return std::make_shared<ClassStmt>(Identifier(name), std::move(superclass), std::move(methods));
 }
 
 /**
@@ -533,7 +561,7 @@ VarStmtPtr Parser::varDeclaration() {
     // 消耗分号，如果没有则报错
     consume(SEMICOLON, "expect ';' after variable declaration.");
     // 创建一个变量声明语句并返回其智能指针
-    return std::make_unique<VarStmt>(name, std::move(initializer));
+    return std::make_unique<VarStmt>(Identifier(name), std::move(initializer));
 }
 
 /**
@@ -578,7 +606,7 @@ FunctionStmtPtr Parser::function(LoxFunctionType type) {
     // 消耗左括号，如果没有则报错
     consume(LEFT_PAREN, "expect '(' after" + std::string(kind) + "name");
     // 用于存储函数的参数列表
-    std::vector<Token> parameters;
+    std::vector<Identifier> parameters;
     // 如果当前词法单元不是右括号，则继续解析参数
     if (!check(RIGHT_PAREN)) {
         do {
@@ -588,7 +616,7 @@ FunctionStmtPtr Parser::function(LoxFunctionType type) {
                 error(peek(), "Can't have more than " + std::to_string(MAX_PARAMETERS) + " parameters.");
             }
             // 消耗参数名标识符，如果没有则报错
-            parameters.push_back(consume(IDENTIFIER, "Expect parameter name."));
+            parameters.emplace_back(consume(IDENTIFIER, "Expect parameter name."));
             // 如果有逗号，则继续解析下一个参数
         } while (match(COMMA));
     }
@@ -600,7 +628,7 @@ FunctionStmtPtr Parser::function(LoxFunctionType type) {
     StmtList body = block();
     // 创建一个函数声明语句并返回其智能指针
     return std::make_unique<FunctionStmt>(
-        name,
+        Identifier(name),
         // 如果是方法且函数名是 "init"，则将函数类型设置为构造函数
         type == LoxFunctionType::METHOD && name.getLexeme() == "init" ? LoxFunctionType::INITIALIZER : type,
         parameters, std::move(body)
@@ -631,6 +659,8 @@ std::optional<Stmt> Parser::declaration() {
         // 如果匹配到 FUN 关键字，则调用 function 函数解析函数声明
         return function(LoxFunctionType::FUNCTION);
     }
+    // 模块导入语句
+    if (match(IMPORT)) { return importStatement(); }
 
     // 如果在解析过程中遇到错误
     if (hadError) {
@@ -642,6 +672,25 @@ std::optional<Stmt> Parser::declaration() {
     return std::make_optional<Stmt>(statement());
 }
 
+/**
+ * @brief 解析 import 语句
+ * 
+ * 该函数用于解析 import "path";，路径字符串驻留到 SourceMap 中，
+ * 因此在模块的扫描器和词法单元释放之后仍然有效。
+ * 
+ * @return ImportStmtPtr 解析得到的 import 语句的智能指针
+ */
+ImportStmtPtr Parser::importStatement() {
+    const SourceLoc loc = SourceMap::instance().add(previous());
+    // 消耗模块路径字符串，如果没有则报错
+    const Token path = consume(STRING, "Expect module path string after 'import'.");
+    // 消耗分号，如果没有则报错
+    consume(SEMICOLON, "Expect ';' after module path.");
+    auto stmt = std::make_shared<ImportStmt>(loc, SourceMap::instance().intern(std::get<std::string_view>(path.getLiteral())));
+    imports.push_back(stmt);
+    return stmt;
+}
+
 /**
  * @brief 解析表达式语句
  * 
@@ -679,12 +728,14 @@ PrintStmtPtr Parser::printStatement() {
 /**
  * @brief 解析 for 循环语句
  * 
- * 该函数用于解析 for 循环语句，包括初始化语句、循环条件、循环增量和循环体。
- * 它会将 for 循环转换为 while 循环进行处理。
+ * 该函数用于解析 for 循环语句，包括初始化语句、循环条件、循环增量和循环体，
+ * 并生成一个独立的 ForStmt 节点，不再转换为代码块嵌套 while 循环。
  * 
  * @return Stmt 解析得到的 for 循环语句
  */
 Stmt Parser::forStatement() {
+    // 记录 for 关键字的位置
+    const auto loc = SourceMap::instance().add(previous());
     // 消耗左括号，如果没有则报错
     consume(LEFT_PAREN, "Expect '(' after 'for'.");
 
@@ -718,38 +769,10 @@ Stmt Parser::forStatement() {
     // 解析循环体
     Stmt body = statement();
 
-    // 如果有循环增量，则将循环体和循环增量语句组合成一个代码块
-    if (increment.has_value()) {
-        // 用于存储代码块内的语句
-        StmtList statements;
-        // 将循环体添加到语句列表中
-        statements.push_back(std::move(body));
-        // 创建一个表达式语句表示循环增量，并添加到语句列表中
-        statements.emplace_back(std::make_shared<ExpressionStmt>(std::move(increment.value())));
-        // 创建一个代码块语句对象
-        body = std::make_shared<BlockStmt>(std::move(statements));
-    }
-
-    // 如果没有循环条件，则使用 true 作为默认循环条件
-    if (!condition.has_value()) { condition = std::make_unique<LiteralExpr>(true); }
-
-    // 将循环体和循环条件组合成一个 while 循环语句
-    body = std::make_shared<WhileStmt>(std::move(condition.value()), std::move(body));
-
-    // 如果有初始化语句，则将初始化语句和 while 循环语句组合成一个代码块
-    if (initializer.has_value()) {
-        // 用于存储代码块内的语句
-        StmtList blockStatements;
-        // 将初始化语句添加到语句列表中
-        blockStatements.push_back(std::move(initializer.value()));
-        // 将 while 循环语句添加到语句列表中
-        blockStatements.push_back(std::move(body));
-        // 创建一个代码块语句对象
-        body = std::make_shared<BlockStmt>(std::move(blockStatements));
-    }
-
-    // 返回最终的语句
-    return body;
+    // 创建一个 ForStmt 对象并返回
+    return std::make_shared<ForStmt>(
+        loc, std::move(initializer), std::move(condition), std::move(increment), std::move(body)
+    );
 }
 
 /**
@@ -791,6 +814,8 @@ IfStmtPtr Parser::ifStatement() {
  * @return WhileStmtPtr 解析得到的 while 语句的智能指针
  */
 WhileStmtPtr Parser::whileStatement() {
+    // 记录 while 关键字的位置
+    const auto loc = SourceMap::instance().add(previous());
     // 消耗左括号，如果没有则报错
     consume(LEFT_PAREN, "Expect '(' after 'while'.");
     // 解析条件表达式
@@ -801,7 +826,7 @@ WhileStmtPtr Parser::whileStatement() {
     Stmt body = statement();
 
     // 创建一个 WhileStmt 对象并返回其智能指针
-    return std::make_shared<WhileStmt>(std::move(condition), std::move(body));
+    return std::make_shared<WhileStmt>(loc, std::move(condition), std::move(body));
 }
 
 
@@ -824,8 +849,32 @@ ReturnStmtPtr Parser::returnStatement() {
     // 消耗分号，如果没有则报错
     consume(SEMICOLON, "Expect ';' after return value.");
     // 创建一个返回语句对象并返回其智能指针
-    return std::make_shared<ReturnStmt>(keyword, std::move(value));
+    return std::make_shared<ReturnStmt>(SourceMap::instance().add(keyword), std::move(value));
 }
+/**
+ * @brief 解析 try/catch 语句
+ * 
+ * 该函数依次解析 try 块、catch 关键字、括号中的 catch 变量名和 catch 块。
+ * 
+ * @return TryStmtPtr 解析得到的 try/catch 语句的智能指针
+ */
+TryStmtPtr Parser::tryStatement() {
+    // 消耗左花括号并解析 try 块
+    consume(LEFT_BRACE, "Expect '{' after 'try'.");
+    auto body = block();
+    // 消耗 catch 关键字和左括号
+    consume(CATCH, "Expect 'catch' after try block.");
+    consume(LEFT_PAREN, "Expect '(' after 'catch'.");
+    // 消耗 catch 变量名
+    const Identifier name(consume(IDENTIFIER, "Expect variable name after '('."));
+    consume(RIGHT_PAREN, "Expect ')' after catch variable.");
+    // 消耗左花括号并解析 catch 块
+    consume(LEFT_BRACE, "Expect '{' before catch body.");
+    auto handler = block();
+    // 创建一个 TryStmt 对象并返回其智能指针
+    return std::make_shared<TryStmt>(std::move(body), name, std::move(handler));
+}
+
 /**
  * @brief 解析通用语句
  * 
@@ -845,6 +894,8 @@ Stmt Parser::statement() {
     if (match(FOR)) { return forStatement(); }
     // 如果当前词法单元是 IF，则解析 if 条件语句
     if (match(IF)) { return ifStatement(); }
+    // 如果当前词法单元是 TRY，则解析 try/catch 语句
+    if (match(TRY)) { return tryStatement(); }
     // 如果当前词法单元是左花括号，则解析代码块语句
     if (match(LEFT_BRACE)) { return std::make_shared<BlockStmt>(block()); }
 
@@ -872,6 +923,8 @@ Stmt Parser::statements() {
     if (match(FOR)) { return forStatement(); }
     // 如果当前词法单元是 IF，则解析 if 条件语句
     if (match(IF)) { return ifStatement(); }
+    // 如果当前词法单元是 TRY，则解析 try/catch 语句
+    if (match(TRY)) { return tryStatement(); }
     // 如果当前词法单元是左花括号，则解析代码块语句
     if (match(LEFT_BRACE)) { return std::make_shared<BlockStmt>(block()); }
 
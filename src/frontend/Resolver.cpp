@@ -27,9 +27,9 @@ void Resolver::endScope() {
  * 该函数在当前作用域中声明一个变量。如果当前作用域中已经存在同名变量，则会抛出错误。
  * 声明变量时，会将该变量标记为未定义状态（`false`）。
  * 
- * @param name 变量的 Token 对象
+ * @param name 变量名
  */
-void Resolver::declare(const Token &name) {
+void Resolver::declare(const Identifier &name) {
     // 如果作用域栈为空，直接返回
     if (scopes.empty()) { return; }
     // 获取当前作用域
@@ -49,9 +49,9 @@ void Resolver::declare(const Token &name) {
  * 该函数在当前作用域中定义一个变量，即将该变量标记为已定义状态（`true`）。
  * 如果作用域栈为空，则不进行任何操作。
  * 
- * @param name 变量的 Token 对象
+ * @param name 变量名
  */
-void Resolver::define(const Token &name) {
+void Resolver::define(const Identifier &name) {
     // 如果作用域栈为空，直接返回
     if (scopes.empty()) { return; }
     // 在当前作用域中定义变量，标记为已定义状态
@@ -65,9 +65,9 @@ void Resolver::define(const Token &name) {
  * 直到找到同名变量或到达作用域栈的顶部。如果找到变量，则将其作用域距离赋值给 `expr.distance`。
  * 
  * @param expr 可赋值表达式对象，包含变量的作用域距离信息
- * @param name 变量的 Token 对象
+ * @param name 变量名
  */
-void Resolver::resolveLocal(const Assignable &expr, const Token &name) const {
+void Resolver::resolveLocal(const Assignable &expr, const Identifier &name) const {
     // 如果作用域栈为空，直接返回
     if (scopes.empty()) { return; }
 
@@ -92,6 +92,8 @@ void Resolver::resolveLocal(const Assignable &expr, const Token &name) const {
  * @param functionType 函数的类型
  */
 void Resolver::resolveFunction(const FunctionStmtPtr &function, const LoxFunctionType functionType) {
+    // 每个函数在运行时都会捕获它所在的环境
+    closureCount++;
     // 保存当前函数类型
     const LoxFunctionType enclosingFunction = currentFunction;
     // 设置当前函数类型
@@ -138,10 +140,22 @@ void Resolver::operator()(const BlockStmtPtr &blockStmt) {
  * @param functionStmt 函数声明语句的智能指针
  */
 void Resolver::operator()(const FunctionStmtPtr &functionStmt) {
+    // 嵌套函数会捕获外层变量形成闭包，外层函数不再是纯函数
+    markImpure();
+    // 记录顶层函数名的定义
+    if (scopes.empty()) { defineGlobal(functionStmt->name); }
     // 声明函数名
     declare(functionStmt->name);
     // 定义函数名
     define(functionStmt->name);
+    // 顶层函数在 --auto-memoize 下进行纯度分析
+    if (autoMemoize && scopes.empty()) {
+        analyzing = PurityCandidate{functionStmt, true, {}};
+        resolveFunction(functionStmt, LoxFunctionType::FUNCTION);
+        candidates.push_back(std::move(analyzing.value()));
+        analyzing.reset();
+        return;
+    }
     // 解析函数体
     resolveFunction(functionStmt, LoxFunctionType::FUNCTION);
 }
@@ -166,6 +180,8 @@ void Resolver::operator()(const ExpressionStmtPtr &expressionStmt) {
  * @param printStmt 打印语句的智能指针
  */
 void Resolver::operator()(const PrintStmtPtr &printStmt) {
+    // 打印属于 I/O，包含打印的函数不是纯函数
+    markImpure();
     // 解析打印语句中的表达式
     resolve(printStmt->expression);
 }
@@ -181,11 +197,11 @@ void Resolver::operator()(const ReturnStmtPtr &returnStmt) {
     // 检查是否在顶级代码中使用返回语句
     if (currentFunction == LoxFunctionType::NONE) {
         // 如果是，抛出错误
-        error(returnStmt->keyword, "Can't return from top-level code.");
+        error(returnStmt->loc, "Can't return from top-level code.");
     } else if (returnStmt->expression.has_value() &&
                currentFunction == LoxFunctionType::INITIALIZER) {// 检查是否在构造函数中返回值
         // 如果是，抛出错误
-        error(returnStmt->keyword, "Can't return a value from an initializer.");
+        error(returnStmt->loc, "Can't return a value from an initializer.");
     }
 
     // 解析返回语句中的表达式
@@ -200,6 +216,8 @@ void Resolver::operator()(const ReturnStmtPtr &returnStmt) {
  * @param varStmt 变量声明语句的智能指针
  */
 void Resolver::operator()(const VarStmtPtr &varStmt) {
+    // 记录顶层变量名的定义
+    if (scopes.empty()) { defineGlobal(varStmt->name); }
     // 声明变量
     declare(varStmt->name);
     // 解析变量的初始化表达式
@@ -222,6 +240,57 @@ void Resolver::operator()(const WhileStmtPtr &whileStmt) {
     resolve(whileStmt->body);
 }
 
+/**
+ * @brief 处理 try/catch 语句
+ * 
+ * try 块和 catch 块各自拥有独立的作用域，catch 变量只在 catch 块中可见。
+ * 
+ * @param tryStmt try/catch 语句的智能指针
+ */
+void Resolver::operator()(const TryStmtPtr &tryStmt) {
+    // 解析 try 块
+    beginScope();
+    resolve(tryStmt->body);
+    endScope();
+    // 在 catch 块的作用域中声明并定义 catch 变量，然后解析 catch 块
+    beginScope();
+    declare(tryStmt->name);
+    define(tryStmt->name);
+    resolve(tryStmt->handler);
+    endScope();
+}
+
+/**
+ * @brief 处理 import 语句
+ * 
+ * 被导入的模块由 ModuleLoader 单独解析，它的顶层声明在运行时写入全局环境，
+ * 对当前文件而言都是全局变量，这里不需要做任何事情。
+ * 
+ * @param importStmt import 语句的智能指针
+ */
+void Resolver::operator()(const ImportStmtPtr &) {}
+
+/**
+ * @brief 处理 for 循环语句
+ * 
+ * 初始化语句、条件、循环体和增量共享一个循环作用域。解析循环体前后比较闭包数量，
+ * 记录循环体中是否创建了闭包。
+ * 
+ * @param forStmt for 循环语句的智能指针
+ */
+void Resolver::operator()(const ForStmtPtr &forStmt) {
+    // 循环变量所在的作用域
+    beginScope();
+    if (forStmt->initializer.has_value()) { resolve(forStmt->initializer.value()); }
+    if (forStmt->condition.has_value()) { resolve(forStmt->condition.value()); }
+    // 解析循环体，并判断其中是否创建了闭包
+    const auto closuresBefore = closureCount;
+    resolve(forStmt->body);
+    forStmt->captured = closureCount != closuresBefore;
+    if (forStmt->increment.has_value()) { resolve(forStmt->increment.value()); }
+    endScope();
+}
+
 /**
  * @brief 处理 if 条件语句
  * 
@@ -253,6 +322,10 @@ void Resolver::operator()(const ClassStmtPtr &classStmt) {
     const ClassType enclosingClass = currentClass;
     // 设置当前类的类型为 CLASS
     currentClass = ClassType::CLASS;
+    // 类声明会创建闭包，包含它的函数不是纯函数
+    markImpure();
+    // 记录顶层类名的定义
+    if (scopes.empty()) { defineGlobal(classStmt->name); }
     // 声明类名
     declare(classStmt->name);
     // 定义类名
@@ -320,6 +393,11 @@ void Resolver::operator()(const AssignExprPtr &assignExpr) {
     resolve(assignExpr->value);
     // 解析赋值目标变量的作用域
     resolveLocal(*assignExpr, assignExpr->name);
+    // 对全局变量的写入
+    if (assignExpr->distance == -1) {
+        globalAssignments.insert(assignExpr->name.getLexeme());
+        markImpure();
+    }
 }
 
 /**
@@ -361,6 +439,8 @@ void Resolver::operator()(const CallExprPtr &callExpr) {
  * @param getExpr 属性获取表达式的智能指针
  */
 void Resolver::operator()(const GetExprPtr &getExpr) {
+    // 实例字段可能被修改，读取字段的函数不是纯函数
+    markImpure();
     // 解析属性所属的对象
     resolve(getExpr->object);
 }
@@ -373,6 +453,8 @@ void Resolver::operator()(const GetExprPtr &getExpr) {
  * @param setExpr 属性设置表达式的智能指针
  */
 void Resolver::operator()(const SetExprPtr &setExpr) {
+    // 修改实例字段的函数不是纯函数
+    markImpure();
     // 解析属性所属的对象
     resolve(setExpr->object);
     // 解析要设置的值
@@ -387,7 +469,8 @@ void Resolver::operator()(const SetExprPtr &setExpr) {
  * 
  * @param thisExpr this 表达式的智能指针
  */
-void Resolver::operator()(const ThisExprPtr &thisExpr) const {
+void Resolver::operator()(const ThisExprPtr &thisExpr) {
+    markImpure();
     // 检查是否在类的内部使用 this
     if (currentClass == ClassType::NONE) {
         // 如果不在类内部，抛出错误
@@ -406,7 +489,8 @@ void Resolver::operator()(const ThisExprPtr &thisExpr) const {
  * 
  * @param superExpr super 表达式的智能指针
  */
-void Resolver::operator()(const SuperExprPtr &superExpr) const {
+void Resolver::operator()(const SuperExprPtr &superExpr) {
+    markImpure();
     // 检查是否在类的内部使用 super
     if (currentClass == ClassType::NONE) {
         // 如果不在类内部，抛出错误
@@ -439,6 +523,10 @@ void Resolver::operator()(const VarExprPtr &varExpr) {
     }
     // 解析变量的作用域
     resolveLocal(*varExpr, varExpr->name);
+    // 记录正在分析的函数读取的全局名字
+    if (varExpr->distance == -1 && analyzing.has_value()) {
+        analyzing->globals.push_back(varExpr->name.getLexeme());
+    }
 }
 
 /**
@@ -462,6 +550,17 @@ void Resolver::operator()(const GroupingExprPtr &groupingExpr) {
  */
 void Resolver::operator()(const LiteralExprPtr &) const {}
 
+/**
+ * @brief 处理插值字符串表达式
+ * 
+ * 该函数用于处理插值字符串表达式，依次解析内嵌的每个表达式。
+ * 
+ * @param interpolationExpr 插值字符串表达式的智能指针
+ */
+void Resolver::operator()(const InterpolationExprPtr &interpolationExpr) {
+    for (const auto &expression: interpolationExpr->expressions) { resolve(expression); }
+}
+
 /**
  * @brief 处理逻辑表达式
  * 
@@ -540,4 +639,61 @@ void Resolver::resolve(const Program &program) {
         // 解析每个语句或表达式
         resolve(item);
     }
+    // 顶层程序解析结束后确认纯度分析的结果
+    if (scopes.empty()) { finishMemoization(); }
+}
+
+/**
+ * @brief 记录一个顶层名字的定义
+ *
+ * @param name 顶层名字
+ */
+void Resolver::defineGlobal(const Identifier &name) { globalDefinitions[name.getLexeme()]++; }
+
+/**
+ * @brief 将当前正在分析的函数标记为不纯
+ */
+void Resolver::markImpure() {
+    if (analyzing.has_value()) { analyzing->pure = false; }
+}
+
+/**
+ * @brief 完成纯度分析
+ *
+ * 候选函数只允许读取同样纯的函数名（包括自身递归）。由于候选函数之间可能互相依赖，
+ * 这里反复剔除不满足条件的候选函数，直到结果不再变化。
+ */
+void Resolver::finishMemoization() {
+    if (!autoMemoize) { return; }
+
+    std::unordered_map<std::string_view, bool> pureNames;
+    for (const auto &candidate: candidates) {
+        const auto name = candidate.function->name.getLexeme();
+        // 被重复定义或重新赋值的名字在运行时可能指向别的函数
+        pureNames[name] = candidate.pure && globalDefinitions[name] == 1 && !globalAssignments.contains(name);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto &candidate: candidates) {
+            auto &pure = pureNames[candidate.function->name.getLexeme()];
+            if (!pure) { continue; }
+            for (const auto &global: candidate.globals) {
+                // 读取了普通全局变量、原生函数或不纯的函数
+                if (const auto it = pureNames.find(global); it == pureNames.end() || !it->second) {
+                    pure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    memoized.clear();
+    for (const auto &candidate: candidates) {
+        const auto name = candidate.function->name.getLexeme();
+        candidate.function->memoize = pureNames[name];
+        if (candidate.function->memoize) { memoized.push_back(name); }
+    }
 }
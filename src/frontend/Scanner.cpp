@@ -1,6 +1,8 @@
 #include "frontend/Scanner.h"
 #include "Error/Error.h"
 #include "frontend/Token.h"
+#include <charconv>
+#include <system_error>
 #include <llvm/ADT/StringRef.h>
 #include <optional>
 
@@ -8,7 +10,8 @@
 std::unordered_map<std::string, TokenType> Scanner::keywords = {
     {"and", AND},   {"class", CLASS}, {"else", ELSE}, {"false", FALSE}, {"for", FOR},       {"fun", FUN},
     {"if", IF},     {"nil", NIL},     {"or", OR},     {"print", PRINT}, {"return", RETURN}, {"super", SUPER},
-    {"this", THIS}, {"true", TRUE},   {"var", VAR},   {"while", WHILE}
+    {"this", THIS}, {"true", TRUE},   {"var", VAR},   {"while", WHILE},
+    {"try", TRY},   {"catch", CATCH}, {"import", IMPORT}
 };
 
 /**
@@ -54,7 +57,7 @@ void Scanner::addToken(TokenType type) {
 // }
 void Scanner::addToken(TokenType type, Literal literal) {
     auto lexeme = std::string_view(source).substr(start, current - start);
-    tokens.emplace_back(type, lexeme, literal, line);
+    tokens.emplace_back(type, lexeme, literal, line, start - lineStart + 1);
 }
 /**
  * @brief 检查当前字符是否与预期字符匹配，如果匹配则前进到下一个字符。
@@ -122,16 +125,37 @@ char Scanner::peekNext() {
 /**
  * @brief 处理 Lox 语言中的字符串字面量。
  * 
- * 该函数会持续扫描，直到遇到字符串结束符 '"' 或到达源代码末尾。
+ * 从开头的引号之后开始扫描字符串的第一段，见 stringPart。
+ */
+void Scanner::loxstring() { stringPart(start + 1); }
+
+/**
+ * @brief 扫描字符串的一段，直到字符串结束符 '"' 或插值开始符 "${"。
+ * 
  * 如果在扫描过程中遇到换行符，则更新行号。
+ * 遇到 "${" 时添加一个 INTERPOLATION 词法单元，然后回到普通扫描，直到与之匹配的 '}' 再从这里继续扫描下一段；
+ * 遇到 '"' 时添加 STRING 词法单元作为最后一段。
  * 如果到达末尾仍未找到字符串结束符，则报告错误。
- * 最后，提取字符串内容并添加到词法单元列表中。
+ * 
+ * @param contentStart 这一段内容在源代码中的起始位置。
  */
-void Scanner::loxstring() {
+void Scanner::stringPart(const int contentStart) {
     // 持续扫描，直到遇到字符串结束符 '"' 或到达源代码末尾
     while (peek() != '"' && !isAtEnd()) {
+        // 遇到插值开始符，结束这一段，内嵌的表达式按普通词法单元扫描
+        if (peek() == '$' && peekNext() == '{') {
+            const auto text = std::string_view(source).substr(contentStart, current - contentStart);
+            advance();
+            advance();
+            addToken(INTERPOLATION, text);
+            interpolationBraces.push_back(0);
+            return;
+        }
         // 如果遇到换行符，更新行号
-        if (peek() == '\n') { line++; }
+        if (peek() == '\n') {
+            line++;
+            lineStart = current + 1;
+        }
         // 移动到下一个字符
         advance();
     }
@@ -142,12 +166,8 @@ void Scanner::loxstring() {
     }
     // 移动到字符串结束符之后
     advance();
-    // // 提取字符串内容
-    //Bug在这里，生命周期的坑，这里的字符串是临时的，不能用引用
-    //std::string text = source.substr(start + 1, current - start - 2);
-    // // 添加字符串词法单元
-    //addToken(STRING, text);
-    addToken(STRING, std::string_view(source).substr(start + 1, current - 1 - start - 1));
+    // 字符串内容是源代码的视图，不复制
+    addToken(STRING, std::string_view(source).substr(contentStart, current - 1 - contentStart));
 }
 
 /**
@@ -171,7 +191,9 @@ void Scanner::identifier() {
     while (isAlphaNumeric(peek())) { advance(); }
     std::string text = source.substr(start, current - start);
     //这里写错了
-    TokenType type = keywords.contains(text) ? keywords[text] : IDENTIFIER;
+    // 只读查找：模块在多个线程上并行扫描，不能用可能插入元素的 operator[]
+    const auto keyword = keywords.find(text);
+    TokenType type = keyword != keywords.end() ? keyword->second : IDENTIFIER;
     addToken(type);
 }
 /**
@@ -192,8 +214,13 @@ void Scanner::loxnumber() {
         // 持续扫描小数部分的数字字符
         while (isDigit(peek())) { advance(); }
     }
-    // 提取数字内容并添加数字词法单元
-    addToken(NUMBER, std::stod(source.substr(start, current - start)));
+    // 直接在源码上解析数字，不复制子串，也不受 locale 影响
+    double value = 0;
+    // 超出 double 范围的字面量报告编译错误，而不是悄悄变成 0；仍然添加词法单元，避免后续的解析错误
+    if (std::from_chars(source.data() + start, source.data() + current, value).ec == std::errc::result_out_of_range) {
+        error(line, "Number literal out of range.");
+    }
+    addToken(NUMBER, value);
 }
 /**
  * @brief 扫描源代码并生成词法单元（Token）列表。
@@ -214,7 +241,7 @@ std::vector<Token> Scanner::scanTokens() {
     }
 
     // 添加一个表示文件结束的词法单元
-    tokens.emplace_back(LoxEOF, "", "", line);
+    tokens.emplace_back(LoxEOF, "", "", line, current - lineStart + 1);
     // 返回扫描到的所有词法单元
     return tokens;
 }
@@ -243,11 +270,20 @@ void Scanner::scanToken() {
             break;
         // 处理左花括号
         case '{':
+            // 插值表达式内的花括号需要计数，才能找到结束插值的那个 '}'
+            if (!interpolationBraces.empty()) { interpolationBraces.back()++; }
             // 添加左花括号词法单元
             addToken(LEFT_BRACE);
             break;
         // 处理右花括号
         case '}':
+            // 结束插值表达式的 '}'，继续扫描字符串的下一段
+            if (!interpolationBraces.empty() && interpolationBraces.back() == 0) {
+                interpolationBraces.pop_back();
+                stringPart(current);
+                break;
+            }
+            if (!interpolationBraces.empty()) { interpolationBraces.back()--; }
             // 添加右花括号词法单元
             addToken(RIGHT_BRACE);
             break;
@@ -321,6 +357,7 @@ void Scanner::scanToken() {
         // 处理换行符，行号加 1
         case '\n':
             line++;
+            lineStart = current;
             break;
         // 处理双引号，开始处理字符串
         case '"':
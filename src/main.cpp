@@ -1,17 +1,78 @@
 #include "Lox/Interpreter.h"
 #include "Lox/Lox.h"
+#include "Lox/LoxCallable.h"
+#include "Lox/LoxInstance.h"
+#include "Lox/MemoCache.h"
+#include "Lox/Server.h"
+#include "Utils/HeapAccounting.h"
+#include "Utils/SlabAllocator.h"
+#include "compiler/CompilerPlugin.h"
+#include "frontend/ModuleLoader.h"
 #include "frontend/Parser.h"
 #include "frontend/Resolver.h"
 #include "frontend/Scanner.h"
+#include "frontend/SourceMap.h"
+#include <filesystem>
 #include <iostream>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <thread>
 #include <vector>
 #include <fstream>
 using namespace llvm;
 void printVector(const std::vector<int> &vec) {
     for (int iter: vec) { std::cout << iter << std::endl; }
 }
-cl::opt<std::string> InputFilename(cl::Positional, cl::desc("<input>"), cl::Required);
+cl::list<std::string> InputFilenames(cl::Positional, cl::desc("<input>..."));
+cl::opt<bool> Batch("batch", cl::desc("Run every input script in a fresh interpreter within this process"));
+cl::opt<std::string> Manifest(
+    "manifest", cl::desc("Run the scripts listed one per line in this file (implies --batch)"), cl::value_desc("file")
+);
+cl::opt<bool> AutoMemoize("auto-memoize", cl::desc("Memoize pure recursive functions with a bounded LRU table"));
+cl::opt<ExecutionEngine> Engine(
+    "engine", cl::desc("Execution engine"), cl::init(ExecutionEngine::TREE),
+    cl::values(
+        clEnumValN(ExecutionEngine::TREE, "tree", "Walk the AST directly"),
+        clEnumValN(ExecutionEngine::CLOSURE, "closure", "Compile the AST into pre-bound closures before running")
+    )
+);
+cl::opt<std::uint64_t> MaxInstructions(
+    "max-instructions", cl::desc("Abort after this many loop iterations and calls (0 = unlimited)"), cl::init(0)
+);
+cl::opt<unsigned> MaxHeapMB("max-heap-mb", cl::desc("Abort when the heap allocated by a script (or a --serve request) grows by more than this many MiB (0 = unlimited)"), cl::init(0));
+cl::opt<bool> SlabHugePages("slab-huge-pages", cl::desc("Back the runtime object slab pools with transparent huge pages"));
+cl::opt<unsigned> TimeoutMs("timeout-ms", cl::desc("Abort after this many milliseconds of wall time (0 = unlimited)"), cl::init(0));
+cl::opt<bool> PerfCounters(
+    "perf-counters", cl::desc("Report hardware performance counters for scanning, parsing, resolving and execution")
+);
+cl::opt<bool> PerfFunctions(
+    "perf-functions", cl::desc("Also report performance counters per top-level function (implies --perf-counters)")
+);
+cl::opt<std::string> MetricsOut(
+    "metrics-out", cl::desc("Periodically write runtime metrics to this file, or to unix:<socket>"), cl::value_desc("path")
+);
+cl::opt<unsigned> MetricsInterval(
+    "metrics-interval", cl::desc("Milliseconds between runtime metrics exports"), cl::init(1000)
+);
+cl::opt<MetricsFormat> MetricsFormatOpt(
+    "metrics-format", cl::desc("Runtime metrics format"), cl::init(MetricsFormat::PROMETHEUS),
+    cl::values(
+        clEnumValN(MetricsFormat::PROMETHEUS, "prometheus", "Prometheus text exposition format"),
+        clEnumValN(MetricsFormat::JSON, "json", "One JSON object per export")
+    )
+);
+cl::opt<bool> CodegenInfo("codegen-info", cl::desc("Load the LLVM code generation plugin and print its target"));
+cl::opt<bool> Watch("watch", cl::desc("Reload changed top-level functions and classes into the running script"));
+cl::opt<std::string> Serve(
+    "serve", cl::desc("Serve RUN and CALL requests on this Unix domain socket"), cl::value_desc("socket")
+);
+cl::opt<unsigned> Isolates(
+    "isolates", cl::desc("Number of interpreter threads in serve mode"), cl::init(std::thread::hardware_concurrency())
+);
+cl::list<std::string> Preloads(
+    "preload", cl::desc("Module imported by every interpreter in serve mode"), cl::value_desc("file")
+);
 
 std::string read_string_from_file(const std::string &file_path) {
     const std::ifstream input_stream(file_path, std::ios_base::binary);
@@ -24,30 +85,158 @@ std::string read_string_from_file(const std::string &file_path) {
     return buffer.str();
 }
 
-int main(const int argc, char **argv) {
-    cl::ParseCommandLineOptions(argc, argv);
+void printStats(const Resolver &resolver) {
+    llvm::errs() << "=== lox stats ===\n";
+    llvm::errs() << "memoized functions:";
+    for (const auto &name: resolver.memoizedFunctions()) { llvm::errs() << " " << name; }
+    if (resolver.memoizedFunctions().empty()) { llvm::errs() << " (none)"; }
+    llvm::errs() << "\n";
+    llvm::errs() << "memo hits: " << MemoCache::totalHits << ", misses: " << MemoCache::totalMisses << "\n";
+    SlabPool::printStats(llvm::errs());
+}
 
-    if (InputFilename.empty()) {
-        std::cout << "source must not be empty";
-        return 64;
+// 命令行指定的执行预算；服务模式中是每个请求的预算
+ExecutionLimits commandLineLimits() {
+    ExecutionLimits limits;
+    limits.maxInstructions = MaxInstructions;
+    limits.maxHeapBytes = static_cast<std::size_t>(MaxHeapMB) << 20;
+    limits.timeout = std::chrono::milliseconds(TimeoutMs);
+    return limits;
+}
+
+/**
+ * @brief 在一个新的解释器中运行一个脚本
+ *
+ * 扫描器、解析器、变量解析器和解释器都是局部对象，脚本之间只共享进程级的状态：
+ * 线程局部的 slab 池和 ModuleLoader 的模块缓存（导入的模块在加载线程上解析，位置信息永久保存）。
+ * 脚本自己登记的源码位置和驻留的字符串放在 SourceMap 的段中，脚本结束后释放，批处理的内存不随脚本数增长。
+ *
+ * @param path 脚本路径
+ * @return int 脚本的退出状态：0 成功，65 编译错误，66 无法读取，70 运行时错误
+ */
+int runScript(const std::string &path) {
+    // 段最先构造、最后析构：解释器、AST、记忆化统计和性能计数的输出都在段释放之前完成
+    const SourceMap::Segment segment;
+    // 热重载可能替换任何函数，记忆化的结果会过期，因此 --watch 时不做自动记忆化
+    Lox lox(commandLineLimits(), Engine, AutoMemoize && !Watch);
+    if (Watch) { lox.enableHotReload(); }
+    if (PerfCounters || PerfFunctions) { lox.enablePerfCounters(PerfFunctions); }
+    if (!MetricsOut.empty()) {
+        MetricsOptions options;
+        options.output = MetricsOut;
+        options.interval = std::chrono::milliseconds(std::max(MetricsInterval.getValue(), 1U));
+        options.format = MetricsFormatOpt;
+        lox.enableMetrics(options);
+    }
+    const int status = lox.runFile(path);
+    if (lox.getPerfProfile() != nullptr) {
+        llvm::outs().flush();
+        lox.getPerfProfile()->print(llvm::errs());
     }
 
-    Scanner Scanner(read_string_from_file(InputFilename));
-    const auto &tokens = Scanner.scanTokens();
-    Parser Parser(tokens);
-    const auto &ast = Parser.parse();
-    if (hadError) { return 65; }
+    // --stats 由 LLVM Support 注册，这里复用它的开关；只统计执行过的脚本
+    if ((status == 0 || status == 70) && AreStatisticsEnabled()) { printStats(lox.getResolver()); }
+    return status;
+}
 
-    Resolver resolver;
-    resolver.resolve(ast);
-    if (hadError) { return 65; }
+/**
+ * @brief 读取清单文件：每行一个脚本路径，忽略空行和 # 开头的注释行，相对路径以清单所在目录为基准
+ *
+ * @param manifest 清单文件路径
+ * @param scripts 输出的脚本路径
+ * @return bool 清单是否可以读取
+ */
+bool readManifest(const std::string &manifest, std::vector<std::string> &scripts) {
+    std::ifstream input(manifest);
+    if (input.fail()) { return false; }
+    const auto directory = std::filesystem::path(manifest).parent_path();
+    for (std::string line; std::getline(input, line);) {
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        if (line.empty() || line.front() == '#') { continue; }
+        scripts.push_back((directory / line).string());
+    }
+    return true;
+}
 
+/**
+ * @brief 批处理模式：在同一个进程中依次运行多个脚本，每个脚本使用新的解释器
+ *
+ * 每个脚本的输出之后向标准错误输出一行退出状态和耗时，最后输出汇总。
+ *
+ * @param scripts 脚本路径
+ * @return int 所有脚本中最大的退出状态
+ */
+int runBatch(const std::vector<std::string> &scripts) {
+    using Clock = std::chrono::steady_clock;
+    const auto batchStart = Clock::now();
+    int worst = 0;
+    std::size_t failed = 0;
+    for (const auto &script: scripts) {
+        const auto start = Clock::now();
+        const int status = runScript(script);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        // 先输出脚本自己的输出，再输出状态行
+        llvm::outs().flush();
+        llvm::errs() << script << ": exit " << status << " (" << llvm::format("%.3f", elapsed.count()) << " ms)\n";
+        worst = std::max(worst, status);
+        if (status != 0) { failed++; }
+    }
+    const std::chrono::duration<double, std::milli> total = Clock::now() - batchStart;
+    llvm::errs() << "batch: " << scripts.size() << " scripts, " << failed << " failed ("
+                 << llvm::format("%.3f", total.count()) << " ms)\n";
+    return worst;
+}
 
-    Interpreter Interpreter;
-    Interpreter.evaluate(ast);
+int main(const int argc, char **argv) {
+    cl::ParseCommandLineOptions(argc, argv);
+    // 必须在创建第一个 AST 节点之前设置
+    SlabPool::useHugePages = SlabHugePages;
+    // 必须在启动模块加载线程和隔离区之前设置
+    threadHeapAccounting = MaxHeapMB > 0;
+    ModuleLoader::instance().autoMemoize = AutoMemoize;
+
+    if (CodegenInfo) {
+        // 只有这里会加载插件，运行脚本不会触碰 LLVM 的代码生成库
+        const auto *plugin = loadCompilerPlugin();
+        if (plugin == nullptr) { return 69; }
+        llvm::outs() << "LLVM " << plugin->llvmVersion << ", target " << plugin->targetTriple() << ", cpu "
+                     << plugin->hostCPU() << "\n";
+        return 0;
+    }
 
-    if (hadRuntimeError) { return 70; }
+    if (!Serve.empty()) {
+        ServerOptions options;
+        options.socketPath = Serve;
+        options.isolates = Isolates;
+        options.preloads.assign(Preloads.begin(), Preloads.end());
+        options.limits = commandLineLimits();
+        options.engine = Engine;
+        return serve(options);
+    }
 
+    if (Batch || !Manifest.empty()) {
+        std::vector<std::string> scripts(InputFilenames.begin(), InputFilenames.end());
+        if (!Manifest.empty() && !readManifest(Manifest, scripts)) {
+            llvm::errs() << "Cannot open manifest '" << Manifest << "'.\n";
+            return 66;
+        }
+        return runBatch(scripts);
+    }
 
-    return 0;
+    if (InputFilenames.empty()) {
+        // REPL 中函数可以随时被重新定义，不能在输入完成之前确定哪些函数是纯的，因此不做自动记忆化
+        Lox lox(commandLineLimits(), Engine, false);
+        lox.runPrompt();
+        return 0;
+    }
+    if (InputFilenames.size() > 1) {
+        llvm::errs() << "Usage: lox [options] [script]\n"
+                     << "lox: " << InputFilenames.size() << " scripts given; use --batch to run several scripts\n";
+        return 64;
+    }
+    if (InputFilenames.front().empty()) {
+        llvm::errs() << "lox: source must not be empty\n";
+        return 64;
+    }
+    return runScript(InputFilenames.front());
 }
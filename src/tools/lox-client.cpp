@@ -0,0 +1,184 @@
+#include "Lox/ServerProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <sys/un.h>
+#include <thread>
+#include <vector>
+
+/**
+ * lox --serve 的命令行客户端
+ *
+ *   lox-client <套接字> run <脚本|->                      执行脚本，- 表示从标准输入读取
+ *   lox-client <套接字> call <函数名> [JSON 参数数组]      调用预加载模块中的全局函数
+ *   lox-client <套接字> bench <脚本> <次数> [并发数]       重复执行脚本并统计延迟
+ *
+ * run 和 call 把响应中的输出写到标准输出、错误信息写到标准错误，并以响应状态作为退出状态。
+ */
+
+namespace {
+
+struct Response {
+    int status = 0;
+    std::string output;
+    std::string errors;
+    std::string result;
+};
+
+int connectTo(const std::string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) { return -1; }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return -1; }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 发送一个请求并读取响应；连接出错时返回 false
+bool roundTrip(const int fd, const std::string &header, const std::string &body, Response &response) {
+    const std::string line = header + " " + std::to_string(body.size()) + "\n";
+    if (!writeAll(fd, line.data(), line.size()) || !writeAll(fd, body.data(), body.size())) { return false; }
+    std::string reply;
+    if (!readHeader(fd, reply)) { return false; }
+    std::size_t outLen = 0, errLen = 0, resultLen = 0;
+    if (std::sscanf(reply.c_str(), "%d %zu %zu %zu", &response.status, &outLen, &errLen, &resultLen) != 4) {
+        return false;
+    }
+    response.output.resize(outLen);
+    response.errors.resize(errLen);
+    response.result.resize(resultLen);
+    return readExactly(fd, response.output.data(), outLen) && readExactly(fd, response.errors.data(), errLen) &&
+           readExactly(fd, response.result.data(), resultLen);
+}
+
+bool readSource(const std::string &path, std::string &source) {
+    if (path == "-") {
+        source.assign(std::istreambuf_iterator<char>(std::cin), {});
+        return true;
+    }
+    const std::ifstream input(path, std::ios_base::binary);
+    if (input.fail()) { return false; }
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    source = buffer.str();
+    return true;
+}
+
+int report(const Response &response) {
+    std::cout << response.output;
+    if (!response.result.empty()) { std::cout << response.result << "\n"; }
+    std::cerr << response.errors;
+    return response.status;
+}
+
+/**
+ * @brief 用 concurrency 个连接共执行 count 次脚本，输出吞吐量和延迟分位数
+ */
+int bench(const std::string &socketPath, const std::string &source, const std::size_t count, const unsigned concurrency) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<double>> latencies(concurrency);
+    std::vector<std::size_t> failures(concurrency, 0);
+    std::vector<std::thread> threads;
+    const auto start = Clock::now();
+    for (unsigned t = 0; t < concurrency; t++) {
+        threads.emplace_back([&, t] {
+            const int fd = connectTo(socketPath);
+            for (std::size_t i = t; i < count; i += concurrency) {
+                Response response;
+                const auto sent = Clock::now();
+                if (fd < 0 || !roundTrip(fd, "RUN", source, response)) {
+                    failures[t] += (count - i + concurrency - 1) / concurrency;
+                    break;
+                }
+                if (response.status != 0) { failures[t]++; }
+                latencies[t].push_back(std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+            }
+            if (fd >= 0) { ::close(fd); }
+        });
+    }
+    for (auto &thread: threads) { thread.join(); }
+    const double total = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    std::size_t failed = 0;
+    for (unsigned t = 0; t < concurrency; t++) {
+        all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        failed += failures[t];
+    }
+    if (all.empty()) {
+        std::cerr << "bench: no request completed\n";
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    const auto percentile = [&all](const double p) {
+        return all[std::min(all.size() - 1, static_cast<std::size_t>(p * static_cast<double>(all.size())))];
+    };
+    std::printf(
+        "requests: %zu, failed: %zu, concurrency: %u, %.1f req/s\n"
+        "latency ms: p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+        all.size(), failed, concurrency, static_cast<double>(all.size()) / total, percentile(0.50), percentile(0.90),
+        percentile(0.99), all.back()
+    );
+    return failed == 0 ? 0 : 1;
+}
+
+int usage() {
+    std::cerr << "usage: lox-client <socket> run <file|->\n"
+                 "       lox-client <socket> call <function> [json-array]\n"
+                 "       lox-client <socket> bench <file> <count> [concurrency]\n";
+    return 64;
+}
+
+}// namespace
+
+int main(const int argc, char **argv) {
+    if (argc < 4) { return usage(); }
+    const std::string socketPath = argv[1];
+    const std::string command = argv[2];
+
+    if (command == "bench") {
+        std::string source;
+        if (argc < 5 || !readSource(argv[3], source)) { return usage(); }
+        const auto count = std::stoul(argv[4]);
+        const unsigned concurrency = argc > 5 ? std::max(1UL, std::stoul(argv[5])) : 1;
+        return bench(socketPath, source, count, concurrency);
+    }
+
+    std::string header, body;
+    if (command == "run") {
+        if (!readSource(argv[3], body)) {
+            std::cerr << "Cannot open script '" << argv[3] << "'.\n";
+            return 66;
+        }
+        header = "RUN";
+    } else if (command == "call") {
+        header = std::string("CALL ") + argv[3];
+        body = argc > 4 ? argv[4] : "[]";
+    } else {
+        return usage();
+    }
+
+    const int fd = connectTo(socketPath);
+    if (fd < 0) {
+        std::cerr << "Cannot connect to '" << socketPath << "'.\n";
+        return 69;
+    }
+    Response response;
+    const bool ok = roundTrip(fd, header, body, response);
+    ::close(fd);
+    if (!ok) {
+        std::cerr << "Connection to '" << socketPath << "' failed.\n";
+        return 69;
+    }
+    return report(response);
+}
@@ -4,25 +4,31 @@ set_toolset("cc", "clang")
 set_toolset("cxx", "clang++")
 -- add_requires("llvm")
 -- Enable clang-tidy checks
-before_build(function (target)
-            -- 获取 LLVM 编译和链接标志
-            local llvm_cflags = os.iorun("llvm-config --cxxflags --ldflags --system-libs --libs core mcjit native")  -- 获取 C++ 编译标志
-            local llvm_ldflags = os.iorun("llvm-config --ldflags --system-libs --libs core")  -- 获取链接标志
-            local llvm_libs = os.iorun("llvm-config --libs all")  -- 获取所有必需的库
-            -- Clean up library names by removing duplicate -l prefixes
-            local cleaned_libs = {}
-            for lib in string.gmatch(llvm_libs, "-l(%S+)") do
-                table.insert(cleaned_libs, lib)
+
+-- 静态链接 LLVMSupport 和它依赖的系统库
+rule("llvm.support")
+    before_build(function (target)
+        target:add("linkdirs", os.iorun("llvm-config --libdir"):trim())
+        -- 把 llvm-config 输出的 -lxxx 和库文件路径分别加到目标上
+        for lib in string.gmatch(os.iorun("llvm-config --link-static --libs support --system-libs"), "%S+") do
+            local name = lib:match("^%-l(%S+)")
+            if name then
+                target:add("links", name)
+            else
+                target:add("ldflags", lib, {force = true})
             end
-            -- print("llvm_cflags: " .. llvm_cflags)
-            -- print("llvm_ldflags: " .. llvm_ldflags)
-            --target:add("cxflags", llvm_cflags)  -- 添加 LLVM 编译标志
-            --target:add("ldflags", llvm_ldflags)  -- 添加 LLVM 链接标志
-            target:add("links", cleaned_libs)  -- 添加清理后的 LLVM 库
-            -- 手动指定核心库，尝试先链接核心库
-            -- target:add("links", "LLVMCore", "LLVMSupport", "LLVMBitstreamReader", "LLVMRemarks")  
-            -- 添加需要链接的核心库
-        end)
+        end
+    end)
+rule_end()
+
+-- PGO 构建（xmake f -m pgo && xmake）：插桩构建、运行 examples/pgo 的训练语料、合并剖析数据，
+-- 再以 -fprofile-use 和 ThinLTO 构建 lox。插桩构建更新时会自动重新训练，但新的剖析数据
+-- 不会让没有改动的源文件重新编译，要让所有文件都用上新数据需要 xmake -r
+if is_mode("pgo") then
+    set_optimize("fastest")
+    set_strip("all")
+    add_defines("NDEBUG")
+end
 
 add_rules("plugin.compile_commands.autoupdate", {outputdir = ".vscode"})
 set_languages("c++20")
@@ -50,8 +56,48 @@ target("lox")
     -- add_files("src/Lox/*.cpp")
     -- add_files("src/frontend/*.cpp")
 
-    add_files("src/**/*.cpp") -- 递归添加src目录及其所有子目录下的.cpp文件
+    add_files("src/**/*.cpp|tools/*.cpp|compiler/*.cpp") -- 递归添加src目录及其所有子目录下的.cpp文件，独立工具和代码生成插件除外
     set_languages("c++20")
+    -- 解释器只用到 LLVMSupport（cl、raw_ostream、SmallVector、ThreadPool），静态链接它，
+    -- 启动时不必加载和重定位整个 libLLVM；代码生成插件用 dlopen 按需加载
+    add_rules("llvm.support")
+    add_syslinks("dl")
+    if is_mode("pgo") then
+        -- 先构建插桩的 lox-instrumented 并用它运行训练语料，再用得到的剖析数据编译
+        add_deps("lox-instrumented")
+        set_policy("build.across_targets_in_parallel", false)
+        add_cxflags("-fprofile-use=$(buildir)/pgo/lox.profdata", "-Wno-profile-instr-out-of-date", "-Wno-profile-instr-unprofiled")
+        add_cxflags("-flto=thin")
+        add_ldflags("-flto=thin", "-fuse-ld=lld")
+        before_build(function (target)
+            import("core.project.config")
+            local instrumented = target:dep("lox-instrumented"):targetfile()
+            local corpus = path.join(os.projectdir(), "examples", "pgo")
+            local pgodir = path.absolute(path.join(config.buildir(), "pgo"))
+            local profdata = path.join(pgodir, "lox.profdata")
+
+            -- 插桩的二进制和语料都没有变化时沿用上一次的剖析数据
+            local stale = os.mtime(instrumented) > os.mtime(profdata)
+            for _, file in ipairs(os.files(path.join(corpus, "*"))) do
+                stale = stale or os.mtime(file) > os.mtime(profdata)
+            end
+            if not stale then
+                return
+            end
+
+            -- 两个执行引擎各运行一遍语料，每个进程写一个 .profraw
+            os.mkdir(pgodir)
+            os.tryrm(path.join(pgodir, "*.profraw"))
+            for _, engine in ipairs({"tree", "closure"}) do
+                local log = path.join(pgodir, "training-" .. engine .. ".log")
+                os.execv(instrumented, {"--engine=" .. engine, "--batch", "--manifest", "training.txt"},
+                    {curdir = corpus, stdout = log, stderr = log,
+                     envs = {LLVM_PROFILE_FILE = path.join(pgodir, "lox-%p.profraw")}})
+            end
+            local profiledata = path.join(os.iorun("llvm-config --bindir"):trim(), "llvm-profdata")
+            os.execv(profiledata, table.join({"merge", "-o", profdata}, os.files(path.join(pgodir, "*.profraw"))))
+        end)
+    end
     -- 在编译前运行 clang-tidy 检查
     -- before_build(function (target)
     --     print("Running clang-tidy...")
@@ -86,6 +132,97 @@ target("lox")
     -- end)
 
 
+-- PGO 的插桩构建，与 lox 使用相同的源文件，只在 pgo 模式下存在
+if is_mode("pgo") then
+    target("lox-instrumented")
+        set_kind("binary")
+        set_default(false)
+        add_includedirs("include")
+        add_files("src/**/*.cpp|tools/*.cpp|compiler/*.cpp")
+        set_languages("c++20")
+        add_rules("llvm.support")
+        add_syslinks("dl")
+        add_cxflags("-fprofile-generate")
+        add_ldflags("-fprofile-generate")
+    target_end()
+end
+
+-- LLVM 代码生成插件：src/compiler 下的文件和 LLVM 的代码生成库，lox 需要 JIT 或 AOT 编译时才 dlopen
+target("lox-compiler")
+    set_kind("shared")
+    add_includedirs("include")
+    add_files("src/compiler/*.cpp")
+    set_languages("c++20")
+    before_build(function (target)
+        target:add("linkdirs", os.iorun("llvm-config --libdir"):trim())
+        -- 把 llvm-config 输出的 -lxxx 和库文件路径分别加到目标上
+        for lib in string.gmatch(os.iorun("llvm-config --libs core mcjit native"), "%S+") do
+            local name = lib:match("^%-l(%S+)")
+            if name then
+                target:add("links", name)
+            else
+                target:add("ldflags", lib, {force = true})
+            end
+        end
+    end)
+
+-- lox --serve 的命令行客户端，只依赖 POSIX
+target("lox-client")
+    set_kind("binary")
+    add_includedirs("include")
+    add_files("src/tools/*.cpp")
+    set_languages("c++20")
+
+-- 回归示例（xmake examples）：用两个执行引擎运行 examples 下每个有 .expected 的示例，比较标准输出。
+-- <名字>.lox 作为脚本运行，第一行的 "// flags: ..." 给出额外的命令行参数；没有脚本时 <名字>.input 作为 REPL 的标准输入
+task("examples")
+    set_category("plugin")
+    set_menu({usage = "xmake examples", description = "Run the examples and compare their output with the .expected files.", options = {}})
+    on_run(function ()
+        import("core.project.config")
+        import("core.project.project")
+        config.load()
+        local lox = project.target("lox"):targetfile()
+        local examples = path.join(os.projectdir(), "examples")
+        local outdir = path.absolute(path.join(config.buildir(), "examples"))
+        os.mkdir(outdir)
+        local failed = 0
+        for _, expected in ipairs(os.files(path.join(examples, "*.expected"))) do
+            local name = path.basename(expected)
+            local script = name .. ".lox"
+            local input = nil
+            local flags = {}
+            if os.isfile(path.join(examples, script)) then
+                local extra = io.readfile(path.join(examples, script)):split("\n")[1]:match("^//%s*flags:%s*(.-)%s*$")
+                if extra then
+                    flags = extra:split("%s+")
+                end
+            else
+                script = nil
+                input = path.join(examples, name .. ".input")
+            end
+            for _, engine in ipairs({"tree", "closure"}) do
+                local argv = table.join({"--engine=" .. engine}, flags)
+                if script then
+                    table.insert(argv, script)
+                end
+                local out = path.join(outdir, name .. "-" .. engine .. ".out")
+                os.execv(lox, argv, {curdir = examples, stdin = input, stdout = out,
+                    stderr = path.join(outdir, name .. "-" .. engine .. ".err"), try = true})
+                if io.readfile(out) == io.readfile(expected) then
+                    print("ok      %s (%s)", name, engine)
+                else
+                    print("FAILED  %s (%s): diff %s %s", name, engine, expected, out)
+                    failed = failed + 1
+                end
+            end
+        end
+        if failed > 0 then
+            raise("%d example runs failed", failed)
+        end
+    end)
+task_end()
+
 -- cmake -S llvm -B build -G Ninja  \
 --   -DLLVM_ENABLE_PROJECTS='clang' \
 --   -DLLVM_TARGETS_TO_BUILD="Native;NVPTX" \